@@ -0,0 +1,63 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/** This file declares the pieces shared by the benchmark suites. */
+
+namespace limes::files::benchmarks
+{
+
+using Clock = std::chrono::steady_clock;
+
+/** The settings that every suite is run with. These can be changed from the command line. */
+struct Settings final
+{
+	/** The directory that the suites create their files in. This is created if it doesn't exist, and removed afterwards. */
+	std::filesystem::path workingDirectory;
+
+	/** The number of times each individual operation is timed. */
+	std::size_t numSamples { 200 };
+
+	/** The size of the largest burst of operations. Smaller bursts are also run, starting at 256 operations. */
+	std::size_t maxBurstSize { 4096 };
+};
+
+/** A summary of a set of timings. */
+struct Percentiles final
+{
+	/** Calculates the percentiles of the given timings. */
+	[[nodiscard]] static Percentiles calculate (std::vector<Clock::duration> timings);
+
+	std::size_t numSamples { 0 };
+
+	Clock::duration p50 { 0 }, p99 { 0 }, max { 0 };
+};
+
+/** Formats a duration with units suitable for its size, for example "125 us" or "3.20 ms". */
+[[nodiscard]] std::string formatDuration (Clock::duration duration);
+
+/** Runs the FileWatcher latency and throughput suite.
+	@returns False if a watcher failed to deliver events at all.
+ */
+[[nodiscard]] bool runWatcherSuite (const Settings& settings);
+
+}  // namespace limes::files::benchmarks
@@ -0,0 +1,480 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <lfilesystem/lfilesystem.h>
+#include "Benchmark.h"
+
+namespace limes::files::benchmarks
+{
+
+namespace
+{
+
+namespace fs = std::filesystem;
+
+// each file goes through these stages, and each stage causes exactly one event
+enum Stage : std::size_t
+{
+	Create,
+	Modify,
+	Delete,
+	numStages
+};
+
+constexpr std::array<std::string_view, numStages> stageNames { "create", "modify", "delete" };
+
+/* Records when the events for each file are delivered.
+	File number i is named "f<i>". Events for other files are ignored, as are any events for a file
+	after the ones for all its stages have been delivered.
+ */
+class Probe final
+{
+public:
+	explicit Probe (std::size_t numFilesToTrack)
+		: numFiles (numFilesToTrack), counts (numFiles), deliveryTimes (numFiles * numStages)
+	{
+	}
+
+	// called on the watcher's thread
+	template <typename CharType>
+	void record (std::basic_string_view<CharType> filename) noexcept
+	{
+		const auto now = Clock::now();
+
+		if (filename.size() < 2 || filename.front() != CharType ('f'))
+			return;
+
+		std::size_t index { 0 };
+
+		for (const auto c : filename.substr (1))
+		{
+			if (c < CharType ('0') || c > CharType ('9'))
+				return;
+
+			index = index * 10 + static_cast<std::size_t> (c - CharType ('0'));
+		}
+
+		if (index >= numFiles)
+			return;
+
+		const auto stage = counts[index].fetch_add (1);
+
+		if (stage >= numStages)
+			return;
+
+		deliveryTimes[index * numStages + stage].store (now.time_since_epoch().count());
+
+		numDelivered.fetch_add (1);
+	}
+
+	[[nodiscard]] bool wasDelivered (std::size_t index, Stage stage) const noexcept
+	{
+		return deliveryTimes[index * numStages + stage].load() != 0;
+	}
+
+	[[nodiscard]] Clock::time_point getDeliveryTime (std::size_t index, Stage stage) const noexcept
+	{
+		return Clock::time_point { Clock::duration { deliveryTimes[index * numStages + stage].load() } };
+	}
+
+	[[nodiscard]] std::size_t getNumDelivered() const noexcept
+	{
+		return numDelivered.load();
+	}
+
+private:
+	const std::size_t numFiles;
+
+	std::vector<std::atomic<std::size_t>> counts;
+
+	std::vector<std::atomic<Clock::rep>> deliveryTimes;
+
+	std::atomic<std::size_t> numDelivered { 0 };
+};
+
+/*-------------------------------------------------------------------------------------------------------------------------*/
+
+struct ProbeWatcher final : public FileWatcher
+{
+	ProbeWatcher (const Directory& directory, Probe& probeToUse)
+		: probe (probeToUse)
+	{
+		start (directory, Options {});
+	}
+
+	~ProbeWatcher() final
+	{
+		stop();
+	}
+
+	void fileCreated (const FilesystemEntry& entry) final
+	{
+		record (entry);
+	}
+
+	void fileModified (const FilesystemEntry& entry) final
+	{
+		record (entry);
+	}
+
+	void fileDeleted (const FilesystemEntry& entry) final
+	{
+		record (entry);
+	}
+
+	void record (const FilesystemEntry& entry)
+	{
+		const auto name = entry.getName();
+
+		probe.record (std::string_view { name });
+	}
+
+	Probe& probe;
+};
+
+struct CompactProbeWatcher final : public FileWatcher
+{
+	CompactProbeWatcher (const Directory& directory, Probe& probeToUse)
+		: probe (probeToUse)
+	{
+		start (directory, Options { .compactEvents = true });
+	}
+
+	~CompactProbeWatcher() final
+	{
+		stop();
+	}
+
+	void eventReceived (const Event& event) final
+	{
+		if ((event.events & (Created | Modified | Deleted)) != 0)
+			probe.record (event.name);
+	}
+
+	Probe& probe;
+};
+
+struct Variant final
+{
+	std::string_view name;
+
+	std::function<std::unique_ptr<FileWatcher> (const Directory&, Probe&)> create;
+};
+
+[[nodiscard]] std::unique_ptr<FileWatcher> createSimpleWatcher (const Directory& directory, Probe& probe)
+{
+	return std::make_unique<SimpleFileWatcher> (directory,
+												[&probe] (const FilesystemEntry& entry)
+												{
+		const auto name = entry.getName();
+
+		probe.record (std::string_view { name });
+	});
+}
+
+const std::array<Variant, 3> variants {
+	Variant { "FileWatcher", [] (const Directory& directory, Probe& probe)
+			  { return std::make_unique<ProbeWatcher> (directory, probe); } },
+	Variant { "FileWatcher (compact events)", [] (const Directory& directory, Probe& probe)
+			  { return std::make_unique<CompactProbeWatcher> (directory, probe); } },
+	Variant { "SimpleFileWatcher", createSimpleWatcher }
+};
+
+/*-------------------------------------------------------------------------------------------------------------------------*/
+
+/* Creates the directories and files for one run.
+	Files are created as hard links to a template file outside the watched directory and modified by changing
+	their size, so that creating, modifying and deleting a file each cause exactly one event, with no open
+	or close events in between.
+ */
+class Tree final
+{
+public:
+	Tree (const fs::path& parentDirectory, const fs::path& templateFileToUse)
+		: directory (parentDirectory / ("run" + std::to_string (nextRun++))), templateFile (templateFileToUse)
+	{
+		fs::create_directories (directory);
+	}
+
+	~Tree()
+	{
+		std::error_code ec;
+		fs::remove_all (directory, ec);
+	}
+
+	Tree (const Tree&)			  = delete;
+	Tree& operator= (const Tree&) = delete;
+
+	[[nodiscard]] Directory getDirectory() const
+	{
+		return Directory { directory };
+	}
+
+	void perform (std::size_t index, Stage stage) const
+	{
+		const auto file = directory / ("f" + std::to_string (index));
+
+		switch (stage)
+		{
+			case (Create) : fs::create_hard_link (templateFile, file); return;
+			case (Modify) : fs::resize_file (file, index % 64 + 1); return;
+			default : fs::remove (file); return;
+		}
+	}
+
+private:
+	static inline std::size_t nextRun { 0 };
+
+	const fs::path directory, templateFile;
+};
+
+template <typename Predicate>
+[[nodiscard]] bool waitUntil (Clock::time_point deadline, Predicate&& predicate)
+{
+	while (! predicate())
+	{
+		if (Clock::now() > deadline)
+			return false;
+
+		std::this_thread::sleep_for (std::chrono::microseconds (10));
+	}
+
+	return true;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------*/
+
+// times isolated operations, waiting for each one's event to be delivered before the next one
+[[nodiscard]] bool runLatency (const Variant& variant, const Settings& settings, const fs::path& templateFile)
+{
+	const Tree tree { settings.workingDirectory, templateFile };
+
+	Probe probe { settings.numSamples };
+
+	const auto watcher = variant.create (tree.getDirectory(), probe);
+
+	std::array<std::vector<Clock::duration>, numStages> latencies;
+
+	for (auto i = 0UL; i < settings.numSamples; ++i)
+	{
+		for (auto stage = Create; stage < numStages; stage = static_cast<Stage> (stage + 1))
+		{
+			const auto issued = Clock::now();
+
+			tree.perform (i, stage);
+
+			if (! waitUntil (issued + std::chrono::seconds (2), [&]
+							 { return probe.wasDelivered (i, stage); }))
+			{
+				std::cout << "  The " << stageNames[stage] << " event for file " << i << " was not delivered" << std::endl;
+				return false;
+			}
+
+			latencies[stage].push_back (probe.getDeliveryTime (i, stage) - issued);
+		}
+	}
+
+	std::cout << "  Latency of isolated operations (" << settings.numSamples << " samples each)\n"
+			  << "    " << std::left << std::setw (10) << "operation" << std::right
+			  << std::setw (12) << "p50" << std::setw (12) << "p99" << std::setw (12) << "max" << '\n';
+
+	for (auto stage = 0UL; stage < numStages; ++stage)
+	{
+		const auto stats = Percentiles::calculate (latencies[stage]);
+
+		std::cout << "    " << std::left << std::setw (10) << stageNames[stage] << std::right
+				  << std::setw (12) << formatDuration (stats.p50)
+				  << std::setw (12) << formatDuration (stats.p99)
+				  << std::setw (12) << formatDuration (stats.max) << '\n';
+	}
+
+	std::cout << std::endl;
+
+	return true;
+}
+
+struct BurstResult final
+{
+	std::size_t numEvents { 0 }, numDelivered { 0 };
+
+	Clock::duration elapsed { 0 };
+
+	Percentiles latency;
+
+	[[nodiscard]] double getEventsPerSecond() const
+	{
+		const auto seconds = std::chrono::duration<double> (elapsed).count();
+
+		return seconds > 0. ? static_cast<double> (numDelivered) / seconds : 0.;
+	}
+};
+
+// creates, modifies and deletes a set of files as fast as possible, and measures how quickly the events are delivered
+[[nodiscard]] BurstResult runBurst (const Variant& variant, const fs::path& workingDirectory,
+									const fs::path& templateFile, std::size_t numFiles)
+{
+	const Tree tree { workingDirectory, templateFile };
+
+	Probe probe { numFiles };
+
+	const auto watcher = variant.create (tree.getDirectory(), probe);
+
+	BurstResult result;
+
+	result.numEvents = numFiles * numStages;
+
+	std::vector<Clock::time_point> issued (result.numEvents);
+
+	const auto start = Clock::now();
+
+	for (auto stage = Create; stage < numStages; stage = static_cast<Stage> (stage + 1))
+	{
+		for (auto i = 0UL; i < numFiles; ++i)
+		{
+			issued[i * numStages + stage] = Clock::now();
+			tree.perform (i, stage);
+		}
+	}
+
+	// keep waiting as long as events are still arriving
+	for (auto lastCount = probe.getNumDelivered(); lastCount < result.numEvents;)
+	{
+		const auto madeProgress = waitUntil (Clock::now() + std::chrono::seconds (2), [&]
+											 { return probe.getNumDelivered() != lastCount; });
+
+		if (! madeProgress)
+			break;
+
+		lastCount = probe.getNumDelivered();
+	}
+
+	std::vector<Clock::duration> latencies;
+
+	latencies.reserve (result.numEvents);
+
+	auto lastDelivery = start;
+
+	for (auto i = 0UL; i < numFiles; ++i)
+	{
+		for (auto stage = Create; stage < numStages; stage = static_cast<Stage> (stage + 1))
+		{
+			if (! probe.wasDelivered (i, stage))
+				continue;
+
+			const auto delivered = probe.getDeliveryTime (i, stage);
+
+			latencies.push_back (delivered - issued[i * numStages + stage]);
+
+			lastDelivery = std::max (lastDelivery, delivered);
+		}
+	}
+
+	result.numDelivered = latencies.size();
+	result.elapsed		= lastDelivery - start;
+	result.latency		= Percentiles::calculate (std::move (latencies));
+
+	return result;
+}
+
+[[nodiscard]] bool runThroughput (const Variant& variant, const Settings& settings, const fs::path& templateFile)
+{
+	std::cout << "  Bursts of create, modify and delete operations\n"
+			  << "    " << std::setw (8) << "events" << std::setw (11) << "delivered" << std::setw (12) << "time"
+			  << std::setw (14) << "events/sec" << std::setw (12) << "p50" << std::setw (12) << "p99" << '\n';
+
+	double maxSustainedRate { 0. };
+
+	auto succeeded = true;
+
+	for (auto numFiles = std::min (settings.maxBurstSize, std::size_t { 256 });;
+		 numFiles = std::min (numFiles * 4, settings.maxBurstSize))
+	{
+		const auto result = runBurst (variant, settings.workingDirectory, templateFile, numFiles);
+
+		std::cout << "    " << std::setw (8) << result.numEvents << std::setw (11) << result.numDelivered
+				  << std::setw (12) << formatDuration (result.elapsed)
+				  << std::setw (14) << static_cast<std::uint64_t> (result.getEventsPerSecond())
+				  << std::setw (12) << formatDuration (result.latency.p50)
+				  << std::setw (12) << formatDuration (result.latency.p99) << '\n';
+
+		// a rate only counts as sustained if no events were lost
+		if (result.numDelivered == result.numEvents)
+			maxSustainedRate = std::max (maxSustainedRate, result.getEventsPerSecond());
+
+		if (result.numDelivered == 0)
+			succeeded = false;
+
+		if (numFiles == settings.maxBurstSize)
+			break;
+	}
+
+	std::cout << "  Maximum sustained rate: ";
+
+	if (maxSustainedRate > 0.)
+		std::cout << static_cast<std::uint64_t> (maxSustainedRate) << " events/sec";
+	else
+		std::cout << "n/a (events were lost in every burst)";
+
+	std::cout << '\n'
+			  << std::endl;
+
+	return succeeded;
+}
+
+}  // namespace
+
+bool runWatcherSuite (const Settings& settings)
+{
+	if (! FileWatcher::supportedBySystem())
+	{
+		std::cout << "FileWatcher is not supported on this system, skipping\n"
+				  << std::endl;
+		return true;
+	}
+
+	const auto templateFile = settings.workingDirectory / "template";
+
+	std::ofstream { templateFile } << "lfilesystem";
+
+	auto succeeded = true;
+
+	for (const auto& variant : variants)
+	{
+		std::cout << variant.name << '\n';
+
+		if (! runLatency (variant, settings, templateFile) || ! runThroughput (variant, settings, templateFile))
+			succeeded = false;
+	}
+
+	fs::remove (templateFile);
+
+	return succeeded;
+}
+
+}  // namespace limes::files::benchmarks
@@ -0,0 +1,208 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string_view>
+#include <system_error>
+#include "Benchmark.h"
+
+namespace limes::files::benchmarks
+{
+
+Percentiles Percentiles::calculate (std::vector<Clock::duration> timings)
+{
+	Percentiles result;
+
+	result.numSamples = timings.size();
+
+	if (timings.empty())
+		return result;
+
+	std::sort (timings.begin(), timings.end());
+
+	// nearest-rank percentile
+	const auto percentile = [&timings] (double fraction)
+	{
+		const auto rank = static_cast<std::size_t> (std::ceil (fraction * static_cast<double> (timings.size())));
+
+		return timings[std::clamp (rank, std::size_t { 1 }, timings.size()) - 1];
+	};
+
+	result.p50 = percentile (0.5);
+	result.p99 = percentile (0.99);
+	result.max = timings.back();
+
+	return result;
+}
+
+std::string formatDuration (Clock::duration duration)
+{
+	const auto micros = std::chrono::duration<double, std::micro> (duration).count();
+
+	std::ostringstream stream;
+
+	stream << std::fixed;
+
+	if (micros < 1000.)
+		stream << std::setprecision (0) << micros << " us";
+	else if (micros < 1'000'000.)
+		stream << std::setprecision (2) << micros / 1000. << " ms";
+	else
+		stream << std::setprecision (2) << micros / 1'000'000. << " s";
+
+	return stream.str();
+}
+
+}  // namespace limes::files::benchmarks
+
+namespace
+{
+
+namespace bench = limes::files::benchmarks;
+
+struct Suite final
+{
+	std::string_view							name;
+	std::function<bool (const bench::Settings&)> run;
+};
+
+const Suite suites[] = {
+	{ "watcher", bench::runWatcherSuite }
+};
+
+void printUsage()
+{
+	std::cout << "Usage: lfilesystem_benchmarks [options]\n\n"
+			  << "  --suite <name>       Only run the named suite. Can be given more than once.\n"
+			  << "  --dir <path>         The directory to create files in. Defaults to a new directory in the temp directory.\n"
+			  << "  --samples <n>        The number of times each individual operation is timed.\n"
+			  << "  --max-burst <n>      The size of the largest burst of operations.\n"
+			  << "  --help               Print this message.\n\n"
+			  << "Suites:";
+
+	for (const auto& suite : suites)
+		std::cout << ' ' << suite.name;
+
+	std::cout << std::endl;
+}
+
+[[nodiscard]] std::filesystem::path getDefaultWorkingDirectory()
+{
+	std::random_device device;
+
+	return std::filesystem::temp_directory_path() / ("lfilesystem_benchmarks_" + std::to_string (device()));
+}
+
+}  // namespace
+
+int main (int argc, char** argv)
+{
+	bench::Settings settings;
+
+	std::vector<std::string_view> suitesToRun;
+
+	for (auto i = 1; i < argc; ++i)
+	{
+		const std::string_view arg { argv[i] };
+
+		if (arg == "--help" || arg == "-h")
+		{
+			printUsage();
+			return EXIT_SUCCESS;
+		}
+
+		if (i + 1 == argc)
+		{
+			std::cerr << "Unknown option or missing value: " << arg << std::endl;
+			printUsage();
+			return EXIT_FAILURE;
+		}
+
+		const std::string_view value { argv[++i] };
+
+		if (arg == "--suite")
+			suitesToRun.push_back (value);
+		else if (arg == "--dir")
+			settings.workingDirectory = value;
+		else if (arg == "--samples")
+			settings.numSamples = std::max (std::strtoul (value.data(), nullptr, 10), 1UL);
+		else if (arg == "--max-burst")
+			settings.maxBurstSize = std::max (std::strtoul (value.data(), nullptr, 10), 1UL);
+		else
+		{
+			std::cerr << "Unknown option: " << arg << std::endl;
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (const auto name : suitesToRun)
+	{
+		if (std::none_of (std::begin (suites), std::end (suites), [name] (const Suite& suite)
+						  { return suite.name == name; }))
+		{
+			std::cerr << "Unknown suite: " << name << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (settings.workingDirectory.empty())
+		settings.workingDirectory = getDefaultWorkingDirectory();
+
+	settings.workingDirectory = std::filesystem::absolute (settings.workingDirectory);
+
+	// only remove the working directory afterwards if it was created here
+	const auto createdWorkingDirectory = std::filesystem::create_directories (settings.workingDirectory);
+
+	auto succeeded = true;
+
+	for (const auto& suite : suites)
+	{
+		if (! suitesToRun.empty()
+			&& std::find (suitesToRun.begin(), suitesToRun.end(), suite.name) == suitesToRun.end())
+			continue;
+
+		std::cout << "=== " << suite.name << " ===\n"
+				  << std::endl;
+
+		try
+		{
+			if (! suite.run (settings))
+				succeeded = false;
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "Suite " << suite.name << " failed: " << e.what() << std::endl;
+			succeeded = false;
+		}
+	}
+
+	if (createdWorkingDirectory)
+	{
+		std::error_code ec;
+		std::filesystem::remove_all (settings.workingDirectory, ec);
+	}
+
+	return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
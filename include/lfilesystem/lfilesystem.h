@@ -96,8 +96,6 @@
 
 	@todo FileSearchPath class and/or glob() function
 
-	@todo MemoryMappedFile class
-
 	@todo Android support
 
 	@todo CLI app
@@ -141,9 +139,13 @@
 #include "./lfilesystem_Directory.h"
 #include "./lfilesystem_DynamicLibrary.h"
 #include "./lfilesystem_File.h"
+#include "./lfilesystem_FileAppender.h"
+#include "./lfilesystem_FileInfo.h"
 #include "./lfilesystem_FilesystemEntry.h"
 #include "./lfilesystem_FileWatcher.h"
+#include "./lfilesystem_MemoryMappedFile.h"
 #include "./lfilesystem_Misc.h"
+#include "./lfilesystem_MountWatcher.h"
 #include "./lfilesystem_Paths.h"
 #include "./lfilesystem_Permissions.h"
 #include "./lfilesystem_SimpleWatcher.h"
@@ -20,6 +20,7 @@
 #include <vector>
 #include <memory>
 #include <iterator>
+#include <ranges>
 #include "lfilesystem/lfilesystem_Export.h"
 #include "lfilesystem/lfilesystem_FilesystemEntry.h"
 #include "lfilesystem/lfilesystem_File.h"
@@ -105,19 +106,72 @@ class LFILE_EXPORT Directory final : public FilesystemEntry
 
 	/** Returns true if this %directory contains a child with the specified name.
 
+		This is a single filesystem query for the child's path, so it doesn't depend on the number of
+		children in the directory. Names containing a directory separator, and the names \c . and \c .. ,
+		are never considered children.
+
 		@note This function is not recursive; this only searches this directory's immediate children for a
 		matching filename.
 	 */
 	[[nodiscard]] bool contains (const std::string_view& childName) const;
 
-	/** Returns true if this %directory contains no children. */
+	/** Returns true if this %directory contains no children.
+		This only reads the directory until the first child is found. A %directory that doesn't exist is empty.
+	 */
 	[[nodiscard]] bool isEmpty() const;
 
 	/** Returns the size of this %directory, calculated as the cumulative size of all of this
 		directory's contents, including all subdirectories recursively.
+
+		This returns the \c apparentBytes of \c getDiskUsage() , so files with multiple hard links in
+		this tree are only counted once, and symbolic links count the size of the link itself.
+
+		@see getDiskUsage()
 	 */
 	[[nodiscard]] std::uintmax_t sizeInBytes() const final;
 
+	/** Describes the disk space used by a %directory tree.
+		@see getDiskUsage()
+	 */
+	struct LFILE_EXPORT DiskUsage final
+	{
+		/** The sum of the sizes of all files and symbolic links in the tree, as reported by \c ls . */
+		std::uintmax_t apparentBytes { 0 };
+
+		/** The number of bytes actually allocated on disk for all the entries in the tree, including the
+			%directory itself and its subdirectories, as reported by \c du . This can be smaller than
+			\c apparentBytes for sparse or compressed files, and is usually larger for many small files.
+		 */
+		std::uintmax_t allocatedBytes { 0 };
+
+		/** The number of files (and other non-directory entries, such as symbolic links) in the tree. */
+		std::uintmax_t numFiles { 0 };
+
+		/** The number of subdirectories in the tree, not counting the %directory itself. */
+		std::uintmax_t numDirectories { 0 };
+	};
+
+	/** Calculates the disk space used by this %directory and all its subdirectories, similar to the \c du
+		command.
+
+		The tree is walked once, and each entry is only queried once. Small trees are walked on the calling
+		thread; worker threads are only started once the tree turns out to be large, and then the walk is
+		split across subdirectories.
+		Symbolic links are not followed. A %file with multiple hard links in the tree is only counted
+		once. The space allocated for the %directory itself is included in \c allocatedBytes , but the
+		%directory isn't counted in \c numDirectories .
+
+		@param stayOnFilesystem If true, subdirectories that are on a different filesystem from this
+		%directory -- that is, mount points -- are skipped, like \c du \c -x .
+		@param numThreads The maximum number of threads to use. If this is 0, the number of hardware threads is used.
+
+		@note On Windows, hard links are not detected, \c stayOnFilesystem has no effect, and \c allocatedBytes
+		is the same as \c apparentBytes .
+
+		@see sizeInBytes()
+	 */
+	[[nodiscard]] DiskUsage getDiskUsage (bool stayOnFilesystem = false, std::size_t numThreads = 0) const;
+
 	[[nodiscard]] bool isDirectory() const noexcept final;
 	[[nodiscard]] bool isFile() const noexcept final;
 	[[nodiscard]] bool isSymLink() const noexcept final;
@@ -153,11 +207,14 @@ class LFILE_EXPORT Directory final : public FilesystemEntry
 	[[nodiscard]] File getChildFile (const std::string_view& filename, bool createIfNeeded = false) const;
 
 	/** Returns all child files that exist in this %directory.
+		The returned entries are sorted, with files before directories.
 		@see iterateFiles()
 	 */
 	[[nodiscard]] std::vector<File> getChildFiles (bool recurse = true, bool includeHiddenFiles = true) const;
 
 	/** Calls a function for each child %file that exists in this %directory.
+		The %directory is read lazily, so the callback is called as soon as each entry is found,
+		and entries are visited in an unspecified order.
 		@see getChildFiles()
 		@todo test coverage
 	 */
@@ -177,11 +234,14 @@ class LFILE_EXPORT Directory final : public FilesystemEntry
 	[[nodiscard]] Directory getChildDirectory (const std::string_view& subdirectoryName, bool createIfNeeded = false) const;
 
 	/** Returns all child directories that exist in this %directory.
+		The returned entries are sorted, with files before directories.
 		@see iterateDirectories()
 	 */
 	[[nodiscard]] std::vector<Directory> getChildDirectories (bool recurse = true, bool includeHiddenFiles = true) const;
 
 	/** Calls a function for each child %directory that exists in this %directory.
+		The %directory is read lazily, so the callback is called as soon as each entry is found,
+		and entries are visited in an unspecified order.
 		@see getChildDirectories()
 		@todo test coverage
 	 */
@@ -203,11 +263,14 @@ class LFILE_EXPORT Directory final : public FilesystemEntry
 											  const FilesystemEntry&  symLinkTarget) const;
 
 	/** Returns all child symbolic links that exist in this %directory.
+		The returned entries are sorted, with files before directories.
 		@see iterateSymLinks()
 	 */
 	[[nodiscard]] std::vector<SymLink> getChildSymLinks (bool recurse = true, bool includeHiddenFiles = true) const;
 
 	/** Calls a function for each child symbolic link that exists in this %directory.
+		The %directory is read lazily, so the callback is called as soon as each entry is found,
+		and entries are visited in an unspecified order.
 		@see getChildSymLinks()
 		@todo test coverage
 	 */
@@ -224,12 +287,15 @@ class LFILE_EXPORT Directory final : public FilesystemEntry
 	[[nodiscard]] FilesystemEntry getChild (const std::string_view& childName, bool createIfNeeded = false) const;
 
 	/** Returns all child filesystem entries that exist in this %directory.
-		@see iterateAllChildren(), getChild()
+		The returned entries are sorted, with files before directories.
+		@see iterateAllChildren(), getChild(), stream()
 	 */
 	[[nodiscard]] std::vector<FilesystemEntry> getAllChildren (bool recurse = true, bool includeHiddenFiles = true) const;
 
 	/** Iterates through all child objects of this %directory, calling different callbacks for each object depending on
 		if it is a %file, %directory, or symbolic link. It is not an error for any of these callbacks to be \c nullptr .
+		The %directory is read lazily, so the callback is called as soon as each entry is found,
+		and entries are visited in an unspecified order.
 		@see getAllChildren()
 		@todo test coverage
 	 */
@@ -240,6 +306,8 @@ class LFILE_EXPORT Directory final : public FilesystemEntry
 							 bool				 includeHiddenFiles = true) const;
 
 	/** Iterates through all child objects of this %directory, calling a single type-erased callback for each one.
+		The %directory is read lazily, so the callback is called as soon as each entry is found,
+		and entries are visited in an unspecified order.
 		@see getAllChildren()
 		@todo test coverage
 	 */
@@ -247,6 +315,29 @@ class LFILE_EXPORT Directory final : public FilesystemEntry
 							 bool					   recurse			  = true,
 							 bool					   includeHiddenFiles = true) const;
 
+	/** Walks this %directory and all of its subdirectories using multiple threads, calling the callback for each
+		entry found.
+
+		Each subdirectory is read by a separate task on a work-stealing thread pool, so this can be much faster than
+		\c iterateAllChildren() when walking a tree is bound by filesystem latency, as it is on fast SSDs and on
+		network filesystems. The first thousand or so entries are visited on the calling thread, so walking a small
+		tree doesn't start any threads.
+
+		The callback is called concurrently from the worker threads, so it must be thread-safe. Entries are visited
+		in an unspecified order. Symbolic links to directories are not followed. This function returns once the
+		whole tree has been walked.
+
+		@param numThreads The number of threads to use. If this is 0, the number of hardware threads is used.
+
+		@throws If the callback throws an exception, the walk is stopped and the exception is rethrown from this
+		function.
+
+		@see iterateAllChildren(), stream()
+	 */
+	void iterateAllChildrenInParallel (const FilesystemEntryCallback& callback,
+									   bool							  includeHiddenFiles = true,
+									   std::size_t					  numThreads		 = 0) const;
+
 	///@}
 
 	/** An iterator class that allows iterating a directory like a standard C++ container.
@@ -298,6 +389,170 @@ class LFILE_EXPORT Directory final : public FilesystemEntry
 	/** Returns an iterator to the last entry in this directory. */
 	[[nodiscard]] Iterator end() const;
 
+	/** A lazy range over the children of a %directory.
+
+		Unlike \c getAllChildren() or \c begin() , a stream does not collect or sort the directory's
+		children up front; entries are read from the OS one at a time as the iterator is advanced. The
+		first entry is available immediately even for directories with millions of children, breaking out
+		of the loop early skips reading the rest of the directory, and memory use only grows with the depth
+		of the tree being walked, not with the number of entries in it.
+
+		Entries are returned in the order the OS reports them, which is unspecified. If you need them in a
+		particular order, collect them and sort them yourself, or use \c getAllChildren() .
+
+		Symbolic links to directories are not followed when recursing, and subdirectories that cannot be
+		opened because of insufficient permissions are skipped. If any other error occurs while reading
+		the directory, the stream ends early.
+
+		Each call to \c begin() starts a new walk of the directory. The iterators are single-pass input
+		iterators, and the end of the stream is represented by \c std::default_sentinel , so streams can be
+		used with range-based for loops and with C++20 ranges algorithms and views:
+		@code{.cpp}
+		const limes::files::Directory dir { "/var/spool/huge" };
+
+		for (const auto& entry : dir.stream())
+		{
+			if (entry.getName() == "needle.txt")
+				break;
+		}
+		@endcode
+
+		@see stream()
+	 */
+	class LFILE_EXPORT Stream final : public std::ranges::view_interface<Stream>
+	{
+		struct State;
+
+	public:
+		/** The iterator type for directory streams. */
+		struct LFILE_EXPORT Iterator final
+		{
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using iterator_concept	= std::input_iterator_tag;
+			using value_type		= FilesystemEntry;
+			using difference_type	= std::ptrdiff_t;
+			using pointer			= const FilesystemEntry*;
+			using reference			= const FilesystemEntry&;
+
+			Iterator& operator++();
+			void	  operator++ (int);
+
+			/** Returns true if this iterator has reached the end of the stream. */
+			[[nodiscard]] bool operator== (std::default_sentinel_t) const noexcept;
+
+			reference operator*() const;
+			pointer	  operator->() const;
+
+			explicit Iterator();
+
+			Iterator (const Iterator&) = default;
+			Iterator& operator= (const Iterator&) = default;
+
+			Iterator (Iterator&&) = default;
+			Iterator& operator= (Iterator&&) = default;
+
+		private:
+			explicit Iterator (const Stream& stream);
+
+			std::shared_ptr<State> state { nullptr };
+
+			friend class Stream;
+		};
+
+		/** Starts reading the directory, and returns an iterator to the first entry found. */
+		[[nodiscard]] Iterator begin() const;
+
+		/** Returns a sentinel representing the end of the stream. */
+		[[nodiscard]] std::default_sentinel_t end() const noexcept;
+
+	private:
+		Stream (const Path& directory, bool recurse, bool includeHiddenFiles);
+
+		Path path;
+
+		bool recursive { true }, includeHidden { true };
+
+		friend class Directory;
+	};
+
+	/** Returns a lazy range over the children of this %directory.
+		See the documentation for the Stream class for details.
+		@see getAllChildren()
+	 */
+	[[nodiscard]] Stream stream (bool recurse = true, bool includeHiddenFiles = true) const;
+
+	/** @name Copying trees */
+	///@{
+
+	/** Describes the progress of a tree copy.
+		@see copyTree()
+	 */
+	struct LFILE_EXPORT CopyProgress final
+	{
+		/** The number of files found in the source tree so far, including symbolic links. */
+		std::uintmax_t numFilesFound { 0 };
+
+		/** The total size of the files found in the source tree so far. */
+		std::uintmax_t bytesFound { 0 };
+
+		/** The number of files that have been copied. */
+		std::uintmax_t numFilesCopied { 0 };
+
+		/** The total size of the files that have been copied. */
+		std::uintmax_t bytesCopied { 0 };
+
+		/** The number of files that weren't copied because the destination was already up to date. */
+		std::uintmax_t numFilesSkipped { 0 };
+
+		/** The number of entries that couldn't be copied. */
+		std::uintmax_t numErrors { 0 };
+
+		/** The source tree is read while it is being copied, so the numbers of files and bytes found keep
+			growing until this is true.
+		 */
+		bool scanComplete { false };
+	};
+
+	/** A function that receives the progress of a tree copy. */
+	using CopyProgressCallback = std::function<void (const CopyProgress&)>;
+
+	/** Copies this %directory and everything below it to a new location, in parallel.
+
+		The copy is made in three overlapping phases. As the source tree is walked, each subdirectory is created
+		in the destination as soon as it's found, and the files in it are queued for copying on a pool of worker
+		threads. Each %file is copied with \c File::copyContentsTo() , so the OS can clone it or copy it in the
+		kernel, and is given the permissions and modification time of the original. Finally, once all the files
+		have been copied, the permissions and modification times of the directories are applied, deepest first,
+		in parallel batches. (Applying them any earlier would be undone by creating the entries inside them.)
+
+		Symbolic links are copied as links, and are not followed. Other special files, such as FIFOs, are skipped.
+		If an entry can't be copied, the error is counted and the copy continues with the other entries.
+
+		@param dest The %directory to copy to. This is created if it doesn't exist. A relative path is interpreted
+		relative to this %directory's parent.
+		@param options Controls what happens to files that already exist in the destination:
+		- If \c update_existing is set, existing files with the same size and modification time as the source
+		  are assumed to be unchanged and are skipped, and all other existing files are replaced. This makes
+		  repeated copies of a large tree to the same destination cheap.
+		- If \c overwrite_existing is set, existing files are always replaced.
+		- If \c skip_existing is set, existing files are never replaced.
+		- Otherwise, an existing %file is counted as an error.
+		@param progressCallback If not null, this is called periodically with the progress of the copy, and
+		once more at the end. Calls are made from the worker threads, but never concurrently.
+		@param numThreads The number of threads to use. If this is 0, the number of hardware threads is used.
+
+		@returns The final progress of the copy. Everything was copied successfully if \c numErrors is 0.
+
+		@see FilesystemEntry::copyTo()
+	 */
+	CopyProgress copyTree (const Path&				   dest,
+						   CopyOptions				   options			= CopyOptions::update_existing,
+						   const CopyProgressCallback& progressCallback = nullptr,
+						   std::size_t				   numThreads		= 0) const noexcept;
+
+	///@}
+
 	/** @name The current working %directory */
 	///@{
 
@@ -156,17 +156,24 @@ class LFILE_EXPORT DynamicLibrary final
 		If the file is deleted, this calls \c DynamicLibrary::close() , and if the file is modified, this calls
 		\c DynamicLibrary::reload() .
 
+		The events for the library file are coalesced, so that rebuilding the library -- which usually causes
+		several modification events, and may delete and recreate the file -- only reloads it once.
+
 		@see DynamicLibrary::reload()
 	 */
 	class LFILE_EXPORT Reloader final : public FileWatcher
 	{
 	public:
-		/** Creates a Reloader object watching the specified library. */
+		/** Creates a Reloader object watching the specified library.
+			@throws std::runtime_error An exception is thrown if the library's file can't be watched.
+		 */
 		explicit Reloader (DynamicLibrary& libraryToReload);
 
+		/** Destructor. */
+		~Reloader() final;
+
 	private:
-		void fileDeleted (const FilesystemEntry&) final;
-		void fileModified (const FilesystemEntry&) final;
+		void changesDetected (const std::vector<Change>& changes) final;
 
 		DynamicLibrary& library;
 	};
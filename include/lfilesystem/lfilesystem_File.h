@@ -69,6 +69,39 @@ class LFILE_EXPORT File : public FilesystemEntry
 	File (File&&) = default;
 	File& operator= (File&&) = default;
 
+	/** The methods that can be used to copy a file's content.
+		@see copyContentsTo()
+	 */
+	enum class CopyStrategy
+	{
+		/** The copy shares its data blocks with the original until either of them is modified.
+			This is only possible on filesystems that support reflinks, such as Btrfs and XFS,
+			and is almost instantaneous no matter how large the file is.
+		 */
+		Clone,
+
+		/** The kernel copied the data with \c copy_file_range() . Some filesystems and network
+			filesystems implement this without transferring the data at all.
+		 */
+		CopyFileRange,
+
+		/** The kernel copied the data with \c sendfile() , without it passing through user space. */
+		SendFile,
+
+		/** The data was read into a buffer and written out again. */
+		Buffered,
+
+		/** The copy was made by the standard library, which may use an OS-specific method such as
+			\c fcopyfile() or \c CopyFileW() . This is the strategy used on systems other than Linux.
+		 */
+		System,
+
+		/** No data was copied, because the destination already existed and the copy options
+			specified that it should be kept.
+		 */
+		Skipped
+	};
+
 	/** @name Path queries */
 	///@{
 
@@ -144,6 +177,12 @@ class LFILE_EXPORT File : public FilesystemEntry
 	///@{
 
 	/** Loads the file's contents as a string.
+
+		The file is read, not mapped, so this is safe to call on a file that another process may truncate
+		while it's being read. Use a \c MemoryMappedFile to access a file's contents without copying them.
+
+		The file is read in text mode, so on Windows, \c \\r\\n line endings are returned as \c \\n .
+
 		@see loadAsLines()
 	 */
 	[[nodiscard]] std::string loadAsString() const noexcept;
@@ -170,6 +209,55 @@ class LFILE_EXPORT File : public FilesystemEntry
 	bool overwrite (const char* const data, std::size_t numBytes) const noexcept;
 	bool overwrite (const std::string_view& text) const noexcept;
 
+	/** How much effort \c overwriteAtomically() makes to ensure that the new content survives a crash or power failure.
+		Each level includes the guarantees of the ones before it.
+	 */
+	enum class Durability
+	{
+		/** The replacement is atomic for other processes: they see either the old content or the new content,
+			never a mixture or a partially written file. Nothing is flushed to disk, so after a power failure the
+			file may have its old content, and on some filesystems it may be empty.
+		 */
+		None,
+
+		/** The new content is flushed to disk with \c fdatasync() before it replaces the old content, so after
+			a power failure the file has either its old content or its new content. The replacement itself may
+			not have reached the disk yet when this function returns, so the old content may reappear after a
+			crash.
+		 */
+		Data,
+
+		/** The %directory containing the file is also flushed to disk after the replacement, so once this
+			function returns, the new content is guaranteed to survive a crash. This is the slowest option.
+		 */
+		Full
+	};
+
+	/** Replaces the file's contents with the given data, atomically.
+
+		Unlike \c overwrite() , which truncates the file and writes into it in place, this writes the data to a
+		temporary file in the same %directory, then renames it over this file. Other processes therefore never
+		see a truncated or partially written file, and a crash while writing leaves the old content in place.
+
+		The temporary file is a hidden file named after this one, which is renamed over this file once it's
+		complete. On Linux, where the filesystem supports \c O_TMPFILE , the data is written to an unnamed file,
+		which is only linked to the temporary name just before the rename, so a crash while writing can't leave a
+		partial file behind. A crash between the link and the rename can still leave the complete temporary file
+		in the %directory.
+
+		If the file already exists, the new file is given its permissions. If this path is a symbolic link, the
+		link's target is replaced, and the link is kept. Unlike \c overwrite() , writing 0 bytes leaves an empty
+		file, rather than deleting it.
+
+		@param durability How much effort to make to ensure that the new content survives a crash or power failure.
+
+		@returns True if the file was replaced.
+
+		@see Durability
+	 */
+	bool overwriteAtomically (const char* const data, std::size_t numBytes, Durability durability = Durability::Data) const noexcept;
+	bool overwriteAtomically (const std::string_view& text, Durability durability = Durability::Data) const noexcept;
+
 	/** Returns a standard output stream for writing to this file.
 		@see getInputStream()
 		@todo test coverage
@@ -184,9 +272,11 @@ class LFILE_EXPORT File : public FilesystemEntry
 
 		For best performance, if you need to append multiple pieces of data to a file, you should prefer to load its previous
 		content, make all your alterations, and use one of the \c overwrite() methods. Calling this function repeatedly is
-		unnecessarily expensive.
+		unnecessarily expensive. To append many small pieces of data as they are produced, use a FileAppender, which keeps
+		the file open and batches the writes.
 
 		@returns True if writing the data was successful
+		@see FileAppender
 	 */
 	bool append (const char* const data, std::size_t numBytes) const noexcept;
 	bool append (const std::string_view& text) const noexcept;
@@ -277,6 +367,24 @@ class LFILE_EXPORT File : public FilesystemEntry
 	 */
 	std::optional<File> duplicate() const noexcept;
 
+	/** Copies this file's content and permissions to another file, using the fastest method that the OS and filesystem support.
+
+		On Linux, this first tries to make a reflink clone of the file, which shares the data blocks of the original.
+		If the filesystem can't do that, the data is copied by the kernel with \c copy_file_range() or \c sendfile() ,
+		and if neither of those works, through a large buffer. Holes in sparse files are preserved: only the regions
+		that contain data are copied, and the holes are recreated in the copy. On other systems, the copy is made
+		with \c std::filesystem::copy_file() .
+
+		\c copyTo() , \c copyFrom() and \c duplicate() also use this method when copying a regular file.
+
+		@param dest The file to copy to. If this is an existing %directory, the copy is created inside it with
+		the same filename as this file. A relative path is interpreted relative to this file's %directory.
+		@param options Controls what happens if the destination already exists, as with \c std::filesystem::copy_file() .
+
+		@returns The strategy that was used to copy the data, or a \c nullopt if copying failed.
+	 */
+	std::optional<CopyStrategy> copyContentsTo (const Path& dest, CopyOptions options = CopyOptions::update_existing) const noexcept;
+
 	/** Returns a CFile referring to this filepath.
 		When the CFile constructor is called, a %file handle for this %file will be opened. This will return an invalid CFile object
 		if the %file does not exist.
@@ -286,24 +394,44 @@ class LFILE_EXPORT File : public FilesystemEntry
 
 	/** An iterator class that allows iterating a file like a standard C++ container.
 		The iterator will advance through the file line-by-line.
-		The file class will create an array of all its lines when you call \c begin() ;
-		the iterator will advance through this array as you increment it.
+
+		This is a single-pass input iterator that streams the file's content through a fixed-size buffer,
+		so memory usage stays constant no matter how large the file is, and advancing the iterator does
+		not allocate (unless a single line is longer than the internal buffer, in which case the buffer
+		is grown to fit it). Each line is returned as a \c std::string_view into this internal buffer, so
+		the returned view is only valid until the iterator is incremented -- copy the line into a
+		\c std::string if you need to keep it.
+
+		Lines are split at \c \\n characters, and a trailing \c \\r is removed from each line. Empty
+		lines are included. A newline at the very end of the file does not produce an extra empty line.
+
+		The end of the file is represented by \c std::default_sentinel , so this class can be used with
+		range-based for loops and with C++20 ranges:
+		@code{.cpp}
+		const limes::files::File file { "/my/huge/log.txt" };
+
+		for (const auto line : file)
+			if (line.starts_with ("ERROR"))
+				std::cout << line << std::endl;
+		@endcode
 
 		@see begin(), end()
 	 */
 	struct LFILE_EXPORT Iterator final
 	{
 	public:
-		using iterator_category = std::forward_iterator_tag;
-		using value_type		= std::string;
+		using iterator_category = std::input_iterator_tag;
+		using iterator_concept	= std::input_iterator_tag;
+		using value_type		= std::string_view;
 		using difference_type	= std::ptrdiff_t;
-		using pointer			= std::string*;
-		using reference			= std::string&;
+		using pointer			= const std::string_view*;
+		using reference			= const std::string_view&;
+
+		Iterator& operator++();
+		void	  operator++ (int);
 
-		Iterator&			   operator++();
-		[[nodiscard]] Iterator operator++ (int);
-		bool				   operator== (Iterator other);
-		bool				   operator!= (Iterator other);
+		/** Returns true if this iterator has reached the end of the file. */
+		[[nodiscard]] bool operator== (std::default_sentinel_t) const noexcept;
 
 		reference operator*() const;
 		pointer	  operator->() const;
@@ -317,22 +445,22 @@ class LFILE_EXPORT File : public FilesystemEntry
 		Iterator& operator= (Iterator&&) = default;
 
 	private:
-		using VectorType = std::vector<std::string>;
+		struct State;
 
-		explicit Iterator (VectorType&& v);
+		explicit Iterator (const Path& path);
 
-		std::shared_ptr<VectorType> lines { nullptr };
-
-		VectorType::size_type idx { 0UL };
+		std::shared_ptr<State> state { nullptr };
 
 		friend class File;
 	};
 
-	/** Returns an iterator to the first line in this file. */
+	/** Returns an iterator to the first line in this file.
+		This opens the file; the file is closed again when the last copy of the returned iterator is destroyed.
+	 */
 	[[nodiscard]] Iterator begin() const;
 
-	/** Returns an iterator to the last line in this file. */
-	[[nodiscard]] Iterator end() const;
+	/** Returns a sentinel representing the end of this file. */
+	[[nodiscard]] std::default_sentinel_t end() const noexcept;
 
 	/** Returns a file representing the location of the executable %file that launched the current process.
 		If the calling code is an audio plugin, this will return the path to the DAW it's being run in.
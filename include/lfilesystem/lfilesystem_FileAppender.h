@@ -0,0 +1,168 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>	// for size_t
+#include <memory>
+#include <string_view>
+#include "lfilesystem/lfilesystem_Export.h"
+#include "lfilesystem/lfilesystem_FilesystemEntry.h"	// for Path
+
+/** @file
+	This file defines the FileAppender class.
+
+	@ingroup limes_files
+ */
+
+namespace limes::files
+{
+
+/** Appends data to a %file that is kept open, batching small writes together.
+
+	\c File::append() opens the %file, writes the data and closes the %file again every time it is called,
+	which dominates the cost of appending many small records. A FileAppender opens the %file once, in append
+	mode, and collects appended data in memory until a buffer fills up, the flush interval elapses, or
+	\c flush() is called. All the buffered data is then written with a single gathering write.
+
+	A FileAppender can be used from several threads at once. Each thread appends to its own buffer, so
+	appending threads don't contend with each other; a flush collects the buffers of all the threads and
+	writes them together. The data appended by each thread is written in the order it was appended, and
+	each call to \c append() is written contiguously, but the data from different threads may be interleaved
+	in any order. When a thread that has appended exits, its buffered data is written and its buffer is freed,
+	so appending from short-lived threads, such as those of a thread pool, doesn't accumulate buffers.
+
+	For example:
+	@code{.cpp}
+	limes::files::FileAppender journal { "/path/to/journal.log",
+										 { .bufferSize = 256 * 1024, .flushInterval = std::chrono::milliseconds { 50 } } };
+
+	for (const auto& record : records)
+		journal.append (record.serialize());
+
+	journal.flush();
+	@endcode
+
+	@note Buffered data is lost if the process crashes before it is flushed. The destructor flushes any
+	buffered data.
+
+	@ingroup limes_files
+	@see File::append()
+ */
+class LFILE_EXPORT FileAppender final
+{
+public:
+	/** Options controlling when buffered data is written to the %file. */
+	struct Options final
+	{
+		/** The capacity in bytes of each thread's buffer. When appending to a thread's buffer would exceed this
+			size, all the buffered data is flushed first. Data larger than this is written directly, without
+			being buffered. If this is 0, every call to \c append() writes its data directly.
+
+			Each thread that appends uses up to twice this much memory, so that it can keep appending while
+			its previous data is being written.
+		 */
+		std::size_t bufferSize { 64 * 1024 };
+
+		/** If greater than zero, a background thread flushes the buffered data at this interval, so that
+			appended data never waits in memory for much longer than this.
+		 */
+		std::chrono::milliseconds flushInterval { 0 };
+	};
+
+	/** @name Constructors */
+	///@{
+
+	/** Creates a FileAppender that does not refer to any file. Call \c open() to actually open a file. */
+	FileAppender() noexcept;
+
+	/** Creates a FileAppender and attempts to open the specified %file.
+		Call \c isOpen() to find out if opening the file was successful.
+		@see open()
+	 */
+	explicit FileAppender (const Path& filepath) noexcept;
+	FileAppender (const Path& filepath, const Options& options) noexcept;
+
+	/** Move constructor. */
+	FileAppender (FileAppender&& other) noexcept;
+
+	///@}
+
+	/** Destructor. Flushes any buffered data, then closes the %file.
+		@see close()
+	 */
+	~FileAppender() noexcept;
+
+	/** Move assignment operator. */
+	FileAppender& operator= (FileAppender&& other) noexcept;
+
+	FileAppender (const FileAppender&)			  = delete;
+	FileAppender& operator= (const FileAppender&) = delete;
+
+	/** Closes the currently open %file (if any), then opens the file at the specified path for appending.
+		The file is created if it doesn't exist.
+
+		@returns True if the file was opened successfully.
+	 */
+	bool open (const Path& filepath) noexcept;
+	bool open (const Path& filepath, const Options& options) noexcept;
+
+	/** Flushes any buffered data, then closes the %file.
+		This must not be called while other threads are appending.
+
+		@returns False if any buffered data couldn't be written.
+	 */
+	bool close() noexcept;
+
+	/** Returns true if a file is currently open. */
+	[[nodiscard]] bool isOpen() const noexcept;
+
+	/** Evaluates to true if a file is currently open. */
+	explicit operator bool() const noexcept;
+
+	/** @name Appending content */
+	///@{
+	/** Appends the given data to the calling thread's buffer, flushing first if the buffer is full.
+
+		@returns False if no file is open, or if the data -- or buffered data that had to be flushed to make room
+		for it -- couldn't be written.
+	 */
+	bool append (const char* const data, std::size_t numBytes) noexcept;
+	bool append (const std::string_view& text) noexcept;
+	///@}
+
+	/** Writes all the data buffered by every thread to the %file.
+
+		This only hands the data to the OS; it doesn't wait for the data to reach the disk.
+
+		@returns False if any data couldn't be written since the last call to this function, including during
+		flushes triggered by \c append() or by the flush interval.
+	 */
+	bool flush() noexcept;
+
+	/** Returns the path of the file that is currently open.
+		Returns an empty path if no file is currently open.
+	 */
+	[[nodiscard]] Path getPath() const;
+
+private:
+	class Impl;
+
+	// shared with the threads that have appended, so that they can flush their buffers when they exit
+	std::shared_ptr<Impl> pimpl;
+};
+
+}  // namespace limes::files
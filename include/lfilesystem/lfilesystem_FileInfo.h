@@ -0,0 +1,206 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+#pragma once
+
+#include <cstdint>	 // for uintmax_t, uint32_t
+#include <filesystem>
+#include <optional>
+#include "lfilesystem/lfilesystem_Export.h"
+#include "lfilesystem/lfilesystem_FilesystemEntry.h"	// for Path
+#include "lfilesystem/lfilesystem_Permissions.h"
+
+/** @file
+	This file defines the FileInfo class.
+
+	@ingroup limes_files
+ */
+
+namespace limes::files
+{
+
+/** An immutable snapshot of the metadata of a filesystem entry.
+
+	All the requested fields are read from the filesystem at once -- on Linux, with a single \c statx()
+	call -- so reading several attributes of a %file this way is much cheaper than calling
+	\c FilesystemEntry::sizeInBytes() , \c FilesystemEntry::getLastModificationTime() ,
+	\c FilesystemEntry::getPermissions() etc. one after another, each of which queries the filesystem again.
+
+	When creating a FileInfo, you pass a mask of the fields you need. Some filesystems can skip work for
+	fields that weren't requested, but the OS may also return more fields than were requested. Fields
+	that the OS or filesystem cannot provide (such as the creation time on many Linux filesystems) are
+	reported as unavailable by \c hasFields() , and their getters return 0 or a default value.
+
+	For example:
+	@code{.cpp}
+	const limes::files::File file { "/path/to/file.txt" };
+
+	if (const auto info = file.getInfo (limes::files::FileInfo::Size | limes::files::FileInfo::ModificationTime))
+		std::cout << info->sizeInBytes() << " bytes, modified at " << info->getLastModificationTime();
+	@endcode
+
+	@ingroup limes_files
+	@see FilesystemEntry::getInfo()
+ */
+class LFILE_EXPORT FileInfo final
+{
+public:
+	/** A time point used for filesystem time. */
+	using Time = std::filesystem::file_time_type;
+
+	/** The type of the mask of fields to read. */
+	using Fields = std::uint32_t;
+
+	/** Flags for the fields that can be requested. These can be combined with the \c | operator. */
+	enum Field : Fields
+	{
+		Type			 = 1 << 0,	///< The type of the filesystem entry.
+		Mode			 = 1 << 1,	///< The permissions bits.
+		LinkCount		 = 1 << 2,	///< The number of hard links.
+		Owner			 = 1 << 3,	///< The user and group IDs of the owner.
+		Inode			 = 1 << 4,	///< The inode number.
+		Size			 = 1 << 5,	///< The size in bytes.
+		Blocks			 = 1 << 6,	///< The space allocated on disk.
+		AccessTime		 = 1 << 7,	///< The time of the last access.
+		ModificationTime = 1 << 8,	///< The time of the last modification of the content.
+		StatusChangeTime = 1 << 9,	///< The time of the last change to the metadata.
+		BirthTime		 = 1 << 10, ///< The creation time.
+
+		/** All the fields that \c stat() returns. */
+		Basic = Type | Mode | LinkCount | Owner | Inode | Size | Blocks | AccessTime | ModificationTime | StatusChangeTime,
+
+		All = Basic | BirthTime
+	};
+
+	/** Reads the metadata of the filesystem entry at the specified path.
+
+		@param path The path of the entry to query.
+		@param fields The fields to read.
+		@param followSymLinks If true and the path refers to a symbolic link, the returned info describes the
+		link's target. If false, the returned info describes the link itself.
+
+		@returns A null optional if the path doesn't exist or the metadata can't be read.
+
+		@see FilesystemEntry::getInfo()
+	 */
+	[[nodiscard]] static std::optional<FileInfo> tryCreate (const Path& path,
+															Fields		fields		   = All,
+															bool		followSymLinks = true) noexcept;
+
+	FileInfo (const FileInfo&)			  = default;
+	FileInfo& operator= (const FileInfo&) = default;
+
+	FileInfo (FileInfo&&)			 = default;
+	FileInfo& operator= (FileInfo&&) = default;
+
+	/** Returns true if all the specified fields are available in this snapshot. */
+	[[nodiscard]] bool hasFields (Fields fieldsToCheck) const noexcept;
+
+	/** Returns the mask of fields that are available in this snapshot. */
+	[[nodiscard]] Fields getFields() const noexcept;
+
+	/** @name Type */
+	///@{
+
+	/** Returns the type of the filesystem entry. */
+	[[nodiscard]] std::filesystem::file_type getType() const noexcept;
+
+	/** Returns true if the entry is a regular %file. */
+	[[nodiscard]] bool isFile() const noexcept;
+
+	/** Returns true if the entry is a %directory. */
+	[[nodiscard]] bool isDirectory() const noexcept;
+
+	/** Returns true if the entry is a symbolic link. This can only be true if symbolic links were not followed. */
+	[[nodiscard]] bool isSymLink() const noexcept;
+
+	///@}
+
+	/** @name Ownership and permissions */
+	///@{
+
+	/** Returns the permissions of the filesystem entry. */
+	[[nodiscard]] Permissions getPermissions() const noexcept;
+
+	/** Returns the user ID of the entry's owner. This is always 0 on Windows. */
+	[[nodiscard]] std::uint32_t getOwnerID() const noexcept;
+
+	/** Returns the group ID of the entry's owner. This is always 0 on Windows. */
+	[[nodiscard]] std::uint32_t getGroupID() const noexcept;
+
+	///@}
+
+	/** @name Identity */
+	///@{
+
+	/** Returns the inode number of the entry. Together with \c getDevice() , this uniquely identifies the entry. */
+	[[nodiscard]] std::uintmax_t getInode() const noexcept;
+
+	/** Returns the ID of the device that the entry resides on. */
+	[[nodiscard]] std::uintmax_t getDevice() const noexcept;
+
+	/** Returns the number of hard links to the entry. */
+	[[nodiscard]] std::uintmax_t getHardLinkCount() const noexcept;
+
+	///@}
+
+	/** @name Size */
+	///@{
+
+	/** Returns the size of the entry in bytes. */
+	[[nodiscard]] std::uintmax_t sizeInBytes() const noexcept;
+
+	/** Returns the number of bytes allocated on disk for the entry. For sparse or compressed files, this
+		may be smaller than \c sizeInBytes() .
+	 */
+	[[nodiscard]] std::uintmax_t getAllocatedBytes() const noexcept;
+
+	///@}
+
+	/** @name Times */
+	///@{
+
+	/** Returns the time the entry was last accessed. Many systems update this lazily, or not at all. */
+	[[nodiscard]] Time getLastAccessTime() const noexcept;
+
+	/** Returns the time the entry's content was last modified. */
+	[[nodiscard]] Time getLastModificationTime() const noexcept;
+
+	/** Returns the time the entry's metadata was last changed. */
+	[[nodiscard]] Time getStatusChangeTime() const noexcept;
+
+	/** Returns the time the entry was created, if the OS and filesystem record it. */
+	[[nodiscard]] std::optional<Time> getCreationTime() const noexcept;
+
+	///@}
+
+private:
+	FileInfo() = default;
+
+	struct Builder;
+
+	Fields available { 0 };
+
+	std::filesystem::file_type type { std::filesystem::file_type::none };
+
+	Permissions permissions;
+
+	std::uint32_t ownerID { 0 }, groupID { 0 };
+
+	std::uintmax_t inode { 0 }, device { 0 }, linkCount { 0 }, size { 0 }, allocated { 0 };
+
+	Time accessTime, modificationTime, statusChangeTime, birthTime;
+};
+
+}  // namespace limes::files
@@ -14,7 +14,13 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <string_view>
+#include <vector>
 #include "lfilesystem/lfilesystem_Export.h"
 #include "lfilesystem/lfilesystem_FilesystemEntry.h"
 
@@ -39,34 +45,235 @@ namespace limes::files
 
 	@internal
 	On MacOS, the \c FSEventStreamCreate() API is used to register a callback
-	directly with the OS. On Linux and Windows, Limes creates a background
-	thread that polls for changes and calls the listeners when changes have
-	occurred. Only one background thread will be created no matter how many
-	\c FileWatcher objects there are. Linux uses the \c inotify API and
-	Windows uses the \c CreateFileW()/ReadDirectoryChangesW() API.
+	directly with the OS. On Linux, Limes creates a single background thread
+	that waits on the \c inotify descriptors of all \c FileWatcher objects
+	with \c epoll , and calls the listeners as soon as the kernel reports
+	events. On Windows, Limes creates a background thread that polls for
+	changes using the \c CreateFileW()/ReadDirectoryChangesW() API.
 	@endinternal
 
+	Events may be delivered as soon as watching starts. A FileWatcher created with a path to watch
+	starts watching in its constructor, so its callbacks can be called before the constructor of a
+	subclass has finished. If your subclass's callbacks use the subclass's own members, use the
+	default constructor and call \c start() at the end of your constructor, and call \c stop() in
+	your destructor.
+
 	Each of the callbacks receives a \c FilesystemEntry argument with the
 	path to which the current event applies. If a directory is being
 	watched, this path may be a child of the watched directory. In some cases,
 	this path may be a parent directory of the watched path, even if the
 	watched path is a file.
 
+	On iOS, Android and Emscripten, which have no native API, the polling backend is always used.
+	Polling needs a background thread, so on Emscripten, watchers can only be started in builds with
+	pthreads enabled.
+
 	@ingroup limes_files
 
 	@see SimpleFileWatcher
-
-	@todo iOS, Android and Emscripten implementations. This class requires
-	platform-specific code, probably JNI for Android and Swift/ObjC for iOS. Is
-	this class possible to implement for Emscripten?
-
-	@todo how to test this class? A test would basically need to check that the
-	proper callbacks are indeed called when a watched file is mutated. Is this
-	even possible?
  */
 class LFILE_EXPORT FileWatcher
 {
 public:
+	/** The ways in which a FileWatcher can find out about changes.
+		@see Options::backend
+	 */
+	enum class Backend
+	{
+		/** The OS's own notification API: inotify on Linux, FSEvents on MacOS, and
+			\c ReadDirectoryChangesW() on Windows. If the system has none, the polling
+			backend is used instead.
+		 */
+		Native,
+
+		/** The watched tree is read periodically and compared with a snapshot of it.
+			This works on any filesystem, including network filesystems whose changes
+			made by other machines aren't reported by the native API, but it costs some
+			CPU time and disk access, and changes are only found at the next poll.
+
+			Only creation, deletion and modification events are reported, and only for
+			changes that are still visible at the next poll.
+		 */
+		Polling,
+
+		/** A single watch covers the entire filesystem that contains the watched path, and
+			events outside the watched tree are filtered out. This avoids the per-directory
+			watches that the native backend needs in recursive mode, which for large trees
+			can exceed the system's limits.
+
+			On Linux, this uses a \c fanotify mark with \c FAN_MARK_FILESYSTEM , which
+			requires the \c CAP_SYS_ADMIN capability and a kernel of version 5.9 or newer.
+			Access, open and close events without writing are not reported. If fanotify
+			can't be used, and on other systems, the native backend is used instead.
+
+			@see MountWatcher
+		 */
+		VolumeWide
+	};
+
+	/** Options that control how a FileWatcher monitors its path. */
+	struct Options final
+	{
+		/** If true and the watched path is a directory, events are reported for
+			the entire tree below it, and not just its immediate children.
+
+			On Linux, every subdirectory is watched individually, and watches for
+			subdirectories that are created or moved into the tree are added as they
+			appear. Directories whose watches can't be added -- for example because
+			the system's limit on the number of watches has been reached -- are
+			silently not monitored.
+
+			On MacOS, the OS always watches the entire tree; if this is false, events
+			for entries below the watched directory's immediate children are ignored.
+			On Windows, this is passed to \c ReadDirectoryChangesW() .
+		 */
+		bool recursive { false };
+
+		/** If greater than zero, events are not delivered through the individual
+			callbacks such as \c fileModified() as they arrive. Instead, all the
+			events received within this window after the first one are merged per
+			path, and delivered with a single call to \c changesDetected() .
+
+			For example, saving a file in a text editor often causes an open event,
+			several modification events, a close event and a metadata change. With
+			coalescing, these are delivered as a single \c Change for the saved file.
+		 */
+		std::chrono::milliseconds coalescingWindow { 0 };
+
+		/** The maximum number of entries in the snapshot of the watched tree that is
+			used to recover from dropped events.
+
+			If this is greater than zero and the OS drops events -- for example, because
+			its event queue overflowed -- \c eventsLost() is called, then the watched tree
+			is read again and compared with the snapshot, and the changes that were missed
+			are reported through the usual callbacks. The snapshot records the inode, size
+			and modification time of each entry, and the events that are received keep it
+			up to date.
+
+			The snapshot isn't free: the metadata of every entry in the tree is read when the
+			watcher starts, and many of the events received cost another metadata query, so
+			this is 0 by default, and dropped events are only reported through \c eventsLost() .
+			If the watched tree has more entries than this, no snapshot is kept.
+
+			Snapshots are currently only used on Linux, and never with the volume-wide backend or
+			with \c compactEvents . The polling backend always keeps a snapshot, and can't watch
+			a tree that has more entries than this; if this is 0, it uses a limit of 100,000 entries.
+		 */
+		std::size_t maxSnapshotEntries { 0 };
+
+		/** Which backend to use for this watcher. */
+		Backend backend { Backend::Native };
+
+		/** When using the polling backend, the time between the end of one poll and the start of the next. */
+		std::chrono::milliseconds pollInterval { 1000 };
+
+		/** When using the polling backend, the largest fraction of one CPU core's time that may be spent polling.
+			If a poll takes longer than this allows, the time until the next poll is extended to compensate.
+			For example, with a budget of 0.05, a poll that takes 100 ms is followed by a pause of at least
+			1.9 seconds, even if the poll interval is shorter.
+		 */
+		double pollCpuBudget { 0.05 };
+
+		/** If greater than zero, the callbacks are not called on the watcher's background thread.
+			Instead, events are pushed to a bounded lock-free queue, and the callbacks are called
+			from \c deliverQueuedEvents() , on whichever thread you call it from. This is useful
+			when events should be handled on a latency-sensitive thread, such as a main loop, and
+			a slow handler must not hold up the collection of events for other watchers.
+
+			The queue has room for this many events, rounded up to a power of 2. When it is
+			full, new events are dropped and counted by \c getNumDroppedEvents() , and
+			\c eventsLost() is called by the next \c deliverQueuedEvents() .
+
+			If this is set, \c coalescingWindow is ignored.
+		 */
+		std::size_t queueCapacity { 0 };
+
+		/** If true, events are delivered to \c eventReceived() as lightweight \c Event records, instead of
+			through the individual callbacks. No FilesystemEntry is created unless you ask the event for one.
+			On Linux, the names in the records point directly into the buffer the events were read into, and the
+			two halves of a rename are delivered as a single event.
+
+			If this is set, \c coalescingWindow and \c queueCapacity are ignored, and the native backend keeps no
+			snapshot to recover dropped events with, since keeping it up to date would need the path of every event.
+		 */
+		bool compactEvents { false };
+	};
+
+	/** The types of events that a FileWatcher can report.
+		These are bit flags that are combined in \c Change::events .
+	 */
+	enum EventType : std::uint32_t
+	{
+		Accessed		= 1 << 0,  ///< @see fileAccessed()
+		MetadataChanged = 1 << 1,  ///< @see fileMetadataChanged()
+		HandleClosed	= 1 << 2,  ///< @see fileHandleClosed()
+		Created			= 1 << 3,  ///< @see fileCreated()
+		Deleted			= 1 << 4,  ///< @see fileDeleted()
+		Modified		= 1 << 5,  ///< @see fileModified()
+		Moved			= 1 << 6,  ///< @see fileMoved()
+		Opened			= 1 << 7,  ///< @see fileOpened()
+		Other			= 1 << 8   ///< @see otherEventType()
+	};
+
+	/** Describes all the events that were received for a single path within a coalescing window.
+		@see changesDetected(), Options::coalescingWindow
+	 */
+	struct Change final
+	{
+		/** The path to which the events apply. */
+		FilesystemEntry file;
+
+		/** The types of the events that were received, as a combination of \c EventType flags.
+			The order in which the events occurred is not recorded.
+		 */
+		std::uint32_t events { 0 };
+	};
+
+	/** A lightweight record of a single event, delivered to \c eventReceived() .
+
+		The record borrows its strings from the watcher, so it is only valid during the callback. Call
+		\c getPath() or \c getEntry() to keep the path for longer.
+
+		@see Options::compactEvents
+	 */
+	struct Event final
+	{
+		/** The type of the borrowed strings. */
+		using StringView = std::basic_string_view<Path::value_type>;
+
+		/** The absolute path of the directory that contains the entry. */
+		StringView directory;
+
+		/** The name of the entry within the directory, or an empty string if the event is for the directory itself. */
+		StringView name;
+
+		/** The types of the event, as a combination of \c EventType flags. */
+		std::uint32_t events { 0 };
+
+		/** The cookie that the OS uses to connect related events, such as the two halves of a rename.
+			This is only set on Linux, and is 0 otherwise.
+		 */
+		std::uint32_t cookie { 0 };
+
+		/** For a \c Moved event whose origin is known, the directory that the entry was moved from. Otherwise, empty. */
+		StringView oldDirectory;
+
+		/** For a \c Moved event whose origin is known, the name that the entry was moved from. Otherwise, empty. */
+		StringView oldName;
+
+		/** True if the entry is known to be a directory. This is currently only reported on Linux. */
+		bool isDirectory { false };
+
+		/** Returns the absolute path of the entry. */
+		[[nodiscard]] Path getPath() const;
+
+		/** Returns the path that the entry was moved from, or an empty path if it isn't known. */
+		[[nodiscard]] Path getOldPath() const;
+
+		/** Creates a FilesystemEntry for the entry. */
+		[[nodiscard]] FilesystemEntry getEntry() const;
+	};
+
 	/** Creates a FileWatcher to watch the given file or directory.
 
 		@throws std::runtime_error Throws an exception if the file watcher
@@ -76,6 +283,15 @@ class LFILE_EXPORT FileWatcher
 	 */
 	explicit FileWatcher (const FilesystemEntry& fileToWatch);
 
+	/** Creates a FileWatcher to watch the given file or directory with the specified options.
+
+		@throws std::runtime_error Throws an exception if the file watcher
+		fails to initialize for any reason. An exception will always be
+		thrown if the file you request to watch does not exist at the time
+		of the object's construction.
+	 */
+	FileWatcher (const FilesystemEntry& fileToWatch, const Options& optionsToUse);
+
 	/** Creates an inactive FileWatcher that does nothing. Call \c start() and provide
 		a new path to watch in order to use this object.
 	 */
@@ -138,6 +354,47 @@ class LFILE_EXPORT FileWatcher
 	 */
 	virtual void otherEventType (const FilesystemEntry& /*path*/) { }
 
+	/** Called when the OS has dropped events for the watched path, for example because its
+		event queue overflowed under heavy load.
+
+		If the watcher keeps a snapshot of the watched tree, this is followed by callbacks for the
+		changes that were found by reading the tree again. Otherwise, you should assume that
+		anything in the watched tree may have changed.
+
+		@see Options::maxSnapshotEntries
+	 */
+	virtual void eventsLost() { }
+
+	/** Called with the changes collected during a coalescing window, if \c Options::coalescingWindow
+		is greater than zero. Each path appears only once, in the order in which the first event for
+		each path was received.
+
+		The default implementation calls the individual callbacks, such as \c fileModified() , once for
+		each type of event received for each path.
+	 */
+	virtual void changesDetected (const std::vector<Change>& changes);
+
+	/** Called for every event if \c Options::compactEvents is true. The event is only valid during this call.
+		@see Event
+	 */
+	virtual void eventReceived (const Event& /*event*/) { }
+
+	/** Calls the callbacks for events that were queued because \c Options::queueCapacity is greater than zero.
+
+		The callbacks are called on the calling thread, in the order in which the events were received.
+		If events were dropped since the last call, \c eventsLost() is called first. Only one thread may call
+		this at a time, and the callbacks must not destroy this watcher.
+
+		@param maxEvents The maximum number of events to deliver. Any others are left in the queue.
+		@returns The number of events delivered. This is always 0 if events are not being queued.
+	 */
+	std::size_t deliverQueuedEvents (std::size_t maxEvents = std::numeric_limits<std::size_t>::max());
+
+	/** Returns the total number of events that were dropped because the event queue was full.
+		@see Options::queueCapacity
+	 */
+	[[nodiscard]] std::uint64_t getNumDroppedEvents() const noexcept;
+
 	/** Restarts watching the path specified at construction.
 
 		@returns True if the FilesystemWatcher is running after this function returns. This
@@ -153,8 +410,18 @@ class LFILE_EXPORT FileWatcher
 	 */
 	bool start (const FilesystemEntry& newPathToWatch);
 
+	/** Begins watching the specified path with new options.
+
+		This always calls \c stop() first, even if the path is the same as the previously watched path.
+
+		@returns True if the FilesystemWatcher is running after this function returns.
+	 */
+	bool start (const FilesystemEntry& newPathToWatch, const Options& newOptions);
+
 	/** Stops the FilesystemWatcher's event callbacks.
 		This does not cancel any pending callbacks that may have been registered with the OS.
+		On Linux, once this function returns, no more callbacks will be made, and any callback
+		that was running on the background thread has finished.
 	 */
 	void stop();
 
@@ -165,17 +432,38 @@ class LFILE_EXPORT FileWatcher
 	/** Returns the path that is currently being watched. */
 	[[nodiscard]] FilesystemEntry getWatchedPath() const noexcept;
 
-	/** Returns true if the current system supports file event watching.
-		Currently returns false on iOS and Android.
+	/** Returns the backend that is currently in use. This may differ from \c Options::backend if the requested
+		backend isn't available. If the watcher isn't running, this returns the requested backend.
+	 */
+	[[nodiscard]] Backend getBackend() const noexcept;
+
+	/** Returns the options this watcher was created with. These are kept when \c start() is called with a new path. */
+	[[nodiscard]] Options getOptions() const noexcept;
+
+	/** Returns true if the current system has a native API for file event watching.
+		Currently returns false on iOS, Android and Emscripten, where the polling backend is always used.
 	 */
 	static bool supportedBySystem() noexcept;
 
 private:
 	class Impl;
+	class Poller;
+	class EventQueue;
+
+	friend class EventDispatcher;
+
+	void startBackend();
 
 	[[maybe_unused]] std::unique_ptr<Impl> pimpl;
 
+	std::unique_ptr<Poller> poller;
+
+	// owned by the watcher rather than the backend, so that it survives stop() and start()
+	std::unique_ptr<EventQueue> queue;
+
 	[[maybe_unused]] FilesystemEntry watchedPath;
+
+	Options options;
 };
 
 }  // namespace files
@@ -20,6 +20,8 @@
 #include <functional>  // for std::hash
 #include <optional>
 #include <ostream>
+#include <system_error>
+#include <vector>
 #include "lfilesystem/lfilesystem_Export.h"
 #include "lfilesystem/lfilesystem_Permissions.h"
 
@@ -34,6 +36,7 @@ namespace limes::files
 
 class Directory;
 class File;
+class FileInfo;
 class SymLink;
 class Volume;
 
@@ -73,7 +76,6 @@ using Path = std::filesystem::path;
 	@see File, Directory, SymLink
 
 	@todo getNonexistentSibling()
-	@todo getCreationTime(), getLastAccessTime()
 	@todo tests for getModificationTime(), getCreationTime(), getLastAccessTime()
  */
 class LFILE_EXPORT FilesystemEntry
@@ -426,6 +428,22 @@ class LFILE_EXPORT FilesystemEntry
 	 */
 	[[nodiscard]] Time getLastModificationTime() const noexcept;
 
+	/** Reads a snapshot of this entry's metadata with a single query to the filesystem.
+
+		Prefer this to calling several of the individual query functions, such as \c sizeInBytes() ,
+		\c getLastModificationTime() and \c getPermissions() , each of which queries the filesystem again.
+
+		@param fields A mask of the \c FileInfo::Field values to read. By default, all fields are read.
+		Requesting fewer fields can be cheaper on some filesystems.
+		@param followSymLinks If true and this entry is a symbolic link, the returned info describes the link's
+		target. If false, the returned info describes the link itself.
+
+		@returns A null optional if this entry doesn't exist, or its metadata can't be read.
+
+		@see FileInfo
+	 */
+	[[nodiscard]] std::optional<FileInfo> getInfo (std::uint32_t fields = ~std::uint32_t { 0 }, bool followSymLinks = true) const noexcept;
+
 	/** Returns a Volume object representing the logical filesystem volume that this object exists on.
 		Returns a \c nullopt if the volume for this path cannot be computed correctly, or if this FilesystemEntry holds an invalid path.
 	 */
@@ -475,10 +493,70 @@ class LFILE_EXPORT FilesystemEntry
 
 		@returns True if the object existed and was successfully deleted. False if it did not exist or if deletion fails.
 
-		@see moveToTrash()
+		If this is a %directory, everything below it is deleted as well, using \c deleteRecursively() on the
+		calling thread. To delete a large tree in parallel, call \c deleteRecursively() directly.
+
+		A symbolic link whose target doesn't exist is considered not to exist, so it is not deleted.
+
+		@see moveToTrash(), deleteRecursively()
 	 */
 	bool deleteIfExists() const noexcept;
 
+	/** Describes the outcome of a recursive delete.
+		@see deleteRecursively()
+	 */
+	struct LFILE_EXPORT DeleteResult final
+	{
+		/** An entry that couldn't be deleted. */
+		struct Failure final
+		{
+			/** The path of the entry. */
+			Path path;
+
+			/** The reason the entry couldn't be deleted. */
+			std::error_code error;
+		};
+
+		/** The number of entries that were deleted, including directories. */
+		std::uintmax_t numRemoved { 0 };
+
+		/** The entries that couldn't be deleted. A %directory that couldn't be deleted because one of its
+			children couldn't be deleted is also listed here.
+		 */
+		std::vector<Failure> failures;
+	};
+
+	/** Deletes this filesystem entry and, if it is a %directory, everything below it.
+
+		On Unix systems, the tree is deleted relative to open %directory descriptors with \c openat() and
+		\c unlinkat() , so each entry's path is only resolved once, however deep it is. Sibling subdirectories
+		are deleted in parallel on a pool of worker threads, which is only started if the %directory contains
+		subdirectories. On Windows, this uses \c std::filesystem::remove_all() .
+
+		Symbolic links are deleted, and are never followed. If an entry can't be deleted, the delete continues
+		with the others, and the failure is reported in the result. This function never throws.
+
+		@param numThreads The number of threads to use. If this is 0, the number of hardware threads is used.
+
+		@see deleteInBackground(), deleteIfExists()
+	 */
+	DeleteResult deleteRecursively (std::size_t numThreads = 0) const noexcept;
+
+	/** Moves this filesystem entry out of the way, then deletes it on a background thread.
+
+		The entry is first renamed to a hidden tombstone name in the same %directory, which is a single, fast
+		operation no matter how large the tree is. Once this function returns, the original path is free to be
+		reused. The tombstone is then deleted with \c deleteRecursively() on a detached thread.
+
+		If the program exits before the background delete finishes, the tombstone is left on disk.
+
+		@returns True if the entry was renamed. False if it doesn't exist, or if renaming it failed; in that case
+		nothing is deleted.
+
+		@see deleteRecursively()
+	 */
+	bool deleteInBackground (std::size_t numThreads = 0) const noexcept;
+
 	/** Attempts to move this filesystem object to the system's trash folder.
 
 		@returns True if the object existed and moving to the trash folder was successful.
@@ -0,0 +1,174 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+#pragma once
+
+#include <cstddef>	// for size_t, byte
+#include <span>
+#include <string_view>
+#include <vector>
+#include "lfilesystem/lfilesystem_Export.h"
+#include "lfilesystem/lfilesystem_FilesystemEntry.h"	// for Path
+
+/** @file
+	This file defines the MemoryMappedFile class.
+
+	@ingroup limes_files
+ */
+
+namespace limes::files
+{
+
+/** This class provides a read-only view of the entire contents of a %file, using the operating
+	system's virtual memory facilities to map the %file into the address space of the current process.
+
+	Accessing a %file this way avoids copying its contents into a buffer owned by the application --
+	pages are loaded from the OS page cache on demand, and can be evicted by the OS under memory
+	pressure.
+
+	Some files cannot be mapped -- for example, pipes, sockets, or the pseudo-files in \c /proc .
+	For these, this class transparently falls back to reading the %file's contents into an internal
+	buffer, so that the same API works for any readable %file. You can call \c isMemoryMapped() to
+	find out which strategy was used.
+
+	For example:
+	@code{.cpp}
+	const limes::files::MemoryMappedFile mapped { "/path/to/a/large/file.json",
+												  limes::files::MemoryMappedFile::AccessPattern::Sequential };
+
+	if (mapped.isOpen())
+		parse_json (mapped.getString());
+	@endcode
+
+	@note The view is only valid for as long as this object is alive and open. Modifying or truncating
+	the underlying %file while it is mapped results in undefined behavior on most platforms.
+
+	@ingroup limes_files
+	@see File, CFile
+ */
+class LFILE_EXPORT MemoryMappedFile final
+{
+public:
+	/** Describes how the mapped memory is expected to be accessed.
+		This is passed to the OS as a hint, and may allow the OS to perform more aggressive readahead, or
+		to avoid readahead altogether.
+
+		@see advise()
+	 */
+	enum class AccessPattern
+	{
+		Normal,		 ///< No special treatment.
+		Sequential,	 ///< The mapping will be read from beginning to end. The OS may read ahead aggressively.
+		Random,		 ///< The mapping will be read in random order. The OS may disable readahead.
+		WillNeed	 ///< The whole mapping will be needed soon. The OS may begin loading it immediately.
+	};
+
+	/** @name Constructors */
+	///@{
+
+	/** Creates a MemoryMappedFile that does not refer to any file. Call \c open() to actually open a file. */
+	MemoryMappedFile() = default;
+
+	/** Creates a MemoryMappedFile and attempts to open the specified %file.
+		Call \c isOpen() to find out if opening the file was successful.
+		@see open()
+	 */
+	explicit MemoryMappedFile (const Path& filepath, AccessPattern accessPattern = AccessPattern::Normal) noexcept;
+
+	/** Move constructor. */
+	MemoryMappedFile (MemoryMappedFile&& other) noexcept;
+
+	///@}
+
+	/** Destructor. If a file is currently mapped, the destructor unmaps it.
+		@see close()
+	 */
+	~MemoryMappedFile() noexcept;
+
+	/** Move assignment operator. */
+	MemoryMappedFile& operator= (MemoryMappedFile&& other) noexcept;
+
+	MemoryMappedFile (const MemoryMappedFile&) = delete;
+	MemoryMappedFile& operator= (const MemoryMappedFile&) = delete;
+
+	/** Closes the currently open %file (if any), then opens the file at the specified path.
+
+		The file is memory mapped if possible; otherwise, its content is read into an internal buffer.
+
+		@returns True if the file was opened successfully, by either strategy.
+	 */
+	bool open (const Path& filepath, AccessPattern accessPattern = AccessPattern::Normal) noexcept;
+
+	/** Unmaps the file and releases any memory held by this object.
+
+		@post Calling \c getBytes() after calling this function returns an empty span, and calling \c getPath()
+		returns an empty path.
+	 */
+	void close() noexcept;
+
+	/** Returns true if a file is currently open. */
+	[[nodiscard]] bool isOpen() const noexcept;
+
+	/** Evaluates to true if a file is currently open. */
+	explicit operator bool() const noexcept;
+
+	/** Returns true if the file's content is actually memory mapped. Returns false if no file is open, or if
+		the file's content was read into an internal buffer because it could not be mapped.
+	 */
+	[[nodiscard]] bool isMemoryMapped() const noexcept;
+
+	/** @name Accessing the content */
+	///@{
+
+	/** Returns a view of the file's entire contents as raw bytes. */
+	[[nodiscard]] std::span<const std::byte> getBytes() const noexcept;
+
+	/** Returns a view of the file's entire contents as a string. */
+	[[nodiscard]] std::string_view getString() const noexcept;
+
+	/** Returns the number of bytes in the view. */
+	[[nodiscard]] std::size_t size() const noexcept;
+
+	/** Returns true if no file is open, or if the open file is empty. */
+	[[nodiscard]] bool empty() const noexcept;
+
+	///@}
+
+	/** Passes a hint to the OS describing how the mapped memory will be accessed.
+
+		@returns True if the hint was successfully passed to the OS. This always returns false if \c isMemoryMapped()
+		returns false.
+
+		@note On Windows, only \c AccessPattern::WillNeed has any effect.
+	 */
+	bool advise (AccessPattern accessPattern) const noexcept;
+
+	/** Returns the path of the file that is currently open.
+		Returns an empty path if no file is currently open.
+	 */
+	[[nodiscard]] Path getPath() const;
+
+private:
+	const std::byte* data { nullptr };
+
+	std::size_t length { 0UL };
+
+	bool mapped { false };
+
+	std::vector<std::byte> buffer;
+
+	Path path;
+};
+
+}  // namespace limes::files
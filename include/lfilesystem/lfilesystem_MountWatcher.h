@@ -0,0 +1,77 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#pragma once
+
+#include <optional>
+#include "lfilesystem/lfilesystem_Export.h"
+#include "lfilesystem/lfilesystem_FileWatcher.h"
+#include "lfilesystem/lfilesystem_Volume.h"
+
+/** @file
+	This file defines the MountWatcher class.
+	@ingroup limes_files
+ */
+
+namespace limes::files
+{
+
+/** A FileWatcher that reports the changes to every file on a Volume.
+
+	Watching a whole volume with a recursive FileWatcher requires a separate watch for every directory, which
+	for large volumes exceeds the system's limit on the number of watches. A MountWatcher uses a single
+	volume-wide watch instead, where the system supports it. On Linux, this is a \c fanotify filesystem mark,
+	which requires the \c CAP_SYS_ADMIN capability. Otherwise, the volume is watched with a recursive watcher
+	using the native backend, and \c getBackend() returns \c Backend::Native .
+
+	As with FileWatcher, override the callbacks to receive the events. Watching starts in the constructor, so
+	if you subclass this, consider using the default constructor and calling \c start() from your subclass's
+	constructor instead, so that no callbacks are made before your subclass has been constructed.
+
+	@ingroup limes_files
+	@see FileWatcher::Backend::VolumeWide
+ */
+class LFILE_EXPORT MountWatcher : public FileWatcher
+{
+public:
+	/** Creates a watcher that reports the changes to every file on the specified volume.
+
+		The \c backend and \c recursive fields of the options are ignored.
+
+		@throws std::runtime_error Throws an exception if the watcher fails to initialize.
+	 */
+	explicit MountWatcher (const Volume& volumeToWatch, const Options& optionsToUse = {});
+
+	/** Creates an inactive MountWatcher. Call \c start() with a volume to use this object. */
+	MountWatcher() noexcept = default;
+
+	/** Begins watching the specified volume. This always calls \c stop() first.
+
+		The \c backend and \c recursive fields of the options are ignored.
+
+		@returns True if the watcher is running after this function returns.
+	 */
+	bool start (const Volume& volumeToWatch, const Options& optionsToUse = {});
+
+	using FileWatcher::start;
+
+	/** Returns the volume that is being watched, or a null optional if no volume has been watched yet. */
+	[[nodiscard]] std::optional<Volume> getVolume() const;
+
+private:
+	[[nodiscard]] static Options getVolumeOptions (const Options& options) noexcept;
+};
+
+}  // namespace limes::files
@@ -56,6 +56,21 @@ class LFILE_EXPORT SimpleFileWatcher final : public FileWatcher
 	explicit SimpleFileWatcher (const FilesystemEntry& fileToWatch,
 								Callback&&			   callbackToUse);
 
+	/** Creates a file watcher with the specified options that will call the
+		given \c callback for every event type on the watched path.
+
+		@throws std::runtime_error Throws an exception if the file watcher
+		fails to initialize for any reason. An exception will always be
+		thrown if the file you request to watch does not exist at the time
+		of the object's construction.
+	 */
+	SimpleFileWatcher (const FilesystemEntry& fileToWatch,
+					   const Options&		  optionsToUse,
+					   Callback&&			  callbackToUse);
+
+	/** Destructor. Stops watching before the callback is destroyed. */
+	~SimpleFileWatcher() final;
+
 private:
 	void fileAccessed (const FilesystemEntry& f) final;
 	void fileMetadataChanged (const FilesystemEntry& f) final;
@@ -0,0 +1,338 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include "lfilesystem/lfilesystem_File.h"
+
+#if defined(_WIN32) || defined(WIN32)
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#	include <cerrno>
+#endif
+
+/** This file implements File::overwriteAtomically(). */
+
+namespace limes::files
+{
+
+namespace
+{
+
+// the name of a temporary file, which is unique within this process
+[[nodiscard]] std::string makeTemporaryName (const std::string& name)
+{
+	static std::atomic<unsigned> counter { 0 };
+
+#if defined(_WIN32) || defined(WIN32)
+	const auto processID = ::GetCurrentProcessId();
+#else
+	const auto processID = ::getpid();
+#endif
+
+	return "." + name + ".tmp." + std::to_string (processID) + "." + std::to_string (counter.fetch_add (1));
+}
+
+}  // namespace
+
+#if defined(_WIN32) || defined(WIN32)
+
+bool File::overwriteAtomically (const char* const data, std::size_t numBytes, Durability durability) const noexcept
+{
+	try
+	{
+		auto filePath = getAbsolutePath();
+
+		std::error_code ec;
+
+		if (std::filesystem::is_symlink (filePath, ec))
+			filePath = std::filesystem::weakly_canonical (filePath);
+
+		const auto tempPath = filePath.parent_path() / makeTemporaryName (filePath.filename().string());
+
+		auto* const handle = ::CreateFileW (tempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW,
+											FILE_ATTRIBUTE_NORMAL | FILE_ATTRIBUTE_HIDDEN, nullptr);
+
+		if (handle == INVALID_HANDLE_VALUE)
+			return false;
+
+		auto succeeded = true;
+
+		for (auto remaining = numBytes; succeeded && remaining > 0;)
+		{
+			DWORD written { 0 };
+
+			const auto chunk = static_cast<DWORD> (std::min (remaining, std::size_t { 1 } << 30));
+
+			succeeded = ::WriteFile (handle, data + (numBytes - remaining), chunk, &written, nullptr) != 0;
+
+			remaining -= written;
+		}
+
+		if (succeeded && durability != Durability::None)
+			succeeded = ::FlushFileBuffers (handle) != 0;
+
+		::CloseHandle (handle);
+
+		if (succeeded)
+		{
+			auto flags = static_cast<DWORD> (MOVEFILE_REPLACE_EXISTING);
+
+			// the move isn't reported as finished until it has been flushed to disk
+			if (durability == Durability::Full)
+				flags |= MOVEFILE_WRITE_THROUGH;
+
+			succeeded = ::MoveFileExW (tempPath.c_str(), filePath.c_str(), flags) != 0;
+		}
+
+		if (! succeeded)
+			std::filesystem::remove (tempPath, ec);
+
+		return succeeded;
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+#else
+
+namespace
+{
+
+class Descriptor final
+{
+public:
+	explicit Descriptor (int fileDescriptor) noexcept
+		: fd (fileDescriptor)
+	{
+	}
+
+	~Descriptor()
+	{
+		if (fd >= 0)
+			::close (fd);
+	}
+
+	Descriptor (const Descriptor&)			  = delete;
+	Descriptor& operator= (const Descriptor&) = delete;
+
+	[[nodiscard]] bool isValid() const noexcept { return fd >= 0; }
+
+	[[nodiscard]] int get() const noexcept { return fd; }
+
+private:
+	const int fd;
+};
+
+[[nodiscard]] bool writeAll (int fd, const char* data, std::size_t numBytes) noexcept
+{
+	while (numBytes > 0)
+	{
+		const auto result = ::write (fd, data, numBytes);
+
+		if (result < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			return false;
+		}
+
+		data += result;
+		numBytes -= static_cast<std::size_t> (result);
+	}
+
+	return true;
+}
+
+[[nodiscard]] bool flushData (int fd) noexcept
+{
+#if defined(__APPLE__)
+	// fsync() on MacOS only hands the data to the drive, which may hold it in a volatile cache
+	return ::fcntl (fd, F_FULLFSYNC) == 0 || ::fsync (fd) == 0;
+#else
+	return ::fdatasync (fd) == 0;
+#endif
+}
+
+// writes the new content to a file descriptor, gives it the permissions of the file it will replace, and flushes it if requested
+[[nodiscard]] bool writeContent (int fd, const char* data, std::size_t numBytes, const struct stat* existingInfo, File::Durability durability) noexcept
+{
+	if (! writeAll (fd, data, numBytes))
+		return false;
+
+	if (existingInfo != nullptr && ::fchmod (fd, existingInfo->st_mode & 07777) != 0)
+		return false;
+
+	return durability == File::Durability::None || flushData (fd);
+}
+
+#ifdef O_TMPFILE
+
+enum class UnnamedFileResult
+{
+	Written,
+	Unsupported,
+	Failed
+};
+
+// writes the content to an unnamed file, then gives it a temporary name once it's complete.
+// Returns Unsupported, without side effects, if unnamed files can't be used here
+[[nodiscard]] UnnamedFileResult writeUnnamedFile (int directory, const std::string& name, std::string& tempName,
+												  const char* data, std::size_t numBytes, const struct stat* existingInfo,
+												  File::Durability durability)
+{
+	// linkat() with AT_EMPTY_PATH requires special privileges, but linking the /proc entry doesn't
+	if (::access ("/proc/self/fd", F_OK) != 0)
+		return UnnamedFileResult::Unsupported;
+
+	const Descriptor file { ::openat (directory, ".", O_TMPFILE | O_WRONLY | O_CLOEXEC, 0666) };
+
+	if (! file.isValid())
+	{
+		// older kernels report EISDIR, and filesystems without support report EOPNOTSUPP
+		if (errno == EOPNOTSUPP || errno == EISDIR || errno == EINVAL)
+			return UnnamedFileResult::Unsupported;
+
+		return UnnamedFileResult::Failed;
+	}
+
+	if (! writeContent (file.get(), data, numBytes, existingInfo, durability))
+		return UnnamedFileResult::Failed;
+
+	const auto procPath = "/proc/self/fd/" + std::to_string (file.get());
+
+	for (auto attempt = 0; attempt < 8; ++attempt)
+	{
+		tempName = makeTemporaryName (name);
+
+		if (::linkat (AT_FDCWD, procPath.c_str(), directory, tempName.c_str(), AT_SYMLINK_FOLLOW) == 0)
+			return UnnamedFileResult::Written;
+
+		if (errno != EEXIST)
+			break;
+	}
+
+	tempName.clear();
+
+	return UnnamedFileResult::Failed;
+}
+
+#endif
+
+[[nodiscard]] bool writeNamedFile (int directory, const std::string& name, std::string& tempName,
+								   const char* data, std::size_t numBytes, const struct stat* existingInfo,
+								   File::Durability durability)
+{
+	for (auto attempt = 0; attempt < 8; ++attempt)
+	{
+		tempName = makeTemporaryName (name);
+
+		const Descriptor file { ::openat (directory, tempName.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666) };
+
+		if (! file.isValid())
+		{
+			if (errno == EEXIST)
+				continue;
+
+			break;
+		}
+
+		if (writeContent (file.get(), data, numBytes, existingInfo, durability))
+			return true;
+
+		::unlinkat (directory, tempName.c_str(), 0);
+
+		break;
+	}
+
+	tempName.clear();
+
+	return false;
+}
+
+}  // namespace
+
+bool File::overwriteAtomically (const char* const data, std::size_t numBytes, Durability durability) const noexcept
+{
+	try
+	{
+		const auto filePath = getAbsolutePath();
+
+		// all the operations are relative to the directory, so that its path is only resolved once
+		const Descriptor directory { ::open (filePath.parent_path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC) };
+
+		if (! directory.isValid())
+			return false;
+
+		const auto name = filePath.filename().string();
+
+		struct stat info {};
+
+		const auto exists = ::fstatat (directory.get(), name.c_str(), &info, AT_SYMLINK_NOFOLLOW) == 0;
+
+		if (exists && S_ISLNK (info.st_mode))
+			return File { std::filesystem::canonical (filePath) }.overwriteAtomically (data, numBytes, durability);
+
+		const auto* const existingInfo = exists ? &info : nullptr;
+
+		std::string tempName;
+
+#ifdef O_TMPFILE
+		const auto result = writeUnnamedFile (directory.get(), name, tempName, data, numBytes, existingInfo, durability);
+
+		if (result == UnnamedFileResult::Failed)
+			return false;
+
+		if (result == UnnamedFileResult::Unsupported)
+#endif
+		{
+			if (! writeNamedFile (directory.get(), name, tempName, data, numBytes, existingInfo, durability))
+				return false;
+		}
+
+		if (::renameat (directory.get(), tempName.c_str(), directory.get(), name.c_str()) != 0)
+		{
+			::unlinkat (directory.get(), tempName.c_str(), 0);
+			return false;
+		}
+
+		if (durability == Durability::Full)
+			return ::fsync (directory.get()) == 0;
+
+		return true;
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+#endif
+
+bool File::overwriteAtomically (const std::string_view& text, Durability durability) const noexcept
+{
+	return overwriteAtomically (text.data(), text.size(), durability);
+}
+
+}  // namespace limes::files
@@ -18,12 +18,26 @@
 #include <vector>		// for vector
 #include <string>		// for string
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <system_error>
+#include <utility>
 #include "lfilesystem/lfilesystem_FilesystemEntry.h"	// for FilesystemEntry, Path
 #include "lfilesystem/lfilesystem_File.h"				// for File
 #include "lfilesystem/lfilesystem_SymLink.h"			// for SymLink
 #include "lfilesystem/lfilesystem_Misc.h"		// for PATHseparator
 #include "lfilesystem/lfilesystem_Directory.h"
 #include "lfilesystem/lfilesystem_SpecialDirectories.h"
+#include "lfilesystem/lfilesystem_FileInfo.h"
+#include "lfilesystem_FileCopy.h"
+#include "lfilesystem_Parallel.h"
+
+#if ! (defined(_WIN32) || defined(WIN32))
+#	include <sys/stat.h>
+#endif
 
 namespace limes::files
 {
@@ -62,13 +76,24 @@ bool Directory::contains (const FilesystemEntry& entry, std::size_t depthLimit)
 
 bool Directory::contains (const std::string_view& childName) const
 {
-	const auto children = getAllChildren (false);
+	// only the name of an immediate child is accepted, not a path
+	if (childName.empty() || childName == "." || childName == "..")
+		return false;
 
-	return std::find_if (std::begin (children),
-						 std::end (children),
-						 [&childName] (const FilesystemEntry& e)
-						 { return e.getName() == childName; })
-			!= std::end (children);
+#if defined(_WIN32) || defined(WIN32)
+	if (childName.find_first_of ("/\\") != std::string_view::npos)
+		return false;
+#else
+	if (childName.find ('/') != std::string_view::npos)
+		return false;
+#endif
+
+	// a single lstat() call, instead of listing the directory. Dangling symlinks are still children
+	std::error_code ec;
+
+	const auto status = std::filesystem::symlink_status (getAbsolutePath() / childName, ec);
+
+	return std::filesystem::exists (status);
 }
 
 bool Directory::createIfDoesntExist() const noexcept
@@ -96,7 +121,12 @@ Path Directory::getRelativePath (const Path& inputPath) const
 
 bool Directory::isEmpty() const
 {
-	return getAllChildren().empty();
+	// only the first entry needs to be read. A directory that doesn't exist, or can't be read, is empty
+	std::error_code ec;
+
+	const std::filesystem::directory_iterator it { getAbsolutePath(), ec };
+
+	return ec || it == std::filesystem::directory_iterator {};
 }
 
 [[nodiscard]] static inline Path resolveChildPath (const Path& parent, const std::string_view& childName)
@@ -155,102 +185,222 @@ using IteratorType = std::conditional_t<Recursive,
 										std::filesystem::recursive_directory_iterator,
 										std::filesystem::directory_iterator>;
 
-template <bool Recursive>
-[[nodiscard]] static inline std::vector<FilesystemEntry> getAllDirChildren (const Path& path, bool includeHiddenFiles)
+using FileType = std::filesystem::file_type;
+
+/* Returns the type of a directory entry, without following symlinks.
+	The is_*() queries use the type reported by the directory listing if the OS provided one, but
+	symlink_status() always calls lstat(), so it's only used for the less common types.
+ */
+[[nodiscard]] static inline FileType getEntryType (const std::filesystem::directory_entry& entry) noexcept
 {
-	std::vector<FilesystemEntry> entries;
+	std::error_code ec;
 
-	for (const auto& dir_entry : IteratorType<Recursive> { path })
-	{
-		FilesystemEntry entry { dir_entry.path() };
+	if (entry.is_symlink (ec))
+		return FileType::symlink;
 
-		if (includeHiddenFiles || ! entry.isHidden())
-			entries.emplace_back (entry);
-	}
+	if (entry.is_directory (ec))
+		return FileType::directory;
 
-	std::sort (entries.begin(), entries.end());
+	if (entry.is_regular_file (ec))
+		return FileType::regular;
 
-	return entries;
+	return entry.symlink_status (ec).type();
 }
 
-template <bool Recursive>
-[[nodiscard]] static inline std::vector<Directory> getDirChildDirectories (const Path& path, bool includeHiddenFiles)
+/* Sorting with FilesystemEntry::operator< calls isDirectory() -- which is a stat() call -- and normalizes
+	both paths on every comparison. Instead, each entry's sort key is computed once while listing, from the
+	file type that the directory iterator already knows (on most filesystems, this comes from the d_type
+	field of the dirent, and so costs no system call at all).
+ */
+template <typename EntryType>
+struct ListedEntry final
 {
-	std::vector<Directory> entries;
+	EntryType entry;
+	Path	  absolutePath;
+	FileType  type;	 // not following symlinks
+	bool	  isDirectory;
 
-	for (const auto& dir_entry : IteratorType<Recursive> { path })
+	[[nodiscard]] bool operator< (const ListedEntry& other) const noexcept
 	{
-		if (dir_entry.is_directory() && ! dir_entry.is_symlink())  // NB. without this check, the iterator will return symlinks to directories
-		{
-			Directory dir { dir_entry.path() };
+		// the same order as FilesystemEntry::operator<, files before directories
+		if (isDirectory != other.isDirectory)
+			return other.isDirectory;
 
-			if (includeHiddenFiles || ! dir.isHidden())
-				entries.emplace_back (dir);
-		}
+		return absolutePath < other.absolutePath;
 	}
+};
 
-	std::sort (entries.begin(), entries.end());
+template <typename EntryType>
+using Listing = std::vector<ListedEntry<EntryType>>;
 
-	return entries;
-}
-
-template <bool Recursive>
-[[nodiscard]] static inline std::vector<File> getDirChildFiles (const Path& path, bool includeHiddenFiles)
+template <bool Recursive, typename EntryType, typename Filter>
+[[nodiscard]] static inline Listing<EntryType> listDirectory (const Path& path, bool includeHiddenFiles, Filter&& filter)
 {
-	std::vector<File> entries;
+	Listing<EntryType> listing;
 
 	for (const auto& dir_entry : IteratorType<Recursive> { path })
 	{
-		if (! (dir_entry.is_directory() || dir_entry.is_symlink()))
-		{
-			File file { dir_entry.path() };
+		const auto type = getEntryType (dir_entry);
+
+		if (! filter (type))
+			continue;
 
-			if (includeHiddenFiles || ! file.isHidden())
-				entries.emplace_back (file);
+		EntryType entry { dir_entry.path() };
+
+		if (! (includeHiddenFiles || ! entry.isHidden()))
+			continue;
+
+		bool isDir;
+
+		if constexpr (std::is_same_v<EntryType, FilesystemEntry>)
+		{
+			// FilesystemEntry::isDirectory() follows symlinks, so only symlinks need to be stat'ed here
+			if (type == FileType::symlink)
+			{
+				std::error_code ec;
+				isDir = dir_entry.is_directory (ec);
+			}
+			else
+			{
+				isDir = type == FileType::directory;
+			}
+		}
+		else
+		{
+			// the File, Directory and SymLink overrides simply return a constant
+			isDir = entry.isDirectory();
 		}
+
+		auto absolutePath = entry.getAbsolutePath();
+
+		listing.push_back ({ std::move (entry), std::move (absolutePath), type, isDir });
 	}
 
-	std::sort (entries.begin(), entries.end());
+	std::sort (listing.begin(), listing.end());
+
+	return listing;
+}
+
+template <typename EntryType, typename Filter>
+[[nodiscard]] static inline Listing<EntryType> listDirectory (const Path& path, bool recurse, bool includeHiddenFiles, Filter&& filter)
+{
+	if (recurse)
+		return listDirectory<true, EntryType> (path, includeHiddenFiles, std::forward<Filter> (filter));
+
+	return listDirectory<false, EntryType> (path, includeHiddenFiles, std::forward<Filter> (filter));
+}
+
+template <typename EntryType>
+[[nodiscard]] static inline std::vector<EntryType> getEntries (Listing<EntryType>&& listing)
+{
+	std::vector<EntryType> entries;
+
+	entries.reserve (listing.size());
+
+	for (auto& listed : listing)
+		entries.emplace_back (std::move (listed.entry));
 
 	return entries;
 }
 
-template <bool Recursive>
-[[nodiscard]] static inline std::vector<SymLink> getDirChildSymLinks (const Path& path, bool includeHiddenFiles)
+[[nodiscard]] static inline bool isAnyType (FileType) noexcept
 {
-	std::vector<SymLink> entries;
+	return true;
+}
 
-	for (const auto& dir_entry : IteratorType<Recursive> { path })
+// NB. symlinks to directories are not considered directories here
+[[nodiscard]] static inline bool isDirectoryType (FileType type) noexcept
+{
+	return type == FileType::directory;
+}
+
+[[nodiscard]] static inline bool isFileType (FileType type) noexcept
+{
+	return ! (type == FileType::directory || type == FileType::symlink);
+}
+
+[[nodiscard]] static inline bool isSymLinkType (FileType type) noexcept
+{
+	return type == FileType::symlink;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------*/
+
+#pragma mark Stream
+
+struct Directory::Stream::State final
+{
+	State (const Path& directory, bool recurse, bool includeHiddenFiles)
+		: recursive (recurse), includeHidden (includeHiddenFiles)
+	{
+		std::error_code ec;
+
+		iterator = std::filesystem::recursive_directory_iterator { directory, std::filesystem::directory_options::skip_permission_denied, ec };
+
+		if (ec)
+			iterator = {};
+	}
+
+	// returns false once there are no more entries
+	[[nodiscard]] bool next()
 	{
-		if (dir_entry.is_symlink())
+		while (true)
 		{
-			SymLink link { dir_entry.path() };
+			std::error_code ec;
+
+			if (started)
+			{
+				if (! recursive)
+					iterator.disable_recursion_pending();
+
+				iterator.increment (ec);
+
+				if (ec)
+					iterator = {};
+			}
+
+			started = true;
+
+			if (iterator == std::filesystem::recursive_directory_iterator {})
+				return false;
+
+			entry = FilesystemEntry { iterator->path() };
+
+			if (! (includeHidden || ! entry.isHidden()))
+				continue;
 
-			if (includeHiddenFiles || ! link.isHidden())
-				entries.emplace_back (link);
+			type = getEntryType (*iterator);
+
+			return true;
 		}
 	}
 
-	std::sort (entries.begin(), entries.end());
+	std::filesystem::recursive_directory_iterator iterator;
 
-	return entries;
-}
+	FilesystemEntry entry;
+
+	FileType type { FileType::none };
+
+	bool recursive, includeHidden, started { false };
+};
+
+/*-------------------------------------------------------------------------------------------------------------------------*/
 
 std::vector<File> Directory::getChildFiles (bool recurse, bool includeHiddenFiles) const
 {
 	if (! exists())
 		return {};
 
-	if (recurse)
-		return getDirChildFiles<true> (getAbsolutePath(), includeHiddenFiles);
-
-	return getDirChildFiles<false> (getAbsolutePath(), includeHiddenFiles);
+	return getEntries (listDirectory<File> (getAbsolutePath(), recurse, includeHiddenFiles, isFileType));
 }
 
 void Directory::iterateFiles (FileCallback&& callback, bool recurse, bool includeHiddenFiles) const
 {
-	for (const auto& file : getChildFiles (recurse, includeHiddenFiles))
-		callback (file);
+	Stream::State stream { getAbsolutePath(), recurse, includeHiddenFiles };
+
+	while (stream.next())
+		if (isFileType (stream.type))
+			callback (File { stream.entry.getPath() });
 }
 
 bool Directory::containsSubdirectories() const
@@ -273,16 +423,16 @@ std::vector<Directory> Directory::getChildDirectories (bool recurse, bool includ
 	if (! exists())
 		return {};
 
-	if (recurse)
-		return getDirChildDirectories<true> (getAbsolutePath(), includeHiddenFiles);
-
-	return getDirChildDirectories<false> (getAbsolutePath(), includeHiddenFiles);
+	return getEntries (listDirectory<Directory> (getAbsolutePath(), recurse, includeHiddenFiles, isDirectoryType));
 }
 
 void Directory::iterateDirectories (DirectoryCallback&& callback, bool recurse, bool includeHiddenFiles) const
 {
-	for (const auto& dir : getChildDirectories (recurse, includeHiddenFiles))
-		callback (dir);
+	Stream::State stream { getAbsolutePath(), recurse, includeHiddenFiles };
+
+	while (stream.next())
+		if (isDirectoryType (stream.type))
+			callback (Directory { stream.entry.getPath() });
 }
 
 std::vector<SymLink> Directory::getChildSymLinks (bool recurse, bool includeHiddenFiles) const
@@ -290,16 +440,16 @@ std::vector<SymLink> Directory::getChildSymLinks (bool recurse, bool includeHidd
 	if (! exists())
 		return {};
 
-	if (recurse)
-		return getDirChildSymLinks<true> (getAbsolutePath(), includeHiddenFiles);
-
-	return getDirChildSymLinks<false> (getAbsolutePath(), includeHiddenFiles);
+	return getEntries (listDirectory<SymLink> (getAbsolutePath(), recurse, includeHiddenFiles, isSymLinkType));
 }
 
 void Directory::iterateSymLinks (SymLinkCallback&& callback, bool recurse, bool includeHiddenFiles) const
 {
-	for (const auto& link : getChildSymLinks (recurse, includeHiddenFiles))
-		callback (link);
+	Stream::State stream { getAbsolutePath(), recurse, includeHiddenFiles };
+
+	while (stream.next())
+		if (isSymLinkType (stream.type))
+			callback (SymLink { stream.entry.getPath() });
 }
 
 std::vector<FilesystemEntry> Directory::getAllChildren (bool recurse, bool includeHiddenFiles) const
@@ -307,10 +457,7 @@ std::vector<FilesystemEntry> Directory::getAllChildren (bool recurse, bool inclu
 	if (! exists())
 		return {};
 
-	if (recurse)
-		return getAllDirChildren<true> (getAbsolutePath(), includeHiddenFiles);
-
-	return getAllDirChildren<false> (getAbsolutePath(), includeHiddenFiles);
+	return getEntries (listDirectory<FilesystemEntry> (getAbsolutePath(), recurse, includeHiddenFiles, isAnyType));
 }
 
 void Directory::iterateAllChildren (FileCallback&&		fileCallback,
@@ -319,33 +466,26 @@ void Directory::iterateAllChildren (FileCallback&&		fileCallback,
 									bool				recurse,
 									bool				includeHiddenFiles) const
 {
-	for (const auto& entry : getAllChildren (recurse, includeHiddenFiles))
+	Stream::State stream { getAbsolutePath(), recurse, includeHiddenFiles };
+
+	// the stream already knows the type of each entry, so there's no need to query the filesystem again
+	while (stream.next())
 	{
-		// we could try to optimize a bit by moving these if
-		// statements outside of the loop, but for the initial
-		// implementation this was the clearest to me
-		if (fileCallback != nullptr)
+		const auto& childPath = stream.entry.getPath();
+
+		if (isSymLinkType (stream.type))
 		{
-			if (const auto file = entry.getFileObject())
-			{
-				fileCallback (*file);
-				continue;
-			}
+			if (symLinkCallback != nullptr)
+				symLinkCallback (SymLink { childPath });
 		}
-
-		if (directoryCallback != nullptr)
+		else if (isDirectoryType (stream.type))
 		{
-			if (const auto dir = entry.getDirectoryObject())
-			{
-				directoryCallback (*dir);
-				continue;
-			}
+			if (directoryCallback != nullptr)
+				directoryCallback (Directory { childPath });
 		}
-
-		if (symLinkCallback != nullptr)
+		else if (fileCallback != nullptr)
 		{
-			if (const auto link = entry.getSymLinkObject())
-				symLinkCallback (*link);
+			fileCallback (File { childPath });
 		}
 	}
 }
@@ -354,21 +494,568 @@ void Directory::iterateAllChildren (FilesystemEntryCallback&& callback,
 									bool					  recurse,
 									bool					  includeHiddenFiles) const
 {
-	for (const auto& entry : getAllChildren (recurse, includeHiddenFiles))
+	for (const auto& entry : stream (recurse, includeHiddenFiles))
 		callback (entry);
 }
 
+void Directory::iterateAllChildrenInParallel (const FilesystemEntryCallback& callback,
+											 bool							includeHiddenFiles,
+											 std::size_t					numThreads) const
+{
+	if (! exists())
+		return;
+
+	parallel::walkTree (getAbsolutePath(), numThreads,
+						[&callback, includeHiddenFiles] (const std::filesystem::directory_entry& dir_entry)
+						{
+		const FilesystemEntry entry { dir_entry.path() };
+
+		if (includeHiddenFiles || ! entry.isHidden())
+			callback (entry);
+
+		return true;
+	});
+}
+
 std::uintmax_t Directory::sizeInBytes() const
+{
+	return getDiskUsage().apparentBytes;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------*/
+
+#pragma mark Disk usage
+
+namespace
+{
+
+struct UsageCounter final
+{
+	[[nodiscard]] Directory::DiskUsage getResult() const noexcept
+	{
+		return { apparentBytes.load(), allocatedBytes.load(), numFiles.load(), numDirectories.load() };
+	}
+
+	std::atomic<std::uintmax_t> apparentBytes { 0 }, allocatedBytes { 0 }, numFiles { 0 }, numDirectories { 0 };
+};
+
+#if ! (defined(_WIN32) || defined(WIN32))
+
+// each (device, inode) pair is only counted once. The set is split into shards so that
+// the walker threads don't all contend for a single lock
+class InodeSet final
+{
+public:
+	[[nodiscard]] bool insert (dev_t device, ino_t inode)
+	{
+		auto& shard = shards[static_cast<std::size_t> (inode) % numShards];
+
+		const std::lock_guard lock { shard.mutex };
+
+		return shard.inodes.emplace (device, inode).second;
+	}
+
+private:
+	struct Shard final
+	{
+		std::mutex						 mutex;
+		std::set<std::pair<dev_t, ino_t>> inodes;
+	};
+
+	static constexpr std::size_t numShards = 16;
+
+	std::array<Shard, numShards> shards;
+};
+
+#endif
+
+}  // namespace
+
+Directory::DiskUsage Directory::getDiskUsage ([[maybe_unused]] bool stayOnFilesystem, std::size_t numThreads) const
 {
 	if (! exists())
-		return 0;
+		return {};
+
+	const auto root = getAbsolutePath();
+
+	UsageCounter counter;
+
+#if defined(_WIN32) || defined(WIN32)
+	// std::filesystem can't tell us the allocated size, or identify hard links
+	parallel::walkTree (root, numThreads,
+						[&counter] (const std::filesystem::directory_entry& entry)
+						{
+		std::error_code ec;
+
+		const auto type = entry.symlink_status (ec).type();
+
+		if (type == std::filesystem::file_type::directory)
+		{
+			counter.numDirectories.fetch_add (1);
+			return true;
+		}
+
+		const auto size = type == std::filesystem::file_type::regular ? entry.file_size (ec) : 0;
+
+		if (ec)
+			return false;
+
+		counter.numFiles.fetch_add (1);
+		counter.apparentBytes.fetch_add (size);
+		counter.allocatedBytes.fetch_add (size);
+
+		return false;
+	});
+#else
+	struct stat rootInfo;
+
+	if (::stat (root.c_str(), &rootInfo) != 0)
+		return {};
+
+	InodeSet seenInodes;
+
+	// st_blocks is always in units of 512 bytes, regardless of the filesystem's block size
+	static constexpr std::uintmax_t blockSize = 512;
+
+	// du counts the space used by the directory itself
+	counter.allocatedBytes.fetch_add (static_cast<std::uintmax_t> (rootInfo.st_blocks) * blockSize);
+
+	parallel::walkTree (root, numThreads,
+						[&counter, &seenInodes, &rootInfo, stayOnFilesystem] (const std::filesystem::directory_entry& entry)
+						{
+		struct stat info;
+
+		if (::lstat (entry.path().c_str(), &info) != 0)
+			return false;
+
+		if (S_ISDIR (info.st_mode))
+		{
+			if (stayOnFilesystem && info.st_dev != rootInfo.st_dev)
+				return false;
+
+			counter.numDirectories.fetch_add (1);
+			counter.allocatedBytes.fetch_add (static_cast<std::uintmax_t> (info.st_blocks) * blockSize);
+
+			return true;
+		}
+
+		// only files with more than one link need to be remembered
+		if (info.st_nlink > 1 && ! seenInodes.insert (info.st_dev, info.st_ino))
+			return false;
+
+		counter.numFiles.fetch_add (1);
+		counter.apparentBytes.fetch_add (static_cast<std::uintmax_t> (info.st_size));
+		counter.allocatedBytes.fetch_add (static_cast<std::uintmax_t> (info.st_blocks) * blockSize);
+
+		return false;
+	});
+#endif
+
+	return counter.getResult();
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------*/
+
+#pragma mark Tree copy
+
+namespace
+{
+
+class TreeCopier final
+{
+public:
+	TreeCopier (parallel::TaskGroup& taskGroup, FilesystemEntry::CopyOptions copyOptions,
+				const Directory::CopyProgressCallback& callback)
+		: group (taskGroup), options (copyOptions), progressCallback (callback)
+	{
+	}
+
+	// creates the destination directory, then schedules its children
+	void copyDirectory (const Path& source, const Path& dest, std::size_t depth)
+	{
+		std::error_code ec;
+
+		// created with full access for the owner, so that the children can always be created; the source's permissions are applied at the end
+		const auto destIsNew = std::filesystem::create_directory (dest, ec);
 
-	std::uintmax_t result = 0;
+		if (! destIsNew && (ec || ! std::filesystem::is_directory (dest, ec)))
+		{
+			numErrors.fetch_add (1);
+			finishedScanningDirectory();
+			return;
+		}
+
+		std::filesystem::permissions (dest, std::filesystem::perms::owner_all, std::filesystem::perm_options::add, ec);
+
+		{
+			const std::lock_guard lock { directoriesMutex };
+			directories.push_back ({ source, dest, depth });
+		}
+
+		std::vector<SourceFile> files;
+
+		for (std::filesystem::directory_iterator it { source, ec };
+			 ! ec && it != std::filesystem::directory_iterator {};
+			 it.increment (ec))
+		{
+			if (group.isCancelled())
+				break;
+
+			const auto& entry = *it;
+
+			const auto type = getEntryType (entry);
+
+			if (type == FileType::directory)
+			{
+				pendingDirectories.fetch_add (1);
 
-	for (const auto& child : getAllChildren (true))
-		result += child.sizeInBytes();	// cppcheck-suppress useStlAlgorithm
+				group.run ([this, subdirectory = entry.path(), destPath = dest / entry.path().filename(), depth]
+						   { copyDirectory (subdirectory, destPath, depth + 1); });
 
-	return result;
+				continue;
+			}
+
+			if (type != FileType::regular && type != FileType::symlink)
+				continue;
+
+			auto file = findFile (entry.path(), type);
+
+			if (! file.has_value())
+			{
+				numErrors.fetch_add (1);
+				continue;
+			}
+
+			files.push_back (std::move (*file));
+
+			if (files.size() == filesPerTask)
+				scheduleFiles (std::exchange (files, {}), dest, destIsNew);
+		}
+
+		if (ec)
+			numErrors.fetch_add (1);
+
+		if (! files.empty())
+			scheduleFiles (std::move (files), dest, destIsNew);
+
+		finishedScanningDirectory();
+	}
+
+	// applies the permissions and modification times of the directories, deepest first
+	void applyDirectoryMetadata()
+	{
+		std::sort (directories.begin(), directories.end(), [] (const DirectoryRecord& a, const DirectoryRecord& b)
+				   { return a.depth > b.depth; });
+
+		for (auto levelStart = directories.begin(); levelStart != directories.end();)
+		{
+			const auto levelEnd = std::find_if (levelStart, directories.end(), [depth = levelStart->depth] (const DirectoryRecord& record)
+												{ return record.depth != depth; });
+
+			for (auto batchStart = levelStart; batchStart != levelEnd;)
+			{
+				const auto batchEnd = batchStart + std::min (static_cast<std::ptrdiff_t> (filesPerTask), levelEnd - batchStart);
+
+				group.run ([this, batchStart, batchEnd]
+						   {
+					for (auto record = batchStart; record != batchEnd; ++record)
+						copyMetadata (record->source, record->dest);
+				});
+
+				batchStart = batchEnd;
+			}
+
+			// a directory's metadata must be applied after its subdirectories', in case it isn't writable
+			group.wait();
+
+			levelStart = levelEnd;
+		}
+	}
+
+	[[nodiscard]] Directory::CopyProgress getProgress() const noexcept
+	{
+		Directory::CopyProgress progress;
+
+		progress.numFilesFound	 = numFilesFound.load();
+		progress.bytesFound		 = bytesFound.load();
+		progress.numFilesCopied	 = numFilesCopied.load();
+		progress.bytesCopied	 = bytesCopied.load();
+		progress.numFilesSkipped = numFilesSkipped.load();
+		progress.numErrors		 = numErrors.load();
+		progress.scanComplete	 = pendingDirectories.load() == 0;
+
+		return progress;
+	}
+
+	void reportProgress (bool force)
+	{
+		if (progressCallback == nullptr)
+			return;
+
+		std::unique_lock lock { callbackMutex, std::defer_lock };
+
+		// if another thread is already reporting, there's no need to wait for it
+		if (force)
+			lock.lock();
+		else if (! lock.try_lock())
+			return;
+
+		const auto now = std::chrono::steady_clock::now();
+
+		if (! force && now - lastReport < reportInterval)
+			return;
+
+		lastReport = now;
+
+		progressCallback (getProgress());
+	}
+
+	std::atomic<std::uintmax_t> numErrors { 0 };
+
+	// counts the directories that have been found but not read yet, including the root
+	std::atomic<std::size_t> pendingDirectories { 1 };
+
+private:
+	struct DirectoryRecord final
+	{
+		Path		source, dest;
+		std::size_t depth;
+	};
+
+	// a file found by the walk. Regular files are stat'ed once, when they're found, and the result is used for the copy
+	struct SourceFile final
+	{
+		Path					path;
+		FileType				type;
+		std::optional<FileInfo> info;
+	};
+
+	static constexpr std::size_t filesPerTask = 64;
+
+	static constexpr auto reportInterval = std::chrono::milliseconds (100);
+
+	static constexpr auto infoFields = FileInfo::Type | FileInfo::Size | FileInfo::ModificationTime | FileInfo::Inode;
+
+	// returns a null optional if a regular file's metadata can't be read, or it is no longer a regular file
+	[[nodiscard]] std::optional<SourceFile> findFile (const Path& path, FileType type)
+	{
+		SourceFile file { path, type, std::nullopt };
+
+		if (type == FileType::regular)
+		{
+			file.info = FileInfo::tryCreate (path, infoFields, false);
+
+			// the entry may also have been replaced by something that can't be copied since the directory was read
+			if (! file.info.has_value() || ! file.info->isFile())
+				return std::nullopt;
+
+			bytesFound.fetch_add (file.info->sizeInBytes());
+		}
+
+		numFilesFound.fetch_add (1);
+
+		return file;
+	}
+
+	void scheduleFiles (std::vector<SourceFile>&& files, const Path& destDirectory, bool destIsNew)
+	{
+		group.run ([this, files = std::move (files), destDirectory, destIsNew]
+				   {
+			for (const auto& file : files)
+			{
+				if (group.isCancelled())
+					return;
+
+				copyEntry (file, destDirectory / file.path.filename(), destIsNew);
+			}
+
+			reportProgress (false);
+		});
+	}
+
+	void finishedScanningDirectory()
+	{
+		pendingDirectories.fetch_sub (1);
+	}
+
+	// if the destination directory was created by this copy, its children can't exist yet, so they aren't looked for
+	void copyEntry (const SourceFile& source, const Path& dest, bool destIsNew)
+	{
+		using Options = FilesystemEntry::CopyOptions;
+
+		const auto isFile = source.type == FileType::regular;
+
+		auto destinationChecked = true;
+
+		if (! destIsNew)
+		{
+			if (const auto destInfo = FileInfo::tryCreate (dest, infoFields, false))
+			{
+				if (isFile && destInfo->getDevice() == source.info->getDevice() && destInfo->getInode() == source.info->getInode())
+				{
+					numErrors.fetch_add (1);
+					return;
+				}
+
+				if ((options & Options::skip_existing) != Options::none
+					|| ((options & Options::update_existing) != Options::none
+						&& isUnchanged (source, dest, *destInfo)))
+				{
+					numFilesSkipped.fetch_add (1);
+					return;
+				}
+
+				if ((options & (Options::update_existing | Options::overwrite_existing)) == Options::none)
+				{
+					numErrors.fetch_add (1);
+					return;
+				}
+
+				// anything other than a regular file is checked again by the copy engine, which will refuse to replace it
+				destinationChecked = destInfo->isFile();
+			}
+		}
+
+		try
+		{
+			if (isFile)
+			{
+				filecopy::Settings settings;
+
+				settings.options			  = Options::overwrite_existing;
+				settings.copyModificationTime = true;
+				settings.destinationChecked	  = destinationChecked;
+
+				[[maybe_unused]] const auto strategy = filecopy::copyFile (source.path, dest, settings);
+			}
+			else
+			{
+				std::error_code ec;
+
+				if (! destIsNew)
+					std::filesystem::remove (dest, ec);
+
+				std::filesystem::copy_symlink (source.path, dest);
+			}
+		}
+		catch (...)
+		{
+			numErrors.fetch_add (1);
+			return;
+		}
+
+		numFilesCopied.fetch_add (1);
+
+		if (isFile)
+			bytesCopied.fetch_add (source.info->sizeInBytes());
+	}
+
+	[[nodiscard]] static bool isUnchanged (const SourceFile& source, const Path& dest, const FileInfo& destInfo)
+	{
+		if (source.type != destInfo.getType())
+			return false;
+
+		// the modification time of a symbolic link isn't copied, and only its target matters
+		if (source.type == FileType::symlink)
+		{
+			std::error_code sourceError, destError;
+
+			return std::filesystem::read_symlink (source.path, sourceError) == std::filesystem::read_symlink (dest, destError)
+				&& ! sourceError && ! destError;
+		}
+
+		return source.info->sizeInBytes() == destInfo.sizeInBytes()
+			&& source.info->getLastModificationTime() == destInfo.getLastModificationTime();
+	}
+
+	void copyMetadata (const Path& source, const Path& dest)
+	{
+		std::error_code ec;
+
+		const auto status = std::filesystem::status (source, ec);
+
+		if (! ec)
+			std::filesystem::permissions (dest, status.permissions(), ec);
+
+		if (! ec)
+			std::filesystem::last_write_time (dest, std::filesystem::last_write_time (source, ec), ec);
+
+		if (ec)
+			numErrors.fetch_add (1);
+	}
+
+	parallel::TaskGroup& group;
+
+	const FilesystemEntry::CopyOptions options;
+
+	const Directory::CopyProgressCallback& progressCallback;
+
+	std::atomic<std::uintmax_t> numFilesFound { 0 }, bytesFound { 0 }, numFilesCopied { 0 }, bytesCopied { 0 }, numFilesSkipped { 0 };
+
+	std::mutex					   directoriesMutex;
+	std::vector<DirectoryRecord> directories;
+
+	std::mutex							  callbackMutex;
+	std::chrono::steady_clock::time_point lastReport;
+};
+
+}  // namespace
+
+Directory::CopyProgress Directory::copyTree (const Path& dest, CopyOptions options,
+											 const CopyProgressCallback& progressCallback, std::size_t numThreads) const noexcept
+{
+	Directory destDir { dest };
+
+	destDir.makeAbsoluteRelativeTo (getParentDirectory());
+
+	const auto source = getAbsolutePath();
+
+	// a copy inside the source tree would be found by the walk and copied again.
+	// The paths are compared lexically, because isBelow() queries the filesystem for every parent directory
+	const auto destPath = destDir.getAbsolutePath();
+
+	const auto isInsideSource = std::mismatch (source.begin(), source.end(), destPath.begin(), destPath.end()).first == source.end();
+
+	if (! exists() || isInsideSource)
+	{
+		CopyProgress progress;
+		progress.numErrors	  = 1;
+		progress.scanComplete = true;
+		return progress;
+	}
+
+	try
+	{
+		parallel::TaskGroup group { numThreads };
+
+		TreeCopier copier { group, options, progressCallback };
+
+		try
+		{
+			group.run ([&copier, &source, &destPath]
+					   { copier.copyDirectory (source, destPath, 0); });
+
+			group.wait();
+
+			copier.applyDirectoryMetadata();
+
+			copier.reportProgress (true);
+		}
+		catch (...)
+		{
+			// the progress callback threw an exception
+			copier.numErrors.fetch_add (1);
+		}
+
+		return copier.getProgress();
+	}
+	catch (...)
+	{
+		// creating the worker threads failed
+		CopyProgress progress;
+		progress.numErrors = 1;
+		return progress;
+	}
 }
 
 bool Directory::setAsWorkingDirectory() const
@@ -437,4 +1124,67 @@ Directory::Iterator::pointer Directory::Iterator::operator->() const
 	return &entries->at (idx);
 }
 
+/*-------------------------------------------------------------------------------------------------------------------------*/
+
+Directory::Stream Directory::stream (bool recurse, bool includeHiddenFiles) const
+{
+	return Stream { getAbsolutePath(), recurse, includeHiddenFiles };
+}
+
+Directory::Stream::Stream (const Path& directory, bool recurse, bool includeHiddenFiles)
+	: path (directory), recursive (recurse), includeHidden (includeHiddenFiles)
+{
+}
+
+Directory::Stream::Iterator Directory::Stream::begin() const
+{
+	return Iterator { *this };
+}
+
+std::default_sentinel_t Directory::Stream::end() const noexcept
+{
+	return std::default_sentinel;
+}
+
+static_assert (std::input_iterator<Directory::Stream::Iterator>);
+static_assert (std::ranges::input_range<Directory::Stream>);
+static_assert (std::ranges::view<Directory::Stream>);
+
+Directory::Stream::Iterator::Iterator() { }
+
+Directory::Stream::Iterator::Iterator (const Stream& stream)
+	: state (std::make_shared<State> (stream.path, stream.recursive, stream.includeHidden))
+{
+	if (! state->next())
+		state.reset();
+}
+
+Directory::Stream::Iterator& Directory::Stream::Iterator::operator++()
+{
+	if (state != nullptr && ! state->next())
+		state.reset();
+
+	return *this;
+}
+
+void Directory::Stream::Iterator::operator++ (int)	// NOLINT
+{
+	++(*this);
+}
+
+bool Directory::Stream::Iterator::operator== (std::default_sentinel_t) const noexcept
+{
+	return state == nullptr;
+}
+
+Directory::Stream::Iterator::reference Directory::Stream::Iterator::operator*() const
+{
+	return state->entry;
+}
+
+Directory::Stream::Iterator::pointer Directory::Stream::Iterator::operator->() const
+{
+	return &state->entry;
+}
+
 }  // namespace files
@@ -38,7 +38,11 @@
 #endif
 
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
 #include <string>
+#include <vector>
 #include "lfilesystem/lfilesystem_DynamicLibrary.h"
 
 namespace limes::files
@@ -388,18 +392,43 @@ using nlist_t			= struct nlist;
 #pragma mark Reloader
 
 DynamicLibrary::Reloader::Reloader (DynamicLibrary& libraryToReload)
-	: FileWatcher (libraryToReload.getFile()), library (libraryToReload)
+	: library (libraryToReload)
 {
+	// watching starts here and not in FileWatcher's constructor, so that events can't arrive before library is set
+	if (! start (library.getFile(), Options { .coalescingWindow = std::chrono::milliseconds { 100 } }))
+		throw std::runtime_error { "DynamicLibrary::Reloader: cannot watch the library file" };
 }
 
-void DynamicLibrary::Reloader::fileDeleted (const FilesystemEntry&)
+DynamicLibrary::Reloader::~Reloader()
 {
-	library.close();
+	stop();
 }
 
-void DynamicLibrary::Reloader::fileModified (const FilesystemEntry&)
+void DynamicLibrary::Reloader::changesDetected (const std::vector<Change>& changes)
 {
+	std::uint32_t events { 0 };
+
+	for (const auto& change : changes)
+		events |= change.events;
+
+	// the library file may have been deleted and recreated within the window
+	if ((events & Deleted) != 0 && ! getWatchedPath().exists())
+	{
+		library.close();
+		return;
+	}
+
+	if ((events & (Modified | Created | Deleted)) == 0)
+		return;
+
 	library.reload();
+
+	// a recreated file is a new inode, which the current watch doesn't cover
+	if ((events & Deleted) != 0)
+	{
+		stop();
+		start();
+	}
 }
 
 #pragma mark Listener
@@ -0,0 +1,347 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <thread>
+#include "lfilesystem_EventDispatcher.h"
+
+namespace limes::files
+{
+
+/* One background thread delivers the coalesced batches of all watchers in the process.
+
+   Batches are delivered with the delivery mutex held, so a dispatcher destroyed from another thread while its batch is
+   being delivered can wait for the delivery to finish. The delivery mutex is recursive so that a watcher can be stopped
+   or destroyed from inside changesDetected().
+ */
+class EventDispatcher::Timer final
+{
+public:
+	static Timer& get()
+	{
+		static Timer timer;
+		return timer;
+	}
+
+	~Timer()
+	{
+		{
+			const std::lock_guard lock { scheduleMutex };
+
+			stopping = true;
+		}
+
+		scheduleChanged.notify_all();
+
+		if (thread.joinable())
+			thread.join();
+	}
+
+	Timer (const Timer&)			= delete;
+	Timer& operator= (const Timer&) = delete;
+
+	void schedule (EventDispatcher& dispatcher, std::chrono::steady_clock::time_point deadline)
+	{
+		{
+			const std::lock_guard lock { scheduleMutex };
+
+			deadlines.emplace (deadline, &dispatcher);
+
+			if (! thread.joinable())
+				thread = std::thread { [this]
+									   { run(); } };
+		}
+
+		scheduleChanged.notify_all();
+	}
+
+	void remove (EventDispatcher& dispatcher)
+	{
+		bool isBeingDelivered { false };
+
+		{
+			const std::lock_guard lock { scheduleMutex };
+
+			std::erase_if (deadlines, [&dispatcher] (const auto& deadline)
+						   { return deadline.second == &dispatcher; });
+
+			if (current == &dispatcher)
+			{
+				current			 = nullptr;
+				isBeingDelivered = true;
+			}
+		}
+
+		// waits for the delivery in progress on the timer thread to finish
+		if (isBeingDelivered)
+		{
+			const std::lock_guard lock { deliveryMutex };
+		}
+	}
+
+private:
+	Timer() = default;
+
+	void run()
+	{
+		std::unique_lock lock { scheduleMutex };
+
+		while (! stopping)
+		{
+			if (deadlines.empty())
+			{
+				scheduleChanged.wait (lock);
+				continue;
+			}
+
+			const auto next = deadlines.begin();
+
+			if (scheduleChanged.wait_until (lock, next->first) != std::cv_status::timeout)
+				continue;
+
+			// the earliest deadline may have changed while waiting
+			const auto due = deadlines.begin();
+
+			if (due == deadlines.end() || due->first > std::chrono::steady_clock::now())
+				continue;
+
+			auto* const dispatcher = due->second;
+
+			deadlines.erase (due);
+
+			current = dispatcher;
+
+			lock.unlock();
+
+			{
+				const std::lock_guard delivery { deliveryMutex };
+
+				// the dispatcher's destructor clears current before it waits for the delivery mutex
+				const auto isAlive = [this, dispatcher]
+				{
+					const std::lock_guard l { scheduleMutex };
+					return current == dispatcher;
+				}();
+
+				if (isAlive)
+					dispatcher->deliverPending();
+			}
+
+			lock.lock();
+
+			current = nullptr;
+		}
+	}
+
+	std::mutex										   scheduleMutex;
+	std::condition_variable							   scheduleChanged;
+	std::multimap<std::chrono::steady_clock::time_point, EventDispatcher*> deadlines;
+	EventDispatcher*								   current { nullptr };
+	bool											   stopping { false };
+
+	std::recursive_mutex deliveryMutex;
+
+	std::thread thread;
+};
+
+/*-------------------------------------------------------------------------------------------------------------------------*/
+
+FileWatcher::EventQueue* EventDispatcher::getQueue (FileWatcher& watcher, std::size_t capacity)
+{
+	if (capacity == 0)
+		return nullptr;
+
+	auto& queue = watcher.queue;
+
+	// events queued before the watcher was restarted are kept, unless the queue has to grow
+	if (queue == nullptr || queue->getCapacity() < capacity)
+		queue = std::make_unique<FileWatcher::EventQueue> (capacity);
+
+	return queue.get();
+}
+
+EventDispatcher::EventDispatcher (FileWatcher& watcherToUse, const FileWatcher::Options& options)
+	: watcher (watcherToUse),
+	  compact (options.compactEvents),
+	  queue (compact ? nullptr : getQueue (watcher, options.queueCapacity)),
+	  window (compact || queue != nullptr ? std::chrono::milliseconds { 0 } : options.coalescingWindow)
+{
+}
+
+EventDispatcher::~EventDispatcher()
+{
+	if (window.count() > 0)
+		Timer::get().remove (*this);
+}
+
+void EventDispatcher::dispatch (FileWatcher::EventType type, const Path& path)
+{
+	if (compact)
+	{
+		using StringView = FileWatcher::Event::StringView;
+
+		const StringView fullPath { path.native() };
+
+		const auto separator = fullPath.find_last_of (Path::preferred_separator);
+
+		FileWatcher::Event event;
+
+		event.events = type;
+
+		if (separator == StringView::npos)
+		{
+			event.directory = fullPath;
+		}
+		else
+		{
+			// the parent of an entry at the root is the root itself
+			event.directory = fullPath.substr (0, std::max<std::size_t> (separator, 1));
+			event.name		= fullPath.substr (separator + 1);
+		}
+
+		deliver (event);
+		return;
+	}
+
+	if (queue != nullptr)
+	{
+		queue->push (type, path);
+		return;
+	}
+
+	if (window.count() <= 0)
+	{
+		callCallback (watcher, type, FilesystemEntry { path });
+		return;
+	}
+
+	const std::lock_guard lock { mutex };
+
+	if (const auto [it, inserted] = pendingIndices.try_emplace (path.native(), pending.size()); inserted)
+		pending.emplace_back (path, type);
+	else
+		pending[it->second].second |= type;
+
+	if (! scheduled)
+	{
+		scheduled = true;
+
+		Timer::get().schedule (*this, std::chrono::steady_clock::now() + window);
+	}
+}
+
+bool EventDispatcher::usesCompactEvents() const noexcept
+{
+	return compact;
+}
+
+void EventDispatcher::deliver (const FileWatcher::Event& event)
+{
+	watcher.eventReceived (event);
+}
+
+void EventDispatcher::notifyEventsLost()
+{
+	if (queue != nullptr)
+	{
+		queue->markEventsLost();
+		return;
+	}
+
+	watcher.eventsLost();
+}
+
+void EventDispatcher::deliverPending()
+{
+	std::vector<FileWatcher::Change> changes;
+
+	{
+		const std::lock_guard lock { mutex };
+
+		changes.reserve (pending.size());
+
+		// each path is only converted to a FilesystemEntry once per batch
+		for (const auto& [path, events] : pending)
+			changes.push_back ({ FilesystemEntry { path }, events });
+
+		pending.clear();
+		pendingIndices.clear();
+
+		scheduled = false;
+	}
+
+	// this may destroy this object, so it must be the last thing this function does
+	if (! changes.empty())
+		watcher.changesDetected (changes);
+}
+
+void EventDispatcher::callCallback (FileWatcher& watcher, FileWatcher::EventType type, const FilesystemEntry& file)
+{
+	switch (type)
+	{
+		case (FileWatcher::Accessed) : watcher.fileAccessed (file); return;
+		case (FileWatcher::MetadataChanged) : watcher.fileMetadataChanged (file); return;
+		case (FileWatcher::HandleClosed) : watcher.fileHandleClosed (file); return;
+		case (FileWatcher::Created) : watcher.fileCreated (file); return;
+		case (FileWatcher::Deleted) : watcher.fileDeleted (file); return;
+		case (FileWatcher::Modified) : watcher.fileModified (file); return;
+		case (FileWatcher::Moved) : watcher.fileMoved (file); return;
+		case (FileWatcher::Opened) : watcher.fileOpened (file); return;
+		case (FileWatcher::Other) : watcher.otherEventType (file); return;
+	}
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------*/
+
+// defined here because these are shared by all the platform-specific FileWatcher implementations
+
+Path FileWatcher::Event::getPath() const
+{
+	Path path { directory };
+
+	if (! name.empty())
+		path /= name;
+
+	return path;
+}
+
+Path FileWatcher::Event::getOldPath() const
+{
+	if (oldDirectory.empty())
+		return {};
+
+	Path path { oldDirectory };
+
+	if (! oldName.empty())
+		path /= oldName;
+
+	return path;
+}
+
+FilesystemEntry FileWatcher::Event::getEntry() const
+{
+	return FilesystemEntry { getPath() };
+}
+
+void FileWatcher::changesDetected (const std::vector<Change>& changes)
+{
+	for (const auto& change : changes)
+		for (auto type = 1U; type <= Other; type <<= 1)
+			if ((change.events & type) != 0)
+				EventDispatcher::callCallback (*this, static_cast<EventType> (type), change.file);
+}
+
+}  // namespace limes::files
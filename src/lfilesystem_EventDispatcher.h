@@ -0,0 +1,108 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "lfilesystem/lfilesystem_Export.h"
+#include "lfilesystem/lfilesystem_FileWatcher.h"
+#include "lfilesystem/lfilesystem_FilesystemEntry.h"	// for Path
+#include "lfilesystem_EventQueue.h"
+
+/** This file declares the internal class that delivers the events received by a FileWatcher backend to the watcher.
+
+	This header is not part of the library's public API.
+ */
+
+namespace limes::files
+{
+
+/** Delivers a FileWatcher's events, either immediately or coalesced into batches.
+
+	Each platform's FileWatcher backend owns one of these, and passes every event it receives to \c dispatch() .
+	If the watcher's coalescing window is zero, the matching callback is called immediately on the calling thread.
+	Otherwise, the event is merged into the pending batch, and the batch is delivered to
+	\c FileWatcher::changesDetected() from a shared background thread once the window has elapsed.
+
+	If the watcher has an event queue, events are pushed to the queue instead, and the watcher delivers them
+	from \c FileWatcher::deliverQueuedEvents() .
+
+	If the watcher uses compact events, each event is passed to \c FileWatcher::eventReceived() immediately.
+	Backends that can describe an event without building its path should check \c usesCompactEvents() and call
+	\c deliver() directly.
+ */
+class LFILE_NO_EXPORT EventDispatcher final
+{
+public:
+	EventDispatcher (FileWatcher& watcherToUse, const FileWatcher::Options& options);
+
+	/** Destructor. Any events in the pending batch are discarded.
+		Waits for a delivery of this object's batch that is in progress on another thread to finish.
+	 */
+	~EventDispatcher();
+
+	EventDispatcher (const EventDispatcher&)			= delete;
+	EventDispatcher& operator= (const EventDispatcher&) = delete;
+
+	/** Delivers or queues an event for the specified absolute path.
+		If the event is delivered immediately, the callback may destroy this object.
+	 */
+	void dispatch (FileWatcher::EventType type, const Path& path);
+
+	/** Returns true if the watcher receives compact events. */
+	[[nodiscard]] bool usesCompactEvents() const noexcept;
+
+	/** Passes a compact event to the watcher. The callback may destroy this object. */
+	void deliver (const FileWatcher::Event& event);
+
+	/** Calls \c FileWatcher::eventsLost() immediately, even if events are being coalesced.
+		The callback may destroy this object. If events are being queued, the next delivery from the queue calls it instead.
+	 */
+	void notifyEventsLost();
+
+	/** Calls the FileWatcher callback that corresponds to a single type of event. */
+	static void callCallback (FileWatcher& watcher, FileWatcher::EventType type, const FilesystemEntry& file);
+
+private:
+	class Timer;
+
+	void deliverPending();
+
+	// creates the watcher's event queue if needed
+	[[nodiscard]] static FileWatcher::EventQueue* getQueue (FileWatcher& watcher, std::size_t capacity);
+
+	FileWatcher& watcher;
+
+	const bool compact;
+
+	// owned by the watcher; null if events aren't being queued
+	FileWatcher::EventQueue* const queue;
+
+	const std::chrono::milliseconds window;
+
+	std::mutex mutex;
+
+	// the pending batch, in the order in which each path was first seen
+	std::vector<std::pair<Path, std::uint32_t>> pending;
+	std::unordered_map<Path::string_type, std::size_t> pendingIndices;
+
+	bool scheduled { false };
+};
+
+}  // namespace limes::files
@@ -0,0 +1,151 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+#include "lfilesystem_EventDispatcher.h"
+#include "lfilesystem_EventQueue.h"
+
+namespace limes::files
+{
+
+FileWatcher::EventQueue::EventQueue (std::size_t minCapacity)
+	: mask (std::bit_ceil (std::max<std::size_t> (minCapacity, 2)) - 1),
+	  slots (std::make_unique<Slot[]> (mask + 1))
+{
+	// a slot is free for the producer at position i when its sequence is i, and full for the consumer when it is i + 1
+	for (auto i = 0UL; i <= mask; ++i)
+		slots[i].sequence.store (i, std::memory_order_relaxed);
+}
+
+bool FileWatcher::EventQueue::push (EventType type, const Path& path)
+{
+	auto position = enqueuePosition.load (std::memory_order_relaxed);
+
+	Slot* slot { nullptr };
+
+	while (true)
+	{
+		slot = &slots[position & mask];
+
+		const auto sequence = slot->sequence.load (std::memory_order_acquire);
+
+		const auto difference = static_cast<std::ptrdiff_t> (sequence) - static_cast<std::ptrdiff_t> (position);
+
+		if (difference == 0)
+		{
+			// on failure, this reloads the position that another producer claimed
+			if (enqueuePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (difference < 0)
+		{
+			// the consumer hasn't freed this slot yet, so the queue is full
+			numDropped.fetch_add (1, std::memory_order_relaxed);
+			eventsLost.store (true, std::memory_order_release);
+			return false;
+		}
+		else
+		{
+			position = enqueuePosition.load (std::memory_order_relaxed);
+		}
+	}
+
+	slot->type = type;
+	slot->path = path;
+
+	slot->sequence.store (position + 1, std::memory_order_release);
+
+	return true;
+}
+
+bool FileWatcher::EventQueue::pop (EventType& type, Path& path)
+{
+	const auto position = dequeuePosition.load (std::memory_order_relaxed);
+
+	auto& slot = slots[position & mask];
+
+	if (slot.sequence.load (std::memory_order_acquire) != position + 1)
+		return false;
+
+	type = slot.type;
+	path = std::move (slot.path);
+
+	slot.path.clear();
+
+	dequeuePosition.store (position + 1, std::memory_order_relaxed);
+
+	// hands the slot back to the producers for the next time around the ring
+	slot.sequence.store (position + mask + 1, std::memory_order_release);
+
+	return true;
+}
+
+void FileWatcher::EventQueue::markEventsLost() noexcept
+{
+	eventsLost.store (true, std::memory_order_release);
+}
+
+bool FileWatcher::EventQueue::checkEventsLost() noexcept
+{
+	return eventsLost.exchange (false, std::memory_order_acq_rel);
+}
+
+std::uint64_t FileWatcher::EventQueue::getNumDropped() const noexcept
+{
+	return numDropped.load (std::memory_order_relaxed);
+}
+
+std::size_t FileWatcher::EventQueue::getCapacity() const noexcept
+{
+	return mask + 1;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------*/
+
+// defined here because they are shared by all the platform-specific FileWatcher implementations
+
+std::size_t FileWatcher::deliverQueuedEvents (std::size_t maxEvents)
+{
+	if (queue == nullptr)
+		return 0;
+
+	if (queue->checkEventsLost())
+		eventsLost();
+
+	EventType type { Other };
+	Path	  path;
+
+	auto numDelivered = 0UL;
+
+	while (numDelivered < maxEvents && queue->pop (type, path))
+	{
+		EventDispatcher::callCallback (*this, type, FilesystemEntry { path });
+		++numDelivered;
+	}
+
+	return numDelivered;
+}
+
+std::uint64_t FileWatcher::getNumDroppedEvents() const noexcept
+{
+	if (queue == nullptr)
+		return 0;
+
+	return queue->getNumDropped();
+}
+
+}  // namespace limes::files
@@ -0,0 +1,99 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include "lfilesystem/lfilesystem_Export.h"
+#include "lfilesystem/lfilesystem_FileWatcher.h"
+#include "lfilesystem/lfilesystem_FilesystemEntry.h"	// for Path
+
+/** This file declares the internal queue that holds a FileWatcher's events until the application delivers them.
+
+	This header is not part of the library's public API.
+ */
+
+namespace limes::files
+{
+
+/** A bounded, lock-free queue of events, with any number of producers and a single consumer.
+
+	Each slot carries a sequence number that tells producers and the consumer whose turn it is to use the slot,
+	so pushing and popping never block, and a full queue is detected without waiting for the consumer. Pushing
+	does allocate memory for the event's path.
+
+	@see FileWatcher::Options::queueCapacity
+ */
+class LFILE_NO_EXPORT FileWatcher::EventQueue final
+{
+public:
+	/** Creates a queue with room for at least the specified number of events. */
+	explicit EventQueue (std::size_t minCapacity);
+
+	EventQueue (const EventQueue&)			  = delete;
+	EventQueue& operator= (const EventQueue&) = delete;
+
+	/** Adds an event to the queue. This may be called from any thread.
+		@returns False if the queue was full, in which case the event is dropped and counted.
+	 */
+	bool push (EventType type, const Path& path);
+
+	/** Removes the oldest event from the queue. This may only be called from one thread at a time.
+		@returns False if the queue is empty.
+	 */
+	[[nodiscard]] bool pop (EventType& type, Path& path);
+
+	/** Records that the OS dropped events, so that \c FileWatcher::eventsLost() is called by the consumer. */
+	void markEventsLost() noexcept;
+
+	/** Returns true if events were dropped or lost since the last call, and resets the flag. */
+	[[nodiscard]] bool checkEventsLost() noexcept;
+
+	/** Returns the total number of events dropped because the queue was full. */
+	[[nodiscard]] std::uint64_t getNumDropped() const noexcept;
+
+	/** Returns the number of events that the queue can hold. */
+	[[nodiscard]] std::size_t getCapacity() const noexcept;
+
+private:
+	struct Slot final
+	{
+		std::atomic<std::size_t> sequence { 0 };
+
+		EventType type { Other };
+		Path	  path;
+	};
+
+	// keeps the counters that are written by producers away from the one written by the consumer
+	static constexpr std::size_t cacheLineSize = 64;
+
+	const std::size_t mask;
+
+	const std::unique_ptr<Slot[]> slots;
+
+	alignas (cacheLineSize) std::atomic<std::size_t> enqueuePosition { 0 };
+
+	alignas (cacheLineSize) std::atomic<std::size_t> dequeuePosition { 0 };
+
+	alignas (cacheLineSize) std::atomic<std::uint64_t> numDropped { 0 };
+
+	std::atomic<bool> eventsLost { false };
+};
+
+}  // namespace limes::files
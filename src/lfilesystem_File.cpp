@@ -12,7 +12,7 @@
  * ======================================================================================
  */
 
-#include <iterator>	   // for istreambuf_iterator
+#include <iterator>
 #include <filesystem>  // for path, operator/
 #include <fstream>	   // for string, ifstream, ofstream
 #include <string>	   // for char_traits, operator+
@@ -22,10 +22,14 @@
 #include <atomic>
 #include <mutex>
 #include <algorithm>
+#include <cstring>
+#include <vector>
 #include "lfilesystem/lfilesystem_File.h"
 #include "lfilesystem/lfilesystem_SpecialDirectories.h"
 #include "lfilesystem/lfilesystem_Directory.h"		// for Directory
 #include "lfilesystem/lfilesystem_FilesystemEntry.h"	// for Path
+#include "lfilesystem_FileCopy.h"
+#include "lfilesystem_Scanner.h"
 
 #ifdef __APPLE__
 #	include <TargetConditionals.h>
@@ -192,14 +196,14 @@ std::optional<File> File::duplicate() const noexcept
 
 	const auto newFilename = [filename = getFilename (false), extension = getFileExtension(), &dir]() -> std::string
 	{
-		auto newName = filename + "_copy." + extension;
+		auto newName = filename + "_copy" + extension;
 
 		if (! dir.contains (newName))
 			return newName;
 
 		for (auto copyNum = 2; copyNum < 999; ++copyNum)
 		{
-			newName = filename + "_copy" + std::to_string (copyNum) + "." + extension;
+			newName = filename + "_copy" + std::to_string (copyNum) + extension;
 
 			if (! dir.contains (newName))
 				return newName;
@@ -220,10 +224,7 @@ std::optional<File> File::duplicate() const noexcept
 	if (newFile.exists())
 		return std::nullopt;
 
-	if (! newFile.createIfDoesntExist())
-		return std::nullopt;
-
-	if (! newFile.overwrite (loadAsString()))
+	if (! copyContentsTo (newFile.getAbsolutePath(), CopyOptions::none))
 	{
 		newFile.deleteIfExists();
 		return std::nullopt;
@@ -232,6 +233,27 @@ std::optional<File> File::duplicate() const noexcept
 	return newFile;
 }
 
+std::optional<File::CopyStrategy> File::copyContentsTo (const Path& dest, CopyOptions options) const noexcept
+{
+	FilesystemEntry newEntry { dest };
+
+	newEntry.makeAbsoluteRelativeTo (getDirectory());
+
+	try
+	{
+		auto destPath = newEntry.getAbsolutePath();
+
+		if (std::filesystem::is_directory (destPath))
+			destPath /= getAbsolutePath().filename();
+
+		return filecopy::copyFile (getAbsolutePath(), destPath, { options });
+	}
+	catch (...)
+	{
+		return std::nullopt;
+	}
+}
+
 bool File::resize (std::uintmax_t newSizeInBytes, bool allowTruncation, bool allowIncreasing) const noexcept
 {
 	if (! (allowTruncation || allowIncreasing))
@@ -304,70 +326,83 @@ std::string File::loadAsString() const noexcept
 {
 	try
 	{
-		std::ifstream stream { getAbsolutePath().c_str() };
+		// this reads the file rather than mapping it, because reading a mapping of a file that another
+		// process truncates raises SIGBUS instead of failing. The stream is opened in text mode, so on
+		// Windows, \r\n line endings are translated to \n
+		const auto filePath = getAbsolutePath();
 
-		using Iterator = std::istreambuf_iterator<char>;
+		std::ifstream stream { filePath.c_str() };
 
-		return { Iterator (stream), Iterator() };
-	}
-	catch (...)
-	{
-		return {};
-	}
-}
+		if (! stream.is_open())
+			return {};
 
-static inline std::vector<std::string> splitString (std::string_view stringToSplit,
-													std::string_view delimiter,
-													bool			 includeDelimiterInResults)
-{
-	const auto delimiterStartChar = delimiter.front();
+		static constexpr std::size_t minChunkSize = 65536;
 
-	std::vector<std::string> tokens;
+		// sized one byte larger than the file, so that a file that doesn't change is read in a single call.
+		// If the file grows meanwhile, the string grows until the end of the file is reached
+		std::error_code ec;
 
-	auto tokenStart = stringToSplit.begin();
-	auto pos		= tokenStart;
+		const auto expectedSize = std::filesystem::file_size (filePath, ec);
 
-	while (pos != stringToSplit.end())
-	{
-		if (*pos == delimiterStartChar)
-		{
-			auto delimiterStart = pos++;
+		std::string content;
 
-			while (pos != stringToSplit.end() && delimiter.find (*pos) != std::string_view::npos)
-				++pos;
+		content.resize (ec ? minChunkSize : static_cast<std::size_t> (expectedSize) + 1);
 
-			if (pos != stringToSplit.begin())
-				tokens.push_back ({ tokenStart, includeDelimiterInResults ? pos : delimiterStart });
+		std::size_t filled { 0 };
 
-			tokenStart = pos;
-		}
-		else
+		while (true)
 		{
-			++pos;
+			if (filled == content.size())
+				content.resize (std::max (content.size() * 2, minChunkSize));
+
+			stream.read (content.data() + filled, static_cast<std::streamsize> (content.size() - filled));
+
+			filled += static_cast<std::size_t> (stream.gcount());
+
+			if (! stream)
+				break;
 		}
-	}
 
-	if (pos != stringToSplit.begin())
-		tokens.push_back ({ tokenStart, pos });
+		if (stream.bad())
+			return {};
 
-	return tokens;
+		content.resize (filled);
+
+		return content;
+	}
+	catch (...)
+	{
+		return {};
+	}
 }
 
 std::vector<std::string> File::loadAsLines() const
 {
-	auto tokens = splitString (loadAsString(), "\n", false);
+	try
+	{
+		const auto content = loadAsString();
+
+		const auto tokens = scanner::split (content, "\n");
 
-	// if the newline char was \r\n, then strings will now end with \r
-	std::transform (tokens.begin(), tokens.end(), tokens.begin(),
-					[] (auto str)
-					{
-		if (str.ends_with ('\r'))
-			return str.substr (0, str.length() - 1);
+		std::vector<std::string> lines;
 
-		return str;
-	});
+		lines.reserve (tokens.size());
 
-	return tokens;
+		for (auto token : tokens)
+		{
+			// if the newline char was \r\n, then tokens will now end with \r
+			if (token.ends_with ('\r'))
+				token.remove_suffix (1);
+
+			lines.emplace_back (token);
+		}
+
+		return lines;
+	}
+	catch (...)
+	{
+		return {};
+	}
 }
 
 std::unique_ptr<std::ofstream> File::getOutputStream() const
@@ -394,58 +429,147 @@ CFile File::getCfile (CFile::Mode mode) const noexcept
 
 #pragma mark Iterator
 
+static_assert (std::input_iterator<File::Iterator>);
+static_assert (std::sentinel_for<std::default_sentinel_t, File::Iterator>);
+
+struct File::Iterator::State final
+{
+	explicit State (const Path& path)
+		: file (path, CFile::Mode::Read)
+	{
+	}
+
+	// returns false once the end of the file has been reached
+	[[nodiscard]] bool readNextLine()
+	{
+		while (true)
+		{
+			const auto* const start = buffer.data() + pos;
+
+			const auto available = filled - pos;
+
+			if (const auto* newline = scanner::findFirstOf (start, start + available, "\n");
+				newline != start + available)
+			{
+				setLine (start, static_cast<std::size_t> (newline - start));
+				pos = static_cast<std::size_t> (newline - buffer.data()) + 1;
+				return true;
+			}
+
+			if (reachedEOF)
+			{
+				if (available == 0)
+					return false;
+
+				setLine (start, available);
+				pos = filled;
+				return true;
+			}
+
+			fillBuffer();
+		}
+	}
+
+	CFile file;
+
+	std::string_view line;
+
+private:
+	void setLine (const char* start, std::size_t length) noexcept
+	{
+		// if the newline char was \r\n, then strings will now end with \r
+		if (length > 0 && start[length - 1] == '\r')
+			--length;
+
+		line = { start, length };
+	}
+
+	// moves the unread tail of the buffer to the front, then reads as much as will fit after it
+	void fillBuffer()
+	{
+		const auto remaining = filled - pos;
+
+		if (remaining > 0 && pos > 0)
+			std::memmove (buffer.data(), buffer.data() + pos, remaining);
+
+		pos	   = 0;
+		filled = remaining;
+
+		// the current line is longer than the whole buffer
+		if (filled == buffer.size())
+			buffer.resize (buffer.size() * 2);
+
+		const auto bytesRead = std::fread (buffer.data() + filled, 1, buffer.size() - filled, file.get());
+
+		filled += bytesRead;
+
+		if (bytesRead == 0)
+			reachedEOF = true;
+	}
+
+	static constexpr std::size_t initialBufferSize = 65536;
+
+	std::vector<char> buffer = std::vector<char> (initialBufferSize);
+
+	std::size_t pos { 0 }, filled { 0 };
+
+	bool reachedEOF { false };
+};
+
 File::Iterator File::begin() const
 {
-	return Iterator { loadAsLines() };
+	return Iterator { getAbsolutePath() };
 }
 
-File::Iterator File::end() const
+std::default_sentinel_t File::end() const noexcept
 {
-	return Iterator {};
+	return std::default_sentinel;
 }
 
-File::Iterator::Iterator (VectorType&& v)
-	: lines (std::make_shared<VectorType> (std::move (v)))
+File::Iterator::Iterator (const Path& path)
 {
+	try
+	{
+		auto newState = std::make_shared<State> (path);
+
+		if (newState->file.isOpen() && newState->readNextLine())
+			state = std::move (newState);
+	}
+	catch (...)
+	{
+		state.reset();
+	}
 }
 
 File::Iterator::Iterator() { }
 
 File::Iterator& File::Iterator::operator++()
 {
-	++idx;
+	// the end iterator is marked by a null state object
+	if (state != nullptr && ! state->readNextLine())
+		state.reset();
+
 	return *this;
 }
 
-File::Iterator File::Iterator::operator++ (int)	 // NOLINT
+void File::Iterator::operator++ (int)  // NOLINT
 {
-	Iterator ret { *this };
 	++(*this);
-	return ret;
-}
-
-bool File::Iterator::operator== (Iterator other)
-{
-	// the end iterator is marked by a null array of lines
-	if (other.lines == nullptr)
-		return idx == lines->size();
-
-	return idx == other.idx;
 }
 
-bool File::Iterator::operator!= (Iterator other)
+bool File::Iterator::operator== (std::default_sentinel_t) const noexcept
 {
-	return ! (*this == other);
+	return state == nullptr;
 }
 
 File::Iterator::reference File::Iterator::operator*() const
 {
-	return lines->at (idx);
+	return state->line;
 }
 
 File::Iterator::pointer File::Iterator::operator->() const
 {
-	return &lines->at (idx);
+	return &state->line;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,573 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32) || defined(WIN32)
+#	include <windows.h>
+#else
+#	include <sys/uio.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <cerrno>
+#	include <climits>
+#endif
+
+#include "lfilesystem/lfilesystem_FileAppender.h"
+#include "lfilesystem/lfilesystem_Paths.h"
+
+namespace limes::files
+{
+
+namespace
+{
+
+// one thread's buffered data
+struct ThreadBuffer final
+{
+	std::mutex mutex;
+
+	// the data appended since the last flush, guarded by the mutex
+	std::string pending;
+
+	// the data being written by the current flush, guarded by the appender's flush mutex.
+	// Swapping the two strings lets the thread keep appending while a flush is writing
+	std::string flushing;
+};
+
+#if defined(_WIN32) || defined(WIN32)
+
+using NativeHandle = HANDLE;
+
+const auto invalidHandle = INVALID_HANDLE_VALUE;
+
+[[nodiscard]] NativeHandle openForAppending (const Path& path) noexcept
+{
+	// with only FILE_APPEND_DATA access, every write goes to the current end of the file
+	return ::CreateFileW (path.wstring().c_str(), FILE_APPEND_DATA,
+						  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+						  nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+}
+
+void closeHandle (NativeHandle handle) noexcept
+{
+	::CloseHandle (handle);
+}
+
+[[nodiscard]] bool writeBuffers (NativeHandle handle, const std::vector<std::string_view>& buffers) noexcept
+{
+	for (const auto& buffer : buffers)
+	{
+		for (auto remaining = buffer; ! remaining.empty();)
+		{
+			DWORD written { 0 };
+
+			const auto chunk = static_cast<DWORD> (std::min (remaining.size(), std::size_t { 1 } << 30));
+
+			if (! ::WriteFile (handle, remaining.data(), chunk, &written, nullptr))
+				return false;
+
+			remaining.remove_prefix (written);
+		}
+	}
+
+	return true;
+}
+
+#else
+
+using NativeHandle = int;
+
+constexpr auto invalidHandle = -1;
+
+[[nodiscard]] NativeHandle openForAppending (const Path& path) noexcept
+{
+	return ::open (path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0666);
+}
+
+void closeHandle (NativeHandle handle) noexcept
+{
+	::close (handle);
+}
+
+// writes all the buffers with as few writev() calls as possible
+[[nodiscard]] bool writeBuffers (NativeHandle fd, const std::vector<std::string_view>& buffers) noexcept
+{
+#	ifdef IOV_MAX
+	static constexpr std::size_t maxVectors = IOV_MAX;
+#	else
+	static constexpr std::size_t maxVectors = 1024;
+#	endif
+
+	try
+	{
+		std::vector<iovec> vectors;
+
+		vectors.reserve (std::min (buffers.size(), maxVectors));
+
+		for (auto next = buffers.begin(); next != buffers.end();)
+		{
+			vectors.clear();
+
+			for (; next != buffers.end() && vectors.size() < maxVectors; ++next)
+				vectors.push_back ({ const_cast<char*> (next->data()), next->size() });	 // NOLINT
+
+			auto* current = vectors.data();
+			auto  count	  = static_cast<int> (vectors.size());
+
+			while (count > 0)
+			{
+				const auto result = ::writev (fd, current, count);
+
+				if (result < 0)
+				{
+					if (errno == EINTR)
+						continue;
+
+					return false;
+				}
+
+				// skip the vectors that were written completely, and advance into a partially written one
+				auto written = static_cast<std::size_t> (result);
+
+				while (count > 0 && written >= current->iov_len)
+				{
+					written -= current->iov_len;
+					++current;
+					--count;
+				}
+
+				if (count > 0)
+				{
+					current->iov_base = static_cast<char*> (current->iov_base) + written;
+					current->iov_len -= written;
+				}
+			}
+		}
+
+		return true;
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+#endif
+
+// identifies each appender, so that a thread's registration with a destroyed appender is never mistaken for another's
+std::atomic<std::uint64_t> nextAppenderID { 1 };
+
+}  // namespace
+
+class FileAppender::Impl final : public std::enable_shared_from_this<Impl>
+{
+public:
+	Impl (const Path& filepath, NativeHandle fileHandle, const Options& options)
+		: path (filepath), handle (fileHandle), bufferSize (options.bufferSize), flushInterval (options.flushInterval)
+	{
+		if (flushInterval.count() > 0)
+			flushThread = std::thread ([this]
+									   { runFlushThread(); });
+	}
+
+	~Impl()
+	{
+		if (flushThread.joinable())
+		{
+			{
+				const std::lock_guard lock { timerMutex };
+				stopping = true;
+			}
+
+			wakeUp.notify_one();
+
+			flushThread.join();
+		}
+
+		try
+		{
+			flush();
+		}
+		catch (...)
+		{
+		}
+
+		closeHandle (handle);
+	}
+
+	Impl (const Impl&)			  = delete;
+	Impl& operator= (const Impl&) = delete;
+
+	[[nodiscard]] bool append (const char* data, std::size_t numBytes)
+	{
+		if (numBytes == 0)
+			return true;
+
+		if (numBytes <= bufferSize)
+		{
+			auto& buffer = getThreadBuffer();
+
+			{
+				const std::lock_guard lock { buffer.mutex };
+
+				if (buffer.pending.size() + numBytes <= bufferSize)
+				{
+					buffer.pending.append (data, numBytes);
+					return true;
+				}
+			}
+
+			// the buffer is full, so flush it -- along with every other thread's -- to make room
+			const std::lock_guard flushLock { flushMutex };
+
+			const auto flushed = flushLocked();
+
+			const std::lock_guard lock { buffer.mutex };
+
+			buffer.pending.append (data, numBytes);
+
+			return flushed;
+		}
+
+		// this thread's buffered data must be written first, so that its data stays in order
+		const std::lock_guard flushLock { flushMutex };
+
+		auto succeeded = flushLocked();
+
+		if (! writeBuffers (handle, { std::string_view { data, numBytes } }))
+		{
+			writeFailed.store (true);
+			succeeded = false;
+		}
+
+		return succeeded;
+	}
+
+	bool flush()
+	{
+		{
+			const std::lock_guard flushLock { flushMutex };
+
+			flushLocked();
+		}
+
+		return ! writeFailed.exchange (false);
+	}
+
+	const Path path;
+
+private:
+	// the buffers that a thread has registered with appenders. When the thread exits, its buffers are flushed and removed
+	struct ThreadRegistrations final
+	{
+		struct Registration final
+		{
+			std::uint64_t		appenderID;
+			std::weak_ptr<Impl> appender;
+			ThreadBuffer*		buffer;
+		};
+
+		~ThreadRegistrations()
+		{
+			for (const auto& registration : registrations)
+				if (const auto appender = registration.appender.lock())
+					appender->unregisterBuffer (registration.buffer);
+		}
+
+		std::vector<Registration> registrations;
+	};
+
+	[[nodiscard]] ThreadBuffer& getThreadBuffer()
+	{
+		static thread_local ThreadRegistrations thisThread;
+
+		// a registration can only match while its appender is alive, so this doesn't need to lock the weak pointer
+		for (const auto& registration : thisThread.registrations)
+			if (registration.appenderID == id)
+				return *registration.buffer;
+
+		std::erase_if (thisThread.registrations, [] (const ThreadRegistrations::Registration& registration)
+					   { return registration.appender.expired(); });
+
+		auto buffer = std::make_unique<ThreadBuffer>();
+
+		buffer->pending.reserve (bufferSize);
+
+		auto* const newBuffer = buffer.get();
+
+		{
+			const std::lock_guard lock { registryMutex };
+			buffers.push_back (std::move (buffer));
+		}
+
+		thisThread.registrations.push_back ({ id, weak_from_this(), newBuffer });
+
+		return *newBuffer;
+	}
+
+	// called when a thread that has appended exits. Writes the thread's remaining data, then forgets its buffer
+	void unregisterBuffer (ThreadBuffer* buffer) noexcept
+	{
+		try
+		{
+			const std::lock_guard flushLock { flushMutex };
+
+			{
+				const std::lock_guard bufferLock { buffer->mutex };
+				buffer->pending.swap (buffer->flushing);
+			}
+
+			if (! buffer->flushing.empty() && ! writeBuffers (handle, { std::string_view { buffer->flushing } }))
+				writeFailed.store (true);
+
+			const std::lock_guard lock { registryMutex };
+
+			std::erase_if (buffers, [buffer] (const std::unique_ptr<ThreadBuffer>& registered)
+						   { return registered.get() == buffer; });
+		}
+		catch (...)
+		{
+			writeFailed.store (true);
+		}
+	}
+
+	// must be called with the flush mutex held. Returns false if the write failed
+	bool flushLocked()
+	{
+		std::vector<std::string_view> toWrite;
+		std::vector<ThreadBuffer*>	  flushed;
+
+		{
+			const std::lock_guard lock { registryMutex };
+
+			toWrite.reserve (buffers.size());
+			flushed.reserve (buffers.size());
+
+			for (const auto& buffer : buffers)
+			{
+				{
+					const std::lock_guard bufferLock { buffer->mutex };
+
+					if (buffer->pending.empty())
+						continue;
+
+					buffer->pending.swap (buffer->flushing);
+				}
+
+				toWrite.emplace_back (buffer->flushing);
+				flushed.push_back (buffer.get());
+			}
+		}
+
+		if (toWrite.empty())
+			return true;
+
+		const auto succeeded = writeBuffers (handle, toWrite);
+
+		// keep the capacity, so that appending doesn't allocate again after the next swap
+		for (auto* buffer : flushed)
+			buffer->flushing.clear();
+
+		if (! succeeded)
+			writeFailed.store (true);
+
+		return succeeded;
+	}
+
+	void runFlushThread()
+	{
+		std::unique_lock lock { timerMutex };
+
+		while (! wakeUp.wait_for (lock, flushInterval, [this]
+								  { return stopping; }))
+		{
+			lock.unlock();
+
+			{
+				const std::lock_guard flushLock { flushMutex };
+
+				flushLocked();
+			}
+
+			lock.lock();
+		}
+	}
+
+	const NativeHandle handle;
+
+	const std::size_t bufferSize;
+
+	const std::chrono::milliseconds flushInterval;
+
+	const std::uint64_t id { nextAppenderID.fetch_add (1) };
+
+	// lock order: flushMutex, then registryMutex, then a buffer's mutex
+	std::mutex flushMutex, registryMutex;
+
+	// the buffers of the threads that have appended and haven't exited yet
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+	std::atomic<bool> writeFailed { false };
+
+	std::mutex				timerMutex;
+	std::condition_variable wakeUp;
+	bool					stopping { false };
+
+	std::thread flushThread;
+};
+
+/*-------------------------------------------------------------------------------------------------------------------------*/
+
+FileAppender::FileAppender() noexcept = default;
+
+FileAppender::FileAppender (const Path& filepath) noexcept
+	: FileAppender (filepath, Options {})
+{
+}
+
+FileAppender::FileAppender (const Path& filepath, const Options& options) noexcept
+{
+	open (filepath, options);
+}
+
+FileAppender::FileAppender (FileAppender&& other) noexcept = default;
+
+FileAppender::~FileAppender() noexcept
+{
+	close();
+}
+
+FileAppender& FileAppender::operator= (FileAppender&& other) noexcept
+{
+	close();
+
+	pimpl = std::move (other.pimpl);
+
+	return *this;
+}
+
+bool FileAppender::open (const Path& filepath) noexcept
+{
+	return open (filepath, Options {});
+}
+
+bool FileAppender::open (const Path& filepath, const Options& options) noexcept
+{
+	close();
+
+	try
+	{
+		const auto path = normalizePath (filepath);
+
+		const auto handle = openForAppending (path);
+
+		if (handle == invalidHandle)
+			return false;
+
+		try
+		{
+			pimpl = std::make_shared<Impl> (path, handle, options);
+		}
+		catch (...)
+		{
+			closeHandle (handle);
+			return false;
+		}
+
+		return true;
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+bool FileAppender::close() noexcept
+{
+	if (pimpl == nullptr)
+		return true;
+
+	const auto result = flush();
+
+	pimpl.reset();
+
+	return result;
+}
+
+bool FileAppender::isOpen() const noexcept
+{
+	return pimpl != nullptr;
+}
+
+FileAppender::operator bool() const noexcept
+{
+	return isOpen();
+}
+
+bool FileAppender::append (const char* const data, std::size_t numBytes) noexcept
+{
+	if (pimpl == nullptr)
+		return false;
+
+	try
+	{
+		return pimpl->append (data, numBytes);
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+bool FileAppender::append (const std::string_view& text) noexcept
+{
+	return append (text.data(), text.size());
+}
+
+bool FileAppender::flush() noexcept
+{
+	if (pimpl == nullptr)
+		return false;
+
+	try
+	{
+		return pimpl->flush();
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+Path FileAppender::getPath() const
+{
+	if (pimpl == nullptr)
+		return {};
+
+	return pimpl->path;
+}
+
+}  // namespace limes::files
@@ -0,0 +1,60 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#pragma once
+
+#include <filesystem>
+#include "lfilesystem/lfilesystem_Export.h"
+#include "lfilesystem/lfilesystem_File.h"
+#include "lfilesystem/lfilesystem_FilesystemEntry.h"	// for Path
+
+/** This file declares the internal copy engine used to copy the content of regular files.
+
+	The copy engine is implemented in the platform specific sources in the native/ folder.
+
+	This header is not part of the library's public API.
+ */
+
+namespace limes::files::filecopy
+{
+
+/** Settings for \c copyFile() . */
+struct LFILE_NO_EXPORT Settings final
+{
+	/** Controls what happens if the destination exists. See \c copyFile() for details. */
+	std::filesystem::copy_options options { std::filesystem::copy_options::none };
+
+	/** If true, the destination is given the source's modification time. */
+	bool copyModificationTime { false };
+
+	/** If true, the caller has already checked that the destination either doesn't exist, or is a regular
+		file -- other than the source -- that should be replaced, so the destination isn't queried again.
+	 */
+	bool destinationChecked { false };
+};
+
+/** Copies a regular file, along with its permissions.
+
+	The options are interpreted as they are by \c std::filesystem::copy_file() : if the destination exists, it
+	is replaced if \c overwrite_existing is set, or if \c update_existing is set and the source is newer. If
+	\c skip_existing is set, or \c update_existing is set and the source is not newer, nothing is copied. If none
+	of these are set, an existing destination is an error.
+
+	@returns The strategy that was used to copy the data.
+	@throws std::filesystem::filesystem_error if the copy fails.
+ */
+[[nodiscard]] LFILE_NO_EXPORT File::CopyStrategy copyFile (const Path& source, const Path& dest, const Settings& settings);
+
+}  // namespace limes::files::filecopy
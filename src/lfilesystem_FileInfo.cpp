@@ -0,0 +1,412 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <system_error>
+
+#if ! (defined(_WIN32) || defined(WIN32))
+#	include <sys/stat.h>
+#	include <sys/types.h>
+#	include <fcntl.h>
+#	include <cerrno>
+#	include <ctime>
+#endif
+
+#include "lfilesystem/lfilesystem_FileInfo.h"
+
+#if defined(__linux__)
+#	include <sys/sysmacros.h>	// for makedev
+#endif
+
+#if defined(__linux__) && defined(STATX_BASIC_STATS) && defined(STATX_BTIME)
+#	define LFILE_USE_STATX 1
+#else
+#	define LFILE_USE_STATX 0
+#endif
+
+namespace limes::files
+{
+
+bool FileInfo::hasFields (Fields fieldsToCheck) const noexcept
+{
+	return (available & fieldsToCheck) == fieldsToCheck;
+}
+
+FileInfo::Fields FileInfo::getFields() const noexcept
+{
+	return available;
+}
+
+std::filesystem::file_type FileInfo::getType() const noexcept
+{
+	return type;
+}
+
+bool FileInfo::isFile() const noexcept
+{
+	return type == std::filesystem::file_type::regular;
+}
+
+bool FileInfo::isDirectory() const noexcept
+{
+	return type == std::filesystem::file_type::directory;
+}
+
+bool FileInfo::isSymLink() const noexcept
+{
+	return type == std::filesystem::file_type::symlink;
+}
+
+Permissions FileInfo::getPermissions() const noexcept
+{
+	return permissions;
+}
+
+std::uint32_t FileInfo::getOwnerID() const noexcept
+{
+	return ownerID;
+}
+
+std::uint32_t FileInfo::getGroupID() const noexcept
+{
+	return groupID;
+}
+
+std::uintmax_t FileInfo::getInode() const noexcept
+{
+	return inode;
+}
+
+std::uintmax_t FileInfo::getDevice() const noexcept
+{
+	return device;
+}
+
+std::uintmax_t FileInfo::getHardLinkCount() const noexcept
+{
+	return linkCount;
+}
+
+std::uintmax_t FileInfo::sizeInBytes() const noexcept
+{
+	return size;
+}
+
+std::uintmax_t FileInfo::getAllocatedBytes() const noexcept
+{
+	return allocated;
+}
+
+FileInfo::Time FileInfo::getLastAccessTime() const noexcept
+{
+	return accessTime;
+}
+
+FileInfo::Time FileInfo::getLastModificationTime() const noexcept
+{
+	return modificationTime;
+}
+
+FileInfo::Time FileInfo::getStatusChangeTime() const noexcept
+{
+	return statusChangeTime;
+}
+
+std::optional<FileInfo::Time> FileInfo::getCreationTime() const noexcept
+{
+	if (! hasFields (BirthTime))
+		return std::nullopt;
+
+	return birthTime;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------*/
+
+#if defined(_WIN32) || defined(WIN32)
+
+struct FileInfo::Builder final
+{
+	// std::filesystem is used on Windows, which can't provide ownership, inode or allocation information
+	[[nodiscard]] static std::optional<FileInfo> create (const Path& path, Fields fields, bool followSymLinks) noexcept
+	{
+		try
+		{
+			std::error_code ec;
+
+			const auto status = followSymLinks ? std::filesystem::status (path, ec)
+											   : std::filesystem::symlink_status (path, ec);
+
+			if (ec || ! std::filesystem::exists (status))
+				return std::nullopt;
+
+			FileInfo info;
+
+			info.type		 = status.type();
+			info.permissions = status.permissions();
+			info.available	 = Type | Mode;
+
+			if ((fields & LinkCount) != 0)
+			{
+				info.linkCount = std::filesystem::hard_link_count (path, ec);
+
+				if (! ec)
+					info.available |= LinkCount;
+			}
+
+			if ((fields & Size) != 0 && info.type == std::filesystem::file_type::regular)
+			{
+				info.size = std::filesystem::file_size (path, ec);
+
+				if (! ec)
+					info.available |= Size;
+			}
+
+			if ((fields & ModificationTime) != 0)
+			{
+				info.modificationTime = std::filesystem::last_write_time (path, ec);
+
+				if (! ec)
+					info.available |= ModificationTime;
+			}
+
+			return info;
+		}
+		catch (...)
+		{
+			return std::nullopt;
+		}
+	}
+};
+
+#else /* POSIX */
+
+template <typename Duration>
+[[nodiscard]] static inline FileInfo::Time toFileTime (std::chrono::sys_time<Duration> time) noexcept
+{
+	// some standard libraries don't implement file_clock::from_sys() yet, but those use the Unix epoch for file_clock
+	if constexpr (requires { std::chrono::file_clock::from_sys (time); })
+		return std::chrono::time_point_cast<FileInfo::Time::duration> (std::chrono::file_clock::from_sys (time));
+	else
+		return FileInfo::Time { std::chrono::duration_cast<FileInfo::Time::duration> (time.time_since_epoch()) };
+}
+
+[[nodiscard]] static inline FileInfo::Time toFileTime (std::int64_t seconds, std::int64_t nanoseconds) noexcept
+{
+	return toFileTime (std::chrono::sys_time<std::chrono::nanoseconds> { std::chrono::seconds { seconds } + std::chrono::nanoseconds { nanoseconds } });
+}
+
+[[nodiscard]] static inline FileInfo::Time toFileTime (const struct timespec& time) noexcept
+{
+	return toFileTime (static_cast<std::int64_t> (time.tv_sec), static_cast<std::int64_t> (time.tv_nsec));
+}
+
+[[nodiscard]] static inline std::filesystem::file_type getFileType (unsigned int mode) noexcept
+{
+	switch (mode & S_IFMT)
+	{
+		case (S_IFREG) : return std::filesystem::file_type::regular;
+		case (S_IFDIR) : return std::filesystem::file_type::directory;
+		case (S_IFLNK) : return std::filesystem::file_type::symlink;
+		case (S_IFBLK) : return std::filesystem::file_type::block;
+		case (S_IFCHR) : return std::filesystem::file_type::character;
+		case (S_IFIFO) : return std::filesystem::file_type::fifo;
+		case (S_IFSOCK) : return std::filesystem::file_type::socket;
+		default : return std::filesystem::file_type::unknown;
+	}
+}
+
+[[nodiscard]] static inline FSPerms getPermissionBits (unsigned int mode) noexcept
+{
+	return static_cast<FSPerms> (mode & 07777U);
+}
+
+// st_blocks is always in units of 512 bytes, regardless of the filesystem's block size
+static constexpr std::uintmax_t blockSize = 512;
+
+struct FileInfo::Builder final
+{
+	[[nodiscard]] static std::optional<FileInfo> create (const Path& path, Fields fields, bool followSymLinks) noexcept
+	{
+#	if LFILE_USE_STATX
+		struct statx stx;
+
+		const auto flags = AT_STATX_SYNC_AS_STAT | (followSymLinks ? 0 : AT_SYMLINK_NOFOLLOW);
+
+		if (statx (AT_FDCWD, path.c_str(), flags, getStatxMask (fields), &stx) == 0)
+			return fromStatx (stx, fields);
+
+		// statx() may be missing from old kernels, or blocked by a seccomp filter
+		if (errno != ENOSYS && errno != EPERM)
+			return std::nullopt;
+#	endif
+
+		struct stat info;
+
+		const auto result = followSymLinks ? ::stat (path.c_str(), &info)
+										   : ::lstat (path.c_str(), &info);
+
+		if (result != 0)
+			return std::nullopt;
+
+		return fromStat (info);
+	}
+
+private:
+#	if LFILE_USE_STATX
+	[[nodiscard]] static unsigned int getStatxMask (Fields fields) noexcept
+	{
+		unsigned int mask = 0;
+
+		if ((fields & Type) != 0) mask |= STATX_TYPE;
+		if ((fields & Mode) != 0) mask |= STATX_MODE;
+		if ((fields & LinkCount) != 0) mask |= STATX_NLINK;
+		if ((fields & Owner) != 0) mask |= STATX_UID | STATX_GID;
+		if ((fields & Inode) != 0) mask |= STATX_INO;
+		if ((fields & Size) != 0) mask |= STATX_SIZE;
+		if ((fields & Blocks) != 0) mask |= STATX_BLOCKS;
+		if ((fields & AccessTime) != 0) mask |= STATX_ATIME;
+		if ((fields & ModificationTime) != 0) mask |= STATX_MTIME;
+		if ((fields & StatusChangeTime) != 0) mask |= STATX_CTIME;
+		if ((fields & BirthTime) != 0) mask |= STATX_BTIME;
+
+		return mask;
+	}
+
+	[[nodiscard]] static FileInfo fromStatx (const struct statx& stx, Fields requested) noexcept
+	{
+		FileInfo info;
+
+		// the kernel may return fields that weren't requested, which are just as cheap to keep
+		const auto returned = stx.stx_mask;
+
+		info.device = makedev (stx.stx_dev_major, stx.stx_dev_minor);
+
+		if ((returned & STATX_TYPE) != 0)
+		{
+			info.type = getFileType (stx.stx_mode);
+			info.available |= Type;
+		}
+
+		if ((returned & STATX_MODE) != 0)
+		{
+			info.permissions = getPermissionBits (stx.stx_mode);
+			info.available |= Mode;
+		}
+
+		if ((returned & STATX_NLINK) != 0)
+		{
+			info.linkCount = stx.stx_nlink;
+			info.available |= LinkCount;
+		}
+
+		if ((returned & (STATX_UID | STATX_GID)) == (STATX_UID | STATX_GID))
+		{
+			info.ownerID = stx.stx_uid;
+			info.groupID = stx.stx_gid;
+			info.available |= Owner;
+		}
+
+		if ((returned & STATX_INO) != 0)
+		{
+			info.inode = stx.stx_ino;
+			info.available |= Inode;
+		}
+
+		if ((returned & STATX_SIZE) != 0)
+		{
+			info.size = stx.stx_size;
+			info.available |= Size;
+		}
+
+		if ((returned & STATX_BLOCKS) != 0)
+		{
+			info.allocated = stx.stx_blocks * blockSize;
+			info.available |= Blocks;
+		}
+
+		if ((returned & STATX_ATIME) != 0)
+		{
+			info.accessTime = toFileTime (stx.stx_atime.tv_sec, stx.stx_atime.tv_nsec);
+			info.available |= AccessTime;
+		}
+
+		if ((returned & STATX_MTIME) != 0)
+		{
+			info.modificationTime = toFileTime (stx.stx_mtime.tv_sec, stx.stx_mtime.tv_nsec);
+			info.available |= ModificationTime;
+		}
+
+		if ((returned & STATX_CTIME) != 0)
+		{
+			info.statusChangeTime = toFileTime (stx.stx_ctime.tv_sec, stx.stx_ctime.tv_nsec);
+			info.available |= StatusChangeTime;
+		}
+
+		// the birth time is only reported if it was requested, and the filesystem records it
+		if ((requested & BirthTime) != 0 && (returned & STATX_BTIME) != 0)
+		{
+			info.birthTime = toFileTime (stx.stx_btime.tv_sec, stx.stx_btime.tv_nsec);
+			info.available |= BirthTime;
+		}
+
+		return info;
+	}
+#	endif /* LFILE_USE_STATX */
+
+	[[nodiscard]] static FileInfo fromStat (const struct stat& st) noexcept
+	{
+		FileInfo info;
+
+		info.available = Basic;
+
+		info.type		 = getFileType (st.st_mode);
+		info.permissions = getPermissionBits (st.st_mode);
+		info.linkCount	 = static_cast<std::uintmax_t> (st.st_nlink);
+		info.ownerID	 = st.st_uid;
+		info.groupID	 = st.st_gid;
+		info.inode		 = static_cast<std::uintmax_t> (st.st_ino);
+		info.device		 = static_cast<std::uintmax_t> (st.st_dev);
+		info.size		 = static_cast<std::uintmax_t> (st.st_size);
+		info.allocated	 = static_cast<std::uintmax_t> (st.st_blocks) * blockSize;
+
+#	ifdef __APPLE__
+		info.accessTime		  = toFileTime (st.st_atimespec);
+		info.modificationTime = toFileTime (st.st_mtimespec);
+		info.statusChangeTime = toFileTime (st.st_ctimespec);
+		info.birthTime		  = toFileTime (st.st_birthtimespec);
+		info.available |= BirthTime;
+#	else
+		info.accessTime		  = toFileTime (st.st_atim);
+		info.modificationTime = toFileTime (st.st_mtim);
+		info.statusChangeTime = toFileTime (st.st_ctim);
+#	endif
+
+		return info;
+	}
+};
+
+#endif /* POSIX */
+
+std::optional<FileInfo> FileInfo::tryCreate (const Path& path, Fields fields, bool followSymLinks) noexcept
+{
+	if (path.empty())
+		return std::nullopt;
+
+	return Builder::create (path, fields, followSymLinks);
+}
+
+}  // namespace limes::files
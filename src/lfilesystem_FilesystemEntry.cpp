@@ -17,12 +17,14 @@
 #include <filesystem>	  // for path, copy, operator/, absolute, cera...
 #include <fstream>		  // for string, ofstream
 #include <string>		  // for operator<, operator>
+#include <system_error>
 #include "lfilesystem/lfilesystem_Directory.h"  // for Directory
 #include "lfilesystem/lfilesystem_File.h"		  // for File
 #include "lfilesystem/lfilesystem_SymLink.h"	  // for SymLink
 #include "lfilesystem/lfilesystem_SpecialDirectories.h"
 #include "lfilesystem/lfilesystem_Volume.h"
 #include "lfilesystem/lfilesystem_FilesystemEntry.h"
+#include "lfilesystem/lfilesystem_FileInfo.h"
 #include "lfilesystem/lfilesystem_Misc.h"
 #include "lfilesystem/lfilesystem_Paths.h"
 
@@ -438,19 +440,14 @@ bool FilesystemEntry::createIfDoesntExist() const noexcept
 
 bool FilesystemEntry::deleteIfExists() const noexcept
 {
-	if (! exists() || ! isValid())
+	// exists() follows symlinks, so a dangling symlink is left alone
+	if (! isValid() || ! exists())
 		return false;
 
-	try
-	{
-		const auto filesRemoved = std::filesystem::remove_all (getAbsolutePath());
+	// most of the trees deleted this way are small, and starting a thread pool would cost more than it saves
+	const auto result = deleteRecursively (1);
 
-		return filesRemoved > 0 && ! exists();
-	}
-	catch (...)
-	{
-		return false;
-	}
+	return result.numRemoved > 0 && result.failures.empty();
 }
 
 void FilesystemEntry::touch() const
@@ -506,6 +503,21 @@ FilesystemEntry::Time FilesystemEntry::getLastModificationTime() const noexcept
 	return std::filesystem::last_write_time (getAbsolutePath());
 }
 
+std::optional<FileInfo> FilesystemEntry::getInfo (std::uint32_t fields, bool followSymLinks) const noexcept
+{
+	if (! isValid())
+		return std::nullopt;
+
+	try
+	{
+		return FileInfo::tryCreate (getAbsolutePath(), fields, followSymLinks);
+	}
+	catch (...)
+	{
+		return std::nullopt;
+	}
+}
+
 bool FilesystemEntry::rename (const Path& newPath) noexcept
 {
 	FilesystemEntry newEntry { newPath };
@@ -529,12 +541,28 @@ bool FilesystemEntry::rename (const Path& newPath) noexcept
 	return true;
 }
 
+// regular files are copied by File::copyContentsTo(), which lets the OS clone or copy the data without it passing through user space
+static bool shouldCopyContents (const Path& source, FilesystemEntry::CopyOptions options)
+{
+	using Options = FilesystemEntry::CopyOptions;
+
+	if ((options & (Options::create_symlinks | Options::create_hard_links | Options::directories_only)) != Options::none)
+		return false;
+
+	std::error_code ec;
+
+	return std::filesystem::symlink_status (source, ec).type() == std::filesystem::file_type::regular;
+}
+
 bool FilesystemEntry::copyTo (const Path& dest, CopyOptions options) const noexcept
 {
 	FilesystemEntry newEntry { dest };
 
 	newEntry.makeAbsoluteRelativeTo (getDirectory());
 
+	if (shouldCopyContents (getAbsolutePath(), options))
+		return File { getAbsolutePath() }.copyContentsTo (newEntry.getAbsolutePath(), options).has_value();
+
 	try
 	{
 		std::filesystem::copy (getAbsolutePath(), newEntry.getAbsolutePath(), options);
@@ -582,6 +610,9 @@ bool FilesystemEntry::copyFrom (const Path& source, CopyOptions options) const n
 
 	sourceEntry.makeAbsoluteRelativeTo (getDirectory());
 
+	if (shouldCopyContents (sourceEntry.getAbsolutePath(), options))
+		return File { sourceEntry.getAbsolutePath() }.copyContentsTo (getAbsolutePath(), options).has_value();
+
 	try
 	{
 		std::filesystem::copy (sourceEntry.getAbsolutePath(), getAbsolutePath(), options);
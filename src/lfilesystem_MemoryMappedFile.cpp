@@ -0,0 +1,379 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32) || defined(WIN32)
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <cerrno>
+#endif
+
+#include "lfilesystem/lfilesystem_MemoryMappedFile.h"
+#include "lfilesystem/lfilesystem_Paths.h"
+
+namespace limes::files
+{
+
+MemoryMappedFile::MemoryMappedFile (const Path& filepath, AccessPattern accessPattern) noexcept
+{
+	open (filepath, accessPattern);
+}
+
+MemoryMappedFile::MemoryMappedFile (MemoryMappedFile&& other) noexcept
+	: data (other.data), length (other.length), mapped (other.mapped), buffer (std::move (other.buffer)), path (std::move (other.path))
+{
+	other.data	 = nullptr;
+	other.length = 0;
+	other.mapped = false;
+	other.path.clear();
+}
+
+MemoryMappedFile::~MemoryMappedFile() noexcept
+{
+	close();
+}
+
+MemoryMappedFile& MemoryMappedFile::operator= (MemoryMappedFile&& other) noexcept
+{
+	close();
+
+	data   = other.data;
+	length = other.length;
+	mapped = other.mapped;
+	buffer = std::move (other.buffer);
+	path   = std::move (other.path);
+
+	other.data	 = nullptr;
+	other.length = 0;
+	other.mapped = false;
+	other.path.clear();
+
+	return *this;
+}
+
+bool MemoryMappedFile::isOpen() const noexcept
+{
+	return ! path.empty();
+}
+
+MemoryMappedFile::operator bool() const noexcept
+{
+	return isOpen();
+}
+
+bool MemoryMappedFile::isMemoryMapped() const noexcept
+{
+	return mapped;
+}
+
+std::span<const std::byte> MemoryMappedFile::getBytes() const noexcept
+{
+	return { data, length };
+}
+
+std::string_view MemoryMappedFile::getString() const noexcept
+{
+	return { reinterpret_cast<const char*> (data), length };  // NOLINT
+}
+
+std::size_t MemoryMappedFile::size() const noexcept
+{
+	return length;
+}
+
+bool MemoryMappedFile::empty() const noexcept
+{
+	return length == 0;
+}
+
+Path MemoryMappedFile::getPath() const
+{
+	return path;
+}
+
+#if defined(_WIN32) || defined(WIN32)
+
+[[nodiscard]] static inline DWORD getFileFlags (MemoryMappedFile::AccessPattern accessPattern) noexcept
+{
+	switch (accessPattern)
+	{
+		case (MemoryMappedFile::AccessPattern::Sequential) : return FILE_FLAG_SEQUENTIAL_SCAN;
+		case (MemoryMappedFile::AccessPattern::Random) : return FILE_FLAG_RANDOM_ACCESS;
+		default : return FILE_ATTRIBUTE_NORMAL;
+	}
+}
+
+// used for files that can't be mapped, such as pipes
+[[nodiscard]] static inline bool readAll (HANDLE handle, std::vector<std::byte>& dest) noexcept
+{
+	try
+	{
+		static constexpr DWORD chunkSize = 65536;
+
+		while (true)
+		{
+			const auto prevSize = dest.size();
+
+			dest.resize (prevSize + chunkSize);
+
+			DWORD bytesRead = 0;
+
+			if (! ReadFile (handle, dest.data() + prevSize, chunkSize, &bytesRead, nullptr))
+			{
+				dest.resize (prevSize);
+
+				// a broken pipe just means the writer has finished
+				return GetLastError() == ERROR_BROKEN_PIPE;
+			}
+
+			dest.resize (prevSize + bytesRead);
+
+			if (bytesRead == 0)
+				return true;
+		}
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+bool MemoryMappedFile::open (const Path& filepath, AccessPattern accessPattern) noexcept
+{
+	close();
+
+	const auto fileHandle = CreateFileW (filepath.wstring().c_str(), GENERIC_READ,
+										 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+										 nullptr, OPEN_EXISTING, getFileFlags (accessPattern), nullptr);
+
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+
+	if (GetFileType (fileHandle) == FILE_TYPE_DISK
+		&& GetFileSizeEx (fileHandle, &fileSize)
+		&& fileSize.QuadPart > 0)
+	{
+		if (auto* mapping = CreateFileMappingW (fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr))
+		{
+			// the view keeps the mapping object alive, so both handles can be closed now
+			const auto* view = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+
+			CloseHandle (mapping);
+
+			if (view != nullptr)
+			{
+				CloseHandle (fileHandle);
+
+				data   = static_cast<const std::byte*> (view);
+				length = static_cast<std::size_t> (fileSize.QuadPart);
+				mapped = true;
+				path   = normalizePath (filepath);
+
+				advise (accessPattern);
+
+				return true;
+			}
+		}
+	}
+
+	const auto success = readAll (fileHandle, buffer);
+
+	CloseHandle (fileHandle);
+
+	if (! success)
+	{
+		buffer.clear();
+		return false;
+	}
+
+	data   = buffer.data();
+	length = buffer.size();
+	path   = normalizePath (filepath);
+
+	return true;
+}
+
+void MemoryMappedFile::close() noexcept
+{
+	if (mapped && data != nullptr)
+		UnmapViewOfFile (data);
+
+	data   = nullptr;
+	length = 0;
+	mapped = false;
+
+	buffer.clear();
+	buffer.shrink_to_fit();
+
+	path.clear();
+}
+
+bool MemoryMappedFile::advise (AccessPattern accessPattern) const noexcept
+{
+	if (! mapped)
+		return false;
+
+#	if defined(_WIN32_WINNT) && (_WIN32_WINNT >= 0x0602)  // PrefetchVirtualMemory requires Windows 8
+	if (accessPattern == AccessPattern::WillNeed)
+	{
+		WIN32_MEMORY_RANGE_ENTRY range;
+
+		range.VirtualAddress = const_cast<std::byte*> (data);  // NOLINT
+		range.NumberOfBytes	 = length;
+
+		return PrefetchVirtualMemory (GetCurrentProcess(), 1, &range, 0);
+	}
+#	endif
+
+	return accessPattern == AccessPattern::Normal;
+}
+
+#else /* POSIX */
+
+// used for files that can't be mapped, such as pipes or the pseudo-files in /proc
+[[nodiscard]] static inline bool readAll (int fd, std::vector<std::byte>& dest) noexcept
+{
+	try
+	{
+		static constexpr std::size_t chunkSize = 65536;
+
+		while (true)
+		{
+			const auto prevSize = dest.size();
+
+			dest.resize (prevSize + chunkSize);
+
+			const auto bytesRead = ::read (fd, dest.data() + prevSize, chunkSize);
+
+			if (bytesRead < 0)
+			{
+				dest.resize (prevSize);
+
+				if (errno == EINTR)
+					continue;
+
+				return false;
+			}
+
+			dest.resize (prevSize + static_cast<std::size_t> (bytesRead));
+
+			if (bytesRead == 0)
+				return true;
+		}
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+bool MemoryMappedFile::open (const Path& filepath, AccessPattern accessPattern) noexcept
+{
+	close();
+
+	const auto fd = ::open (filepath.c_str(), O_RDONLY | O_CLOEXEC);
+
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+
+	// files in /proc report a size of 0, so the only way to know their size is to read them
+	if (fstat (fd, &info) == 0 && S_ISREG (info.st_mode) && info.st_size > 0)
+	{
+		const auto fileSize = static_cast<std::size_t> (info.st_size);
+
+		auto* view = mmap (nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (view != MAP_FAILED)
+		{
+			// the mapping stays valid after the descriptor is closed
+			::close (fd);
+
+			data   = static_cast<const std::byte*> (view);
+			length = fileSize;
+			mapped = true;
+			path   = normalizePath (filepath);
+
+			advise (accessPattern);
+
+			return true;
+		}
+	}
+
+	const auto success = readAll (fd, buffer);
+
+	::close (fd);
+
+	if (! success)
+	{
+		buffer.clear();
+		return false;
+	}
+
+	data   = buffer.data();
+	length = buffer.size();
+	path   = normalizePath (filepath);
+
+	return true;
+}
+
+void MemoryMappedFile::close() noexcept
+{
+	if (mapped && data != nullptr)
+		munmap (const_cast<std::byte*> (data), length);	 // NOLINT
+
+	data   = nullptr;
+	length = 0;
+	mapped = false;
+
+	buffer.clear();
+	buffer.shrink_to_fit();
+
+	path.clear();
+}
+
+[[nodiscard]] static inline int getAdvice (MemoryMappedFile::AccessPattern accessPattern) noexcept
+{
+	switch (accessPattern)
+	{
+		case (MemoryMappedFile::AccessPattern::Sequential) : return POSIX_MADV_SEQUENTIAL;
+		case (MemoryMappedFile::AccessPattern::Random) : return POSIX_MADV_RANDOM;
+		case (MemoryMappedFile::AccessPattern::WillNeed) : return POSIX_MADV_WILLNEED;
+		default : return POSIX_MADV_NORMAL;
+	}
+}
+
+bool MemoryMappedFile::advise (AccessPattern accessPattern) const noexcept
+{
+	if (! mapped)
+		return false;
+
+	return posix_madvise (const_cast<std::byte*> (data), length, getAdvice (accessPattern)) == 0;	// NOLINT
+}
+
+#endif /* POSIX */
+
+}  // namespace limes::files
@@ -0,0 +1,52 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#include "lfilesystem/lfilesystem_Directory.h"
+#include "lfilesystem/lfilesystem_MountWatcher.h"
+
+namespace limes::files
+{
+
+MountWatcher::MountWatcher (const Volume& volumeToWatch, const Options& optionsToUse)
+	: FileWatcher (Directory { volumeToWatch.getPath() }, getVolumeOptions (optionsToUse))
+{
+}
+
+bool MountWatcher::start (const Volume& volumeToWatch, const Options& optionsToUse)
+{
+	return FileWatcher::start (Directory { volumeToWatch.getPath() }, getVolumeOptions (optionsToUse));
+}
+
+std::optional<Volume> MountWatcher::getVolume() const
+{
+	const auto path = getWatchedPath();
+
+	if (! path.isValid())
+		return std::nullopt;
+
+	return Volume::tryCreate (path.getAbsolutePath());
+}
+
+FileWatcher::Options MountWatcher::getVolumeOptions (const Options& options) noexcept
+{
+	auto volumeOptions = options;
+
+	volumeOptions.recursive = true;
+	volumeOptions.backend	= Backend::VolumeWide;
+
+	return volumeOptions;
+}
+
+}  // namespace limes::files
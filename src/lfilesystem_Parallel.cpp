@@ -0,0 +1,361 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "lfilesystem_Parallel.h"
+
+namespace limes::files::parallel
+{
+
+std::size_t getNumThreads (std::size_t numThreads) noexcept
+{
+	if (numThreads > 0)
+		return numThreads;
+
+	// hardware_concurrency() may return 0 if the value can't be determined
+	return std::max (std::thread::hardware_concurrency(), 1U);
+}
+
+// the worker that the current thread belongs to, if any
+static thread_local const TaskGroup* currentGroup { nullptr };
+static thread_local std::size_t		 currentWorkerIndex { 0 };
+
+TaskGroup::TaskGroup (std::size_t numThreads)
+{
+	numThreads = parallel::getNumThreads (numThreads);
+
+	workers.reserve (numThreads);
+
+	for (auto i = 0UL; i < numThreads; ++i)
+		workers.emplace_back (std::make_unique<Worker>());
+
+	try
+	{
+		threads.reserve (numThreads);
+
+		for (auto i = 0UL; i < numThreads; ++i)
+			threads.emplace_back ([this, i]
+								  { workerLoop (i); });
+	}
+	catch (...)
+	{
+		// the threads that did start must be joined before they're destroyed, or the process is terminated
+		{
+			const std::lock_guard lock { stateMutex };
+			stopping = true;
+		}
+
+		workAvailable.notify_all();
+
+		for (auto& thread : threads)
+			thread.join();
+
+		throw;
+	}
+}
+
+TaskGroup::~TaskGroup() noexcept
+{
+	{
+		std::unique_lock lock { stateMutex };
+
+		allDone.wait (lock, [this]
+					  { return pending.load() == 0; });
+
+		stopping = true;
+	}
+
+	workAvailable.notify_all();
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+void TaskGroup::run (Task&& task)
+{
+	pending.fetch_add (1);
+
+	{
+		// counted before the task is published, so that a worker that takes it straight away can't make the
+		// count wrap around. Modified with the lock held, so that a worker can't miss the notification while
+		// going to sleep
+		const std::lock_guard lock { stateMutex };
+
+		queued.fetch_add (1);
+	}
+
+	// tasks created by a worker go to that worker's own queue, other tasks are shared out between the workers
+	const auto workerIndex = currentGroup == this
+							   ? currentWorkerIndex
+							   : nextWorker.fetch_add (1) % workers.size();
+
+	try
+	{
+		auto& worker = *workers[workerIndex];
+
+		const std::lock_guard lock { worker.mutex };
+
+		worker.tasks.emplace_back (std::move (task));
+	}
+	catch (...)
+	{
+		queued.fetch_sub (1);
+		taskFinished();
+		throw;
+	}
+
+	workAvailable.notify_one();
+}
+
+void TaskGroup::wait()
+{
+	std::unique_lock lock { stateMutex };
+
+	allDone.wait (lock, [this]
+				  { return pending.load() == 0; });
+
+	cancelled.store (false);
+
+	if (error != nullptr)
+		std::rethrow_exception (std::exchange (error, nullptr));
+}
+
+void TaskGroup::cancel() noexcept
+{
+	cancelled.store (true);
+}
+
+bool TaskGroup::isCancelled() const noexcept
+{
+	return cancelled.load();
+}
+
+std::size_t TaskGroup::getNumThreads() const noexcept
+{
+	return threads.size();
+}
+
+bool TaskGroup::popTask (std::size_t workerIndex, Task& task)
+{
+	auto& worker = *workers[workerIndex];
+
+	const std::lock_guard lock { worker.mutex };
+
+	if (worker.tasks.empty())
+		return false;
+
+	task = std::move (worker.tasks.back());
+	worker.tasks.pop_back();
+
+	queued.fetch_sub (1);
+
+	return true;
+}
+
+bool TaskGroup::stealTask (std::size_t thiefIndex, Task& task)
+{
+	const auto numWorkers = workers.size();
+
+	for (auto offset = 1UL; offset < numWorkers; ++offset)
+	{
+		auto& victim = *workers[(thiefIndex + offset) % numWorkers];
+
+		const std::lock_guard lock { victim.mutex };
+
+		if (victim.tasks.empty())
+			continue;
+
+		task = std::move (victim.tasks.front());
+		victim.tasks.pop_front();
+
+		queued.fetch_sub (1);
+
+		return true;
+	}
+
+	return false;
+}
+
+void TaskGroup::runTask (Task& task) noexcept
+{
+	if (! isCancelled())
+	{
+		try
+		{
+			task();
+		}
+		catch (...)
+		{
+			{
+				const std::lock_guard lock { stateMutex };
+
+				if (error == nullptr)
+					error = std::current_exception();
+			}
+
+			cancel();
+		}
+	}
+
+	// release anything captured by the task before reporting it as done
+	task = nullptr;
+
+	taskFinished();
+}
+
+void TaskGroup::taskFinished() noexcept
+{
+	if (pending.fetch_sub (1) == 1)
+	{
+		const std::lock_guard lock { stateMutex };
+
+		allDone.notify_all();
+	}
+}
+
+void TaskGroup::workerLoop (std::size_t workerIndex)
+{
+	currentGroup	   = this;
+	currentWorkerIndex = workerIndex;
+
+	while (true)
+	{
+		Task task;
+
+		if (popTask (workerIndex, task) || stealTask (workerIndex, task))
+		{
+			runTask (task);
+			continue;
+		}
+
+		std::unique_lock lock { stateMutex };
+
+		workAvailable.wait (lock, [this]
+							{ return stopping || queued.load() > 0; });
+
+		if (stopping)
+			return;
+	}
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------*/
+
+namespace
+{
+
+class TreeWalker final
+{
+public:
+	TreeWalker (std::size_t numThreadsToUse, const Visitor& visitorToUse) noexcept
+		: numThreads (getNumThreads (numThreadsToUse)), visitor (visitorToUse)
+	{
+	}
+
+	void walk (const Path& root) const
+	{
+		// the calling thread walks the tree on its own until it has seen enough entries to be worth
+		// starting the workers for, so that small trees never pay for a thread pool
+		std::vector<Path> directories { root };
+
+		std::size_t numEntriesSeen { 0 };
+
+		while (! directories.empty() && (numThreads == 1 || numEntriesSeen < serialEntryLimit))
+		{
+			const auto directory = std::move (directories.back());
+			directories.pop_back();
+
+			numEntriesSeen += readDirectory (directory, nullptr,
+											 [&directories] (Path&& subdirectory)
+											 { directories.push_back (std::move (subdirectory)); });
+		}
+
+		if (directories.empty())
+			return;
+
+		TaskGroup group { numThreads };
+
+		for (auto& directory : directories)
+			schedule (group, std::move (directory));
+
+		group.wait();
+	}
+
+private:
+	void schedule (TaskGroup& group, Path&& directory) const
+	{
+		group.run ([this, &group, directory = std::move (directory)]
+				   {
+			readDirectory (directory, &group,
+						   [this, &group] (Path&& subdirectory)
+						   { schedule (group, std::move (subdirectory)); });
+		});
+	}
+
+	// calls the visitor for each entry in the directory, and passes each subdirectory to walk into to
+	// the callback. Returns the number of entries read
+	template <typename SubdirectoryCallback>
+	std::size_t readDirectory (const Path& directory, const TaskGroup* group, SubdirectoryCallback&& walkInto) const
+	{
+		std::size_t numEntries { 0 };
+
+		std::error_code ec;
+
+		for (std::filesystem::directory_iterator it { directory, std::filesystem::directory_options::skip_permission_denied, ec };
+			 ! ec && it != std::filesystem::directory_iterator {};
+			 it.increment (ec))
+		{
+			if (group != nullptr && group->isCancelled())
+				break;
+
+			++numEntries;
+
+			const auto& entry = *it;
+
+			if (! visitor (entry))
+				continue;
+
+			// is_symlink() and is_directory() use the type reported by the directory listing if the OS
+			// provided one, whereas symlink_status() always calls lstat()
+			std::error_code typeError;
+
+			if (! entry.is_symlink (typeError) && entry.is_directory (typeError))
+				walkInto (Path { entry.path() });
+		}
+
+		return numEntries;
+	}
+
+	static constexpr std::size_t serialEntryLimit = 1024;
+
+	const std::size_t numThreads;
+	const Visitor&	  visitor;
+};
+
+}  // namespace
+
+void walkTree (const Path& root, std::size_t numThreads, const Visitor& visitor)
+{
+	const TreeWalker walker { numThreads, visitor };
+
+	walker.walk (root);
+}
+
+}  // namespace limes::files::parallel
@@ -0,0 +1,144 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "lfilesystem/lfilesystem_Export.h"
+#include "lfilesystem/lfilesystem_FilesystemEntry.h"	// for Path
+
+/** This file declares the internal thread pool used by the library's parallel filesystem operations.
+
+	This header is not part of the library's public API.
+ */
+
+namespace limes::files::parallel
+{
+
+/** Returns the number of threads to use if the user requested \c numThreads threads.
+	A request for 0 threads returns the number of hardware threads.
+ */
+[[nodiscard]] LFILE_NO_EXPORT std::size_t getNumThreads (std::size_t numThreads) noexcept;
+
+/** A group of worker threads that run tasks until the group is waited on.
+
+	Each worker owns a queue of tasks. Tasks scheduled from inside a running task are pushed to the
+	back of the current worker's queue, and each worker takes tasks from the back of its own queue,
+	so that a worker proceeds depth-first through the work it creates. An idle worker steals from
+	the front of another worker's queue, which is where the oldest -- and usually largest -- pieces
+	of work are.
+
+	If a task throws an exception, any tasks that haven't started yet are skipped, and the exception
+	is rethrown from \c wait() .
+ */
+class LFILE_NO_EXPORT TaskGroup final
+{
+public:
+	using Task = std::function<void()>;
+
+	/** Creates a group with the specified number of worker threads.
+		If \c numThreads is 0, the number of hardware threads is used.
+		@throws std::system_error If a thread can't be started. Any threads that were started are stopped first.
+	 */
+	explicit TaskGroup (std::size_t numThreads = 0);
+
+	/** Destructor. Waits for all scheduled tasks to finish, then stops the worker threads.
+		Any exception thrown by a task that was not rethrown by \c wait() is discarded.
+	 */
+	~TaskGroup() noexcept;
+
+	TaskGroup (const TaskGroup&)			= delete;
+	TaskGroup& operator= (const TaskGroup&) = delete;
+
+	/** Schedules a task to be run on one of the worker threads. This may be called from inside a running task. */
+	void run (Task&& task);
+
+	/** Blocks until all scheduled tasks -- including any tasks they schedule -- have finished.
+		This must not be called from inside a task.
+		@throws Rethrows the first exception thrown by a task, if any.
+	 */
+	void wait();
+
+	/** Causes all tasks that haven't started yet to be skipped. Tasks that are already running are not interrupted. */
+	void cancel() noexcept;
+
+	/** Returns true if \c cancel() has been called, or a task has thrown an exception. */
+	[[nodiscard]] bool isCancelled() const noexcept;
+
+	/** Returns the number of worker threads in this group. */
+	[[nodiscard]] std::size_t getNumThreads() const noexcept;
+
+private:
+	struct Worker final
+	{
+		std::mutex		 mutex;
+		std::deque<Task> tasks;
+	};
+
+	[[nodiscard]] bool popTask (std::size_t workerIndex, Task& task);
+	[[nodiscard]] bool stealTask (std::size_t thiefIndex, Task& task);
+
+	void runTask (Task& task) noexcept;
+
+	// called once a scheduled task has run, or couldn't be scheduled
+	void taskFinished() noexcept;
+
+	void workerLoop (std::size_t workerIndex);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	std::vector<std::thread> threads;
+
+	// pending counts the tasks that are queued or running; queued only counts the tasks waiting in a queue
+	std::atomic<std::size_t> pending { 0 }, queued { 0 }, nextWorker { 0 };
+
+	std::atomic<bool> cancelled { false };
+
+	std::mutex				stateMutex;
+	std::condition_variable workAvailable, allDone;
+	bool					stopping { false };
+
+	std::exception_ptr error;
+};
+
+/** A function called for each entry found by \c walkTree() . This will be called concurrently from multiple threads.
+	If the entry is a directory, the function should return true to walk into it, or false to skip it. The return
+	value is ignored for entries that are not directories.
+ */
+using Visitor = std::function<bool (const std::filesystem::directory_entry&)>;
+
+/** Walks the tree below a directory in parallel, calling the visitor for every entry found.
+
+	The calling thread walks the tree on its own until it has seen about a thousand entries, so small trees are
+	walked without starting any threads. After that, each remaining subdirectory is read by a separate task,
+	so the walk fans out across the worker threads as it descends. If \c numThreads is 1, the whole tree is
+	walked on the calling thread. Symbolic links to directories are not followed, and directories that can't
+	be read are skipped.
+
+	@throws Rethrows the first exception thrown by the visitor, if any. Once the visitor has thrown, no more
+	directories are read.
+ */
+LFILE_NO_EXPORT void walkTree (const Path& root, std::size_t numThreads, const Visitor& visitor);
+
+}  // namespace limes::files::parallel
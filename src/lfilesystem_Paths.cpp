@@ -23,6 +23,7 @@
 #include <algorithm>
 #include <vector>
 #include "lfilesystem/lfilesystem_Misc.h"
+#include "lfilesystem_Scanner.h"
 
 namespace limes::files
 {
@@ -249,43 +250,6 @@ Path normalizePath (const Path& path)
 	return str;
 }
 
-[[nodiscard]] static inline std::vector<std::string> splitString (std::string_view stringToSplit,
-																  std::string_view delimiter,
-																  bool			 includeDelimiterInResults)
-{
-	const auto delimiterStartChar = delimiter.front();
-
-	std::vector<std::string> tokens;
-
-	auto tokenStart = stringToSplit.begin();
-	auto pos		= tokenStart;
-
-	while (pos != stringToSplit.end())
-	{
-		if (*pos == delimiterStartChar)
-		{
-			auto delimiterStart = pos++;
-
-			while (pos != stringToSplit.end() && delimiter.find (*pos) != std::string_view::npos)
-				++pos;
-
-			if (pos != stringToSplit.begin())
-				tokens.push_back ({ tokenStart, includeDelimiterInResults ? pos : delimiterStart });
-
-			tokenStart = pos;
-		}
-		else
-		{
-			++pos;
-		}
-	}
-
-	if (pos != stringToSplit.begin())
-		tokens.push_back ({ tokenStart, pos });
-
-	return tokens;
-}
-
 Path largestCommonPrefix (const Path& path1, const Path& path2)
 {
 	const auto a = normalizePath (path1);
@@ -301,8 +265,8 @@ Path largestCommonPrefix (const Path& path1, const Path& path2)
 	const auto bStr = b.string();
 
 	// TODO: support \ on Windows
-	const auto aChunks = splitString (aStr, "/", false);
-	const auto bChunks = splitString (bStr, "/", false);
+	const auto aChunks = scanner::split (aStr, "/");
+	const auto bChunks = scanner::split (bStr, "/");
 
 	Path result;
 
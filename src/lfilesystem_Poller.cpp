@@ -0,0 +1,134 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+#include "lfilesystem_Poller.h"
+
+namespace limes::files
+{
+
+FileWatcher::Poller::Poller (FileWatcher& parent, const FilesystemEntry& fileToWatch, const Options& options)
+	: dispatcher (parent, options),
+	  watchedPath (fileToWatch.getAbsolutePath()),
+	  recursive (options.recursive),
+	  maxEntries (options.maxSnapshotEntries > 0 ? options.maxSnapshotEntries : defaultMaxEntries),
+	  interval (options.pollInterval),
+	  cpuBudget (std::clamp (options.pollCpuBudget, 0.001, 1.))
+{
+#if defined(__EMSCRIPTEN__) && ! defined(__EMSCRIPTEN_PTHREADS__)
+	// without pthreads, std::thread can't start a thread at all
+	throw std::runtime_error { "FileWatcher requires thread support, which this build doesn't have" };
+#else
+	if (! snapshot.take (watchedPath, recursive, maxEntries))
+		throw std::runtime_error { "FileWatcher failed to initialize" };
+
+	try
+	{
+		thread = std::thread { [this, sharedState = state]
+							   { run (sharedState); } };
+	}
+	catch (const std::system_error&)
+	{
+		throw std::runtime_error { "FileWatcher failed to start its polling thread" };
+	}
+#endif
+}
+
+FileWatcher::Poller::~Poller()
+{
+	{
+		const std::lock_guard lock { state->mutex };
+		state->stopping.store (true);
+	}
+
+	state->wakeUp.notify_all();
+
+	// if a callback is destroying the watcher, the thread notices that it was stopped once the callback returns
+	if (thread.get_id() == std::this_thread::get_id())
+		thread.detach();
+	else
+		thread.join();
+}
+
+void FileWatcher::Poller::run (const std::shared_ptr<State>& sharedState)
+{
+	while (true)
+	{
+		// a poll that took t seconds is followed by a pause of at least t * (1 - budget) / budget
+		const auto budgetedPause = std::chrono::duration_cast<std::chrono::steady_clock::duration> (
+			lastPollDuration * ((1. - cpuBudget) / cpuBudget));
+
+		const auto pause = std::max<std::chrono::steady_clock::duration> (interval, budgetedPause);
+
+		{
+			std::unique_lock lock { sharedState->mutex };
+
+			if (sharedState->wakeUp.wait_for (lock, pause, [&sharedState]
+											  { return sharedState->stopping.load(); }))
+				return;
+		}
+
+		if (! poll (*sharedState))
+			return;
+	}
+}
+
+bool FileWatcher::Poller::poll (const State& currentState)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	Snapshot newSnapshot;
+
+	const auto succeeded = newSnapshot.take (watchedPath, recursive, maxEntries, &snapshot);
+
+	lastPollDuration = std::chrono::steady_clock::now() - start;
+
+	std::error_code ec;
+
+	// if the watched path is gone, comparing with the empty snapshot reports everything as deleted
+	if (! succeeded && std::filesystem::exists (watchedPath, ec))
+	{
+		// the tree outgrew the snapshot, which is kept to compare against once it's small enough again
+		if (reportedOverflow)
+			return true;
+
+		reportedOverflow = true;
+
+		dispatcher.notifyEventsLost();
+
+		return ! currentState.stopping.load();
+	}
+
+	reportedOverflow = false;
+
+	const auto differences = snapshot.compare (newSnapshot);
+
+	snapshot = std::move (newSnapshot);
+
+	for (const auto& difference : differences)
+	{
+		dispatcher.dispatch (difference.type, difference.path);
+
+		if (currentState.stopping.load())
+			return false;
+	}
+
+	return true;
+}
+
+}  // namespace limes::files
@@ -0,0 +1,102 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "lfilesystem/lfilesystem_Export.h"
+#include "lfilesystem/lfilesystem_FileWatcher.h"
+#include "lfilesystem/lfilesystem_FilesystemEntry.h"	// for Path
+#include "lfilesystem_EventDispatcher.h"
+#include "lfilesystem_Snapshot.h"
+
+/** This file declares the internal polling backend of FileWatcher.
+
+	This header is not part of the library's public API.
+ */
+
+namespace limes::files
+{
+
+/** The FileWatcher backend that finds changes by periodically comparing the watched tree with a snapshot of it.
+
+	Each poller has its own background thread, which sleeps for the poll interval -- extended if needed to stay
+	within the CPU budget -- then takes a new snapshot based on the previous one, and reports the differences.
+	Directories that haven't changed since the last poll aren't read again, so each poll costs one metadata
+	query per entry in the tree.
+
+	The callbacks are called on the poller's thread, and may destroy the watcher.
+ */
+class LFILE_NO_EXPORT FileWatcher::Poller final
+{
+public:
+	/** Takes the initial snapshot and starts the background thread.
+		@throws std::runtime_error If the path doesn't exist, the tree has more than \c Options::maxSnapshotEntries entries,
+		or the background thread can't be started, as on Emscripten builds without pthreads.
+	 */
+	Poller (FileWatcher& parent, const FilesystemEntry& fileToWatch, const Options& options);
+
+	/** Destructor. Once this returns, no more callbacks will be made. */
+	~Poller();
+
+	Poller (const Poller&)			  = delete;
+	Poller& operator= (const Poller&) = delete;
+
+private:
+	// the limit on the size of the snapshot if Options::maxSnapshotEntries is 0, since polling can't work without one
+	static constexpr std::size_t defaultMaxEntries = 100'000;
+
+	// shared with the background thread, so that it can exit safely if the poller is destroyed by one of its callbacks
+	struct State final
+	{
+		std::mutex				mutex;
+		std::condition_variable wakeUp;
+		std::atomic<bool>		stopping { false };
+	};
+
+	void run (const std::shared_ptr<State>& state);
+
+	// returns false if the poller was destroyed by a callback
+	[[nodiscard]] bool poll (const State& state);
+
+	EventDispatcher dispatcher;
+
+	const Path watchedPath;
+
+	const bool recursive;
+
+	const std::size_t maxEntries;
+
+	const std::chrono::milliseconds interval;
+
+	const double cpuBudget;
+
+	Snapshot snapshot;
+
+	std::chrono::steady_clock::duration lastPollDuration { 0 };
+
+	bool reportedOverflow { false };
+
+	const std::shared_ptr<State> state { std::make_shared<State>() };
+
+	std::thread thread;
+};
+
+}  // namespace limes::files
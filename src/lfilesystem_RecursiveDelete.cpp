@@ -0,0 +1,411 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "lfilesystem/lfilesystem_FilesystemEntry.h"
+#include "lfilesystem_Parallel.h"
+
+#if ! (defined(_WIN32) || defined(WIN32))
+#	include <dirent.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <cerrno>
+#endif
+
+/** This file implements FilesystemEntry::deleteRecursively() and FilesystemEntry::deleteInBackground(). */
+
+namespace limes::files
+{
+
+#if defined(_WIN32) || defined(WIN32)
+
+FilesystemEntry::DeleteResult FilesystemEntry::deleteRecursively ([[maybe_unused]] std::size_t numThreads) const noexcept
+{
+	DeleteResult result;
+
+	std::error_code ec;
+
+	const auto numRemoved = std::filesystem::remove_all (getAbsolutePath(), ec);
+
+	if (! ec)
+	{
+		result.numRemoved = numRemoved;
+		return result;
+	}
+
+	try
+	{
+		result.failures.push_back ({ getAbsolutePath(), ec });
+	}
+	catch (...)
+	{
+	}
+
+	return result;
+}
+
+#else
+
+namespace
+{
+
+/* Deletes a tree relative to open directory descriptors.
+
+	Each directory is represented by a node that keeps its descriptor open until all of its children have been
+	deleted, so that they can be unlinked relative to it. Subdirectories are deleted by separate tasks, and the
+	last task to finish with a directory removes it, then releases its parent.
+ */
+class TreeDeleter final
+{
+public:
+	struct Node final
+	{
+		Node (std::shared_ptr<Node> parentNode, std::string nodeName)
+			: parent (std::move (parentNode)), name (std::move (nodeName))
+		{
+		}
+
+		~Node()
+		{
+			closeDescriptor();
+		}
+
+		Node (const Node&)			  = delete;
+		Node& operator= (const Node&) = delete;
+
+		void closeDescriptor() noexcept
+		{
+			if (fd >= 0)
+				::close (std::exchange (fd, -1));
+		}
+
+		// the node for the directory containing the deleted tree has no parent
+		const std::shared_ptr<Node> parent;
+
+		const std::string name;
+
+		int fd { -1 };
+
+		// 1 while the directory is being read, plus 1 for each subdirectory that hasn't been deleted yet
+		std::atomic<std::size_t> pending { 1 };
+	};
+
+	TreeDeleter (const Path& rootParentPath, std::size_t numThreadsToUse)
+		: rootParent (rootParentPath), numThreads (parallel::getNumThreads (numThreadsToUse))
+	{
+	}
+
+	// deletes a child of the parent if it isn't a directory. If it is, returns a node for it, which must then be passed to deleteDirectory()
+	[[nodiscard]] std::shared_ptr<Node> deleteEntry (const std::shared_ptr<Node>& parent, const char* name, unsigned char type)
+	{
+		if (type != DT_DIR)
+		{
+			if (::unlinkat (parent->fd, name, 0) == 0)
+			{
+				numRemoved.fetch_add (1);
+				return nullptr;
+			}
+
+			const auto error = errno;
+
+			// the entry was already removed by someone else
+			if (error == ENOENT)
+				return nullptr;
+
+			// unlinkat() fails with EISDIR on Linux and EPERM on other systems if the entry is a directory
+			if (type != DT_UNKNOWN || (error != EISDIR && error != EPERM))
+			{
+				fail (parent, name, error);
+				return nullptr;
+			}
+		}
+
+		parent->pending.fetch_add (1);
+
+		return std::make_shared<Node> (parent, name);
+	}
+
+	void deleteDirectory (const std::shared_ptr<Node>& node)
+	{
+		node->fd = ::openat (node->parent->fd, node->name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+		if (node->fd < 0)
+		{
+			const auto error = errno;
+
+			// an empty directory can still be removed even if it can't be read
+			if (error != ENOENT && ::unlinkat (node->parent->fd, node->name.c_str(), AT_REMOVEDIR) != 0)
+				fail (node->parent, node->name.c_str(), error);
+			else if (error != ENOENT)
+				numRemoved.fetch_add (1);
+
+			release (node->parent);
+			return;
+		}
+
+		// the stream takes ownership of its descriptor, and this node's descriptor must stay open for the children
+		const auto streamFD = ::fcntl (node->fd, F_DUPFD_CLOEXEC, 0);
+
+		auto* stream = streamFD < 0 ? nullptr : ::fdopendir (streamFD);
+
+		if (stream != nullptr)
+		{
+			errno = 0;
+
+			while (const auto* entry = ::readdir (stream))
+			{
+				const std::string_view name { entry->d_name };
+
+				if (name == "." || name == "..")
+					continue;
+
+				if (auto child = deleteEntry (node, entry->d_name, entry->d_type))
+					schedule (std::move (child));
+
+				errno = 0;
+			}
+
+			if (errno != 0)
+				fail (node, nullptr, errno);
+
+			::closedir (stream);
+		}
+		else
+		{
+			const auto error = errno;
+
+			if (streamFD >= 0)
+				::close (streamFD);
+
+			fail (node, nullptr, error);
+		}
+
+		release (node);
+	}
+
+	void wait() noexcept
+	{
+		if (group == nullptr)
+			return;
+
+		try
+		{
+			group->wait();
+		}
+		catch (...)
+		{
+			// a task failed to allocate memory
+			fail (rootParent, ENOMEM);
+		}
+	}
+
+	[[nodiscard]] FilesystemEntry::DeleteResult getResult()
+	{
+		FilesystemEntry::DeleteResult result;
+
+		result.numRemoved = numRemoved.load();
+		result.failures	  = std::move (failures);
+
+		return result;
+	}
+
+	void fail (const Path& path, int error) noexcept
+	{
+		try
+		{
+			const std::lock_guard lock { failuresMutex };
+			failures.push_back ({ path, std::error_code { error, std::generic_category() } });
+		}
+		catch (...)
+		{
+		}
+	}
+
+private:
+	void schedule (std::shared_ptr<Node>&& node)
+	{
+		if (numThreads == 1)
+		{
+			deleteDirectory (node);
+			return;
+		}
+
+		// the workers are only started once there's a subdirectory. Until then, only the calling thread gets here
+		if (group == nullptr)
+			group = std::make_unique<parallel::TaskGroup> (numThreads);
+
+		group->run ([this, node = std::move (node)]
+					{ deleteDirectory (node); });
+	}
+
+	// called when a directory has been read, or one of its subdirectories has been deleted
+	void release (const std::shared_ptr<Node>& node)
+	{
+		if (node->pending.fetch_sub (1) != 1 || node->parent == nullptr)
+			return;
+
+		node->closeDescriptor();
+
+		if (::unlinkat (node->parent->fd, node->name.c_str(), AT_REMOVEDIR) == 0)
+			numRemoved.fetch_add (1);
+		else
+			fail (node->parent, node->name.c_str(), errno);
+
+		release (node->parent);
+	}
+
+	void fail (const std::shared_ptr<Node>& directory, const char* childName, int error) noexcept
+	{
+		try
+		{
+			Path path;
+
+			for (auto node = directory.get(); node->parent != nullptr; node = node->parent.get())
+				path = node->name / path;
+
+			path = rootParent / path;
+
+			if (childName != nullptr)
+				path /= childName;
+
+			fail (path, error);
+		}
+		catch (...)
+		{
+		}
+	}
+
+	const Path rootParent;
+
+	const std::size_t numThreads;
+
+	std::unique_ptr<parallel::TaskGroup> group;
+
+	std::atomic<std::uintmax_t> numRemoved { 0 };
+
+	std::mutex								   failuresMutex;
+	std::vector<FilesystemEntry::DeleteResult::Failure> failures;
+};
+
+}  // namespace
+
+FilesystemEntry::DeleteResult FilesystemEntry::deleteRecursively (std::size_t numThreads) const noexcept
+{
+	const auto rootPath = getAbsolutePath();
+
+	TreeDeleter deleter { rootPath.parent_path(), numThreads };
+
+	try
+	{
+		const auto parent = std::make_shared<TreeDeleter::Node> (nullptr, std::string {});
+
+		parent->fd = ::open (rootPath.parent_path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+		if (parent->fd < 0)
+		{
+			if (errno != ENOENT)
+				deleter.fail (rootPath, errno);
+
+			return deleter.getResult();
+		}
+
+		if (const auto root = deleter.deleteEntry (parent, rootPath.filename().c_str(), DT_UNKNOWN))
+			deleter.deleteDirectory (root);
+	}
+	catch (const std::system_error& e)
+	{
+		// the worker threads couldn't be started
+		deleter.fail (rootPath, e.code().value());
+	}
+	catch (...)
+	{
+		deleter.fail (rootPath, ENOMEM);
+	}
+
+	deleter.wait();
+
+	return deleter.getResult();
+}
+
+#endif
+
+bool FilesystemEntry::deleteInBackground (std::size_t numThreads) const noexcept
+{
+	if (! isValid())
+		return false;
+
+	try
+	{
+		const auto originalPath = getAbsolutePath();
+
+		std::error_code ec;
+
+		if (! std::filesystem::exists (std::filesystem::symlink_status (originalPath, ec)))
+			return false;
+
+		static std::atomic<unsigned> counter { 0 };
+
+		const auto tombstone = [&originalPath]
+		{
+			std::random_device random;
+
+			const auto prefix = "." + originalPath.filename().string() + ".deleting.";
+
+			while (true)
+			{
+				auto candidate = originalPath.parent_path() / (prefix + std::to_string (random()) + std::to_string (counter.fetch_add (1)));
+
+				std::error_code statusError;
+
+				if (! std::filesystem::exists (std::filesystem::symlink_status (candidate, statusError)))
+					return candidate;
+			}
+		}();
+
+		std::filesystem::rename (originalPath, tombstone, ec);
+
+		if (ec)
+			return false;
+
+		try
+		{
+			std::thread { [tombstone, numThreads]
+						  { [[maybe_unused]] const auto result = FilesystemEntry { tombstone }.deleteRecursively (numThreads); } }
+				.detach();
+		}
+		catch (...)
+		{
+			// the thread couldn't be started
+			[[maybe_unused]] const auto result = FilesystemEntry { tombstone }.deleteRecursively (numThreads);
+		}
+
+		return true;
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+}  // namespace limes::files
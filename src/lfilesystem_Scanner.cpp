@@ -0,0 +1,230 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include "lfilesystem_Scanner.h"
+
+#if (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)) && ! defined(__EMSCRIPTEN__)
+#	define LFILE_SCANNER_USE_SSE2 1
+#	include <immintrin.h>
+#	ifdef _MSC_VER
+#		include <intrin.h>
+#	endif
+#else
+#	define LFILE_SCANNER_USE_SSE2 0
+#endif
+
+#if LFILE_SCANNER_USE_SSE2 && (defined(__GNUC__) || defined(_MSC_VER))
+#	define LFILE_SCANNER_USE_AVX2 1
+#else
+#	define LFILE_SCANNER_USE_AVX2 0
+#endif
+
+#if LFILE_SCANNER_USE_AVX2 && defined(__GNUC__)
+#	define LFILE_TARGET_AVX2 __attribute__ ((target ("avx2")))
+#else
+#	define LFILE_TARGET_AVX2
+#endif
+
+namespace limes::files::scanner
+{
+
+[[nodiscard]] static inline const char* findFirstOf_scalar (const char* begin, const char* end, const ByteSet& set) noexcept
+{
+	// memchr is usually vectorized by the C library
+	if (set.size() == 1)
+	{
+		if (const auto* result = std::memchr (begin, set[0], static_cast<std::size_t> (end - begin)))
+			return static_cast<const char*> (result);
+
+		return end;
+	}
+
+	for (; begin != end; ++begin)
+		if (set.contains (*begin))
+			return begin;
+
+	return end;
+}
+
+#if LFILE_SCANNER_USE_SSE2
+
+[[nodiscard]] static inline int countTrailingZeroes (unsigned int mask) noexcept
+{
+#	ifdef _MSC_VER
+	unsigned long idx;	// NOLINT
+	_BitScanForward (&idx, mask);
+	return static_cast<int> (idx);
+#	else
+	return __builtin_ctz (mask);
+#	endif
+}
+
+[[nodiscard]] static const char* findFirstOf_sse2 (const char* begin, const char* end, const ByteSet& set) noexcept
+{
+	static constexpr auto chunkSize = 16;
+
+	const auto numChars = set.size();
+
+	__m128i needles[ByteSet::maxSize];
+
+	for (auto i = 0UL; i < numChars; ++i)
+		needles[i] = _mm_set1_epi8 (set[i]);
+
+	for (; end - begin >= chunkSize; begin += chunkSize)
+	{
+		const auto chunk = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (begin));	// NOLINT
+
+		auto matches = _mm_cmpeq_epi8 (chunk, needles[0]);
+
+		for (auto i = 1UL; i < numChars; ++i)
+			matches = _mm_or_si128 (matches, _mm_cmpeq_epi8 (chunk, needles[i]));
+
+		if (const auto mask = static_cast<unsigned int> (_mm_movemask_epi8 (matches)))
+			return begin + countTrailingZeroes (mask);
+	}
+
+	return findFirstOf_scalar (begin, end, set);
+}
+
+#endif /* LFILE_SCANNER_USE_SSE2 */
+
+#if LFILE_SCANNER_USE_AVX2
+
+[[nodiscard]] LFILE_TARGET_AVX2 static const char* findFirstOf_avx2 (const char* begin, const char* end, const ByteSet& set) noexcept
+{
+	static constexpr auto chunkSize = 32;
+
+	const auto numChars = set.size();
+
+	__m256i needles[ByteSet::maxSize];
+
+	for (auto i = 0UL; i < numChars; ++i)
+		needles[i] = _mm256_set1_epi8 (set[i]);
+
+	for (; end - begin >= chunkSize; begin += chunkSize)
+	{
+		const auto chunk = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (begin));  // NOLINT
+
+		auto matches = _mm256_cmpeq_epi8 (chunk, needles[0]);
+
+		for (auto i = 1UL; i < numChars; ++i)
+			matches = _mm256_or_si256 (matches, _mm256_cmpeq_epi8 (chunk, needles[i]));
+
+		if (const auto mask = static_cast<unsigned int> (_mm256_movemask_epi8 (matches)))
+			return begin + countTrailingZeroes (mask);
+	}
+
+	return findFirstOf_sse2 (begin, end, set);
+}
+
+[[nodiscard]] static inline bool cpuSupportsAVX2() noexcept
+{
+#	ifdef _MSC_VER
+	int info[4];
+
+	__cpuid (info, 0);
+
+	if (info[0] < 7)
+		return false;
+
+	__cpuid (info, 1);
+
+	// the OS must support saving the AVX registers
+	static constexpr auto osxsaveBit = 1 << 27;
+	static constexpr auto avxBit	 = 1 << 28;
+
+	if ((info[2] & osxsaveBit) == 0 || (info[2] & avxBit) == 0)
+		return false;
+
+	if ((_xgetbv (0) & 6) != 6)
+		return false;
+
+	__cpuidex (info, 7, 0);
+
+	static constexpr auto avx2Bit = 1 << 5;
+
+	return (info[1] & avx2Bit) != 0;
+#	else
+	__builtin_cpu_init();
+
+	return __builtin_cpu_supports ("avx2");
+#	endif
+}
+
+#endif /* LFILE_SCANNER_USE_AVX2 */
+
+using FindFunction = const char* (*) (const char*, const char*, const ByteSet&) noexcept;
+
+[[nodiscard]] static inline FindFunction chooseImplementation() noexcept
+{
+#if LFILE_SCANNER_USE_AVX2
+	if (cpuSupportsAVX2())
+		return findFirstOf_avx2;
+#endif
+
+#if LFILE_SCANNER_USE_SSE2
+	return findFirstOf_sse2;
+#else
+	return findFirstOf_scalar;
+#endif
+}
+
+const char* findFirstOf (const char* begin, const char* end, const ByteSet& set) noexcept
+{
+	static const auto implementation = chooseImplementation();
+
+	if (set.size() == 0)
+		return end;
+
+	// the vectorized versions only compare against the first maxSize bytes of the set
+	if (set.size() > ByteSet::maxSize)
+		return findFirstOf_scalar (begin, end, set);
+
+	return implementation (begin, end, set);
+}
+
+std::vector<std::string_view> split (std::string_view input, const ByteSet& delimiters)
+{
+	std::vector<std::string_view> tokens;
+
+	if (input.empty())
+		return tokens;
+
+	const auto* const end = input.data() + input.size();
+
+	const auto* tokenStart = input.data();
+
+	while (true)
+	{
+		const auto* delimiterStart = findFirstOf (tokenStart, end, delimiters);
+
+		tokens.emplace_back (tokenStart, static_cast<std::size_t> (delimiterStart - tokenStart));
+
+		if (delimiterStart == end)
+			break;
+
+		// runs of delimiters are usually short, so they're skipped one byte at a time
+		tokenStart = delimiterStart + 1;
+
+		while (tokenStart != end && delimiters.contains (*tokenStart))
+			++tokenStart;
+	}
+
+	return tokens;
+}
+
+}  // namespace limes::files::scanner
@@ -0,0 +1,103 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include "lfilesystem/lfilesystem_Export.h"
+
+/** This file declares the internal byte scanning functions used for splitting strings and
+	file content into tokens.
+
+	The scanning functions are vectorized with SSE2, or AVX2 if the CPU supports it (this is
+	detected at runtime). On other architectures, a scalar fallback is used.
+
+	This header is not part of the library's public API.
+ */
+
+namespace limes::files::scanner
+{
+
+/** A small set of byte values to search for.
+
+	Sets of up to \c maxSize distinct bytes are searched with vector instructions. Larger sets are allowed,
+	but are searched one byte at a time.
+ */
+class LFILE_NO_EXPORT ByteSet final
+{
+public:
+	static constexpr std::size_t maxSize = 8;
+
+	constexpr ByteSet (std::string_view bytes) noexcept	 // NOLINT
+	{
+		for (const auto c : bytes)
+		{
+			if (contains (c))
+				continue;
+
+			if (count < maxSize)
+				chars[count] = c;
+
+			++count;
+
+			table[static_cast<unsigned char> (c)] = true;
+		}
+	}
+
+	constexpr ByteSet (const char* bytes) noexcept	// NOLINT
+		: ByteSet (std::string_view { bytes })
+	{
+	}
+
+	[[nodiscard]] constexpr bool contains (char c) const noexcept
+	{
+		return table[static_cast<unsigned char> (c)];
+	}
+
+	/** Returns the number of distinct bytes in the set, which may be more than \c maxSize . */
+	[[nodiscard]] constexpr std::size_t size() const noexcept { return count; }
+
+	/** Returns one of the bytes in the set. Only the first \c maxSize bytes can be accessed this way. */
+	[[nodiscard]] constexpr char operator[] (std::size_t idx) const noexcept { return chars[idx]; }
+
+private:
+	std::array<char, maxSize> chars {};
+
+	std::array<bool, 256> table {};
+
+	std::size_t count { 0 };
+};
+
+/** The characters for which \c std::isspace() returns true in the C locale. */
+inline constexpr ByteSet whitespace { " \t\n\v\f\r" };
+
+/** Returns a pointer to the first byte in the range \c [begin,end) that is contained in the set,
+	or \c end if there is no such byte.
+ */
+[[nodiscard]] LFILE_NO_EXPORT const char* findFirstOf (const char* begin, const char* end, const ByteSet& set) noexcept;
+
+/** Splits the input at each run of consecutive delimiter characters.
+
+	The delimiters are not included in the returned tokens. If the input begins with a delimiter,
+	the first token will be empty; likewise, if the input ends with a delimiter, the last token
+	will be empty. An empty input produces no tokens.
+
+	The returned views point into the input string.
+ */
+[[nodiscard]] LFILE_NO_EXPORT std::vector<std::string_view> split (std::string_view input, const ByteSet& delimiters);
+
+}  // namespace limes::files::scanner
@@ -13,6 +13,7 @@
  */
 
 #include <utility>
+#include <sstream>
 #include <stdexcept>
 #include "lfilesystem/lfilesystem_SimpleWatcher.h"
 
@@ -21,10 +22,33 @@ namespace limes::files
 
 SimpleFileWatcher::SimpleFileWatcher (const FilesystemEntry& fileToWatch,
 									  Callback&&			 callbackToUse)
-	: FileWatcher (fileToWatch), callback (std::move (callbackToUse))
+	: SimpleFileWatcher (fileToWatch, Options {}, std::move (callbackToUse))
+{
+}
+
+SimpleFileWatcher::SimpleFileWatcher (const FilesystemEntry& fileToWatch,
+									  const Options&		 optionsToUse,
+									  Callback&&			 callbackToUse)
+	: callback (std::move (callbackToUse))
 {
 	if (callback == nullptr)
 		throw std::runtime_error { "SimpleFileWatcher given a null callback function" };
+
+	// watching starts here and not in FileWatcher's constructor, so that events can't arrive before the callback exists
+	if (! start (fileToWatch, optionsToUse))
+	{
+		std::stringstream stream;
+
+		stream << "SimpleFileWatcher: cannot watch non-existent file "
+			   << fileToWatch.getAbsolutePath().string();
+
+		throw std::runtime_error { stream.str() };
+	}
+}
+
+SimpleFileWatcher::~SimpleFileWatcher()
+{
+	stop();
 }
 
 void SimpleFileWatcher::fileAccessed (const FilesystemEntry& f)
@@ -0,0 +1,269 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include "lfilesystem_Snapshot.h"
+
+namespace limes::files
+{
+
+bool Snapshot::readEntry (const Path& path, Entry& entry)
+{
+	static constexpr auto fields = FileInfo::Type | FileInfo::Inode | FileInfo::Size | FileInfo::ModificationTime;
+
+	const auto info = FileInfo::tryCreate (path, fields, false);
+
+	if (! info.has_value())
+		return false;
+
+	entry.inode			   = info->getInode();
+	entry.size			   = info->sizeInBytes();
+	entry.modificationTime = info->getLastModificationTime().time_since_epoch().count();
+	entry.isDirectory	   = info->isDirectory();
+
+	return true;
+}
+
+bool Snapshot::take (const Path& root, bool recursive, std::size_t maxEntries, const Snapshot* previous)
+{
+	clear();
+
+	if (maxEntries == 0)
+		return false;
+
+	Entry rootEntry;
+
+	if (! readEntry (root, rootEntry))
+		return false;
+
+	entries.emplace (root.native(), rootEntry);
+
+	if (previous != nullptr && ! previous->isValid())
+		previous = nullptr;
+
+	if (rootEntry.isDirectory && ! readDirectory (root, recursive, maxEntries, previous))
+	{
+		clear();
+		return false;
+	}
+
+	valid = true;
+
+	return true;
+}
+
+bool Snapshot::readDirectory (const Path& directory, bool recursive, std::size_t maxEntries, const Snapshot* previous)
+{
+	auto& directoryNames = names[directory.native()];
+
+	if (const auto* unchanged = previous != nullptr ? previous->findUnchangedNames (directory, entries.at (directory.native())) : nullptr)
+	{
+		directoryNames = *unchanged;
+	}
+	else
+	{
+		namespace fs = std::filesystem;
+
+		std::error_code ec;
+
+		for (fs::directory_iterator it { directory, fs::directory_options::skip_permission_denied, ec };
+			 ! ec && it != fs::directory_iterator {};
+			 it.increment (ec))
+		{
+			directoryNames.push_back (it->path().filename().native());
+		}
+	}
+
+	for (const auto& name : directoryNames)
+	{
+		if (entries.size() >= maxEntries)
+			return false;
+
+		auto path = directory / name;
+
+		// entries that disappear while the tree is being read are simply left out
+		Entry entry;
+
+		if (! readEntry (path, entry))
+			continue;
+
+		entries.emplace (path.native(), entry);
+
+		if (recursive && entry.isDirectory && ! readDirectory (path, recursive, maxEntries, previous))
+			return false;
+	}
+
+	return true;
+}
+
+const Snapshot::Names* Snapshot::findUnchangedNames (const Path& directory, const Entry& entry) const
+{
+	const auto oldEntry = entries.find (directory.native());
+
+	if (oldEntry == entries.end())
+		return nullptr;
+
+	const auto& old = oldEntry->second;
+
+	if (old.alreadyReported || ! old.isDirectory || old.inode != entry.inode || old.modificationTime != entry.modificationTime)
+		return nullptr;
+
+	if (const auto found = names.find (directory.native()); found != names.end())
+		return &found->second;
+
+	return nullptr;
+}
+
+void Snapshot::forgetNames (const Path& path)
+{
+	// the parent's list of names no longer matches, so it will be read again by the next take()
+	names.erase (path.parent_path().native());
+}
+
+bool Snapshot::isValid() const noexcept
+{
+	return valid;
+}
+
+void Snapshot::clear() noexcept
+{
+	entries.clear();
+	names.clear();
+	valid = false;
+}
+
+std::size_t Snapshot::size() const noexcept
+{
+	return entries.size();
+}
+
+void Snapshot::refreshEntry (const Path& path)
+{
+	forgetNames (path);
+
+	if (Entry entry; readEntry (path, entry))
+		entries.insert_or_assign (path.native(), entry);
+	else
+		removeEntry (path);
+}
+
+void Snapshot::markReported (const Path& path, bool isDirectory)
+{
+	const auto [it, inserted] = entries.try_emplace (path.native());
+
+	if (inserted)
+		forgetNames (path);
+
+	auto& entry = it->second;
+
+	entry.isDirectory	  = isDirectory;
+	entry.alreadyReported = true;
+}
+
+// erases the keys below a directory, which all start with the directory's path and a separator, so are next to each other
+template <typename Map>
+static void eraseBelow (Map& map, const Path::string_type& directory)
+{
+	auto prefix = directory;
+	prefix += Path::preferred_separator;
+
+	const auto first = map.lower_bound (prefix);
+
+	auto last = first;
+
+	while (last != map.end() && last->first.starts_with (prefix))
+		++last;
+
+	map.erase (first, last);
+}
+
+void Snapshot::removeEntry (const Path& path)
+{
+	forgetNames (path);
+
+	const auto& key = path.native();
+
+	names.erase (key);
+
+	const auto entry = entries.find (key);
+
+	if (entry == entries.end())
+		return;
+
+	const auto wasDirectory = entry->second.isDirectory;
+
+	entries.erase (entry);
+
+	// a directory's children are only in the snapshot if the directory was
+	if (wasDirectory)
+	{
+		eraseBelow (entries, key);
+		eraseBelow (names, key);
+	}
+}
+
+std::vector<Snapshot::Difference> Snapshot::compare (const Snapshot& newer) const
+{
+	std::vector<Difference> differences;
+
+	for (const auto& [path, entry] : entries)
+	{
+		const auto it = newer.entries.find (path);
+
+		if (it == newer.entries.end())
+		{
+			differences.push_back ({ FileWatcher::Deleted, Path { path }, entry.isDirectory });
+			continue;
+		}
+
+		if (entry.alreadyReported)
+			continue;
+
+		const auto& newEntry = it->second;
+
+		// the entry was replaced by a different one with the same name
+		if (newEntry.inode != entry.inode || newEntry.isDirectory != entry.isDirectory)
+		{
+			differences.push_back ({ FileWatcher::Deleted, Path { path }, entry.isDirectory });
+			differences.push_back ({ FileWatcher::Created, Path { path }, newEntry.isDirectory });
+			continue;
+		}
+
+		if (! entry.isDirectory
+			&& (newEntry.size != entry.size || newEntry.modificationTime != entry.modificationTime))
+		{
+			differences.push_back ({ FileWatcher::Modified, Path { path }, false });
+		}
+	}
+
+	for (const auto& [path, entry] : newer.entries)
+		if (! entries.contains (path))
+			differences.push_back ({ FileWatcher::Created, Path { path }, entry.isDirectory });
+
+	// parents sort before their children, so created directories are reported before their contents,
+	// and a deletion is reported before a creation of the same path
+	std::sort (differences.begin(), differences.end(), [] (const Difference& a, const Difference& b)
+			   {
+				   if (const auto order = a.path.compare (b.path); order != 0)
+					   return order < 0;
+
+				   return a.type == FileWatcher::Deleted && b.type != FileWatcher::Deleted;
+			   });
+
+	return differences;
+}
+
+}  // namespace limes::files
@@ -0,0 +1,131 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "lfilesystem/lfilesystem_Export.h"
+#include "lfilesystem/lfilesystem_FileInfo.h"
+#include "lfilesystem/lfilesystem_FileWatcher.h"
+#include "lfilesystem/lfilesystem_FilesystemEntry.h"	// for Path
+
+/** This file declares the internal snapshot of a watched tree that FileWatcher uses to find changes it missed.
+
+	This header is not part of the library's public API.
+ */
+
+namespace limes::files
+{
+
+/** A compact record of the identity, size and modification time of every entry in a watched tree.
+
+	Comparing two snapshots of the same tree yields the entries that were created, deleted or modified
+	between them. A FileWatcher backend keeps a snapshot so that it can recover from events that the OS
+	dropped: it takes a new snapshot, reports the differences, and keeps the new snapshot.
+
+	Events that the backend did receive should be recorded with \c refreshEntry() , \c markReported()
+	and \c removeEntry() , so that a later comparison doesn't report them again.
+
+	The snapshot also remembers the names in each directory. Creating, deleting or renaming an entry
+	updates the modification time of its parent, so when a new snapshot is taken based on an older one,
+	the directories whose inode and modification time haven't changed aren't read again -- only their
+	known entries are queried. This is what makes polling a large, mostly unchanged tree affordable.
+ */
+class LFILE_NO_EXPORT Snapshot final
+{
+public:
+	/** A change found by comparing two snapshots. */
+	struct Difference final
+	{
+		FileWatcher::EventType type;
+		Path				   path;
+		bool				   isDirectory;
+	};
+
+	/** Replaces the contents of this snapshot with the current state of the filesystem.
+
+		The root itself is always included. If it is a directory, its children are included, and if
+		\c recursive is true, the entire tree below it. Symbolic links are not followed.
+
+		If \c previous is a valid snapshot of the same tree, the names of directories that haven't changed
+		since it was taken are reused instead of being read again.
+
+		@returns False if the tree has more than \c maxEntries entries, in which case the snapshot is left
+		empty and invalid.
+	 */
+	bool take (const Path& root, bool recursive, std::size_t maxEntries, const Snapshot* previous = nullptr);
+
+	/** Returns true if the last call to \c take() succeeded. */
+	[[nodiscard]] bool isValid() const noexcept;
+
+	/** Empties the snapshot and marks it invalid. */
+	void clear() noexcept;
+
+	/** Returns the number of entries in the snapshot. */
+	[[nodiscard]] std::size_t size() const noexcept;
+
+	/** Reads the current state of the entry at the path into the snapshot, after a change to it was reported. */
+	void refreshEntry (const Path& path);
+
+	/** Records that a change to the entry at the path was reported, without reading its current state.
+		This is cheaper than \c refreshEntry() for events that usually come in bursts, such as writes.
+	 */
+	void markReported (const Path& path, bool isDirectory);
+
+	/** Records that the entry at the path, and any entries below it, no longer exist. */
+	void removeEntry (const Path& path);
+
+	/** Returns the changes between this snapshot and a newer snapshot of the same tree, sorted by path.
+
+		Entries that were recorded with \c markReported() are only reported if they no longer exist.
+		Modifications of directories are not reported, since the changes of their children are.
+	 */
+	[[nodiscard]] std::vector<Difference> compare (const Snapshot& newer) const;
+
+private:
+	struct Entry final
+	{
+		std::uintmax_t inode { 0 }, size { 0 };
+
+		FileInfo::Time::rep modificationTime { 0 };
+
+		bool isDirectory { false };
+
+		// set for entries whose changes were reported after this snapshot was taken
+		bool alreadyReported { false };
+	};
+
+	using Names = std::vector<Path::string_type>;
+
+	[[nodiscard]] static bool readEntry (const Path& path, Entry& entry);
+
+	[[nodiscard]] bool readDirectory (const Path& directory, bool recursive, std::size_t maxEntries, const Snapshot* previous);
+
+	[[nodiscard]] const Names* findUnchangedNames (const Path& directory, const Entry& entry) const;
+
+	void forgetNames (const Path& path);
+
+	// these are ordered, so that all the paths below a directory are next to each other and can be removed together
+	std::map<Path::string_type, Entry> entries;
+
+	// the names of the entries in each directory, which are only valid while the directory's entry is unchanged
+	std::map<Path::string_type, Names> names;
+
+	bool valid { false };
+};
+
+}  // namespace limes::files
@@ -0,0 +1,38 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#include <filesystem>
+#include <system_error>
+#include "../lfilesystem_FileCopy.h"
+
+namespace limes::files::filecopy
+{
+
+File::CopyStrategy copyFile (const Path& source, const Path& dest, const Settings& settings)
+{
+	if (! std::filesystem::is_regular_file (source))
+		throw std::filesystem::filesystem_error { "Cannot copy a file that is not a regular file", source, dest,
+												  std::make_error_code (std::errc::not_supported) };
+
+	if (! std::filesystem::copy_file (source, dest, settings.options))
+		return File::CopyStrategy::Skipped;
+
+	if (settings.copyModificationTime)
+		std::filesystem::last_write_time (dest, std::filesystem::last_write_time (source));
+
+	return File::CopyStrategy::System;
+}
+
+}  // namespace limes::files::filecopy
@@ -0,0 +1,352 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#include <fcntl.h>
+#include <linux/fs.h>  // for FICLONE
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <system_error>
+#include "../lfilesystem_FileCopy.h"
+
+namespace limes::files::filecopy
+{
+
+namespace
+{
+
+using Strategy = File::CopyStrategy;
+
+[[noreturn]] void throwError (const char* what, const Path& source, const Path& dest, int error)
+{
+	throw std::filesystem::filesystem_error { what, source, dest, std::error_code { error, std::generic_category() } };
+}
+
+class Descriptor final
+{
+public:
+	explicit Descriptor (int fileDescriptor) noexcept
+		: fd (fileDescriptor)
+	{
+	}
+
+	~Descriptor()
+	{
+		if (fd >= 0)
+			::close (fd);
+	}
+
+	Descriptor (const Descriptor&)			  = delete;
+	Descriptor& operator= (const Descriptor&) = delete;
+
+	[[nodiscard]] bool isValid() const noexcept { return fd >= 0; }
+
+	[[nodiscard]] int get() const noexcept { return fd; }
+
+private:
+	const int fd;
+};
+
+/* Copies ranges of data between two files, at the same offset in each.
+	Each range is copied with the fastest strategy that has worked so far; whenever the kernel reports that
+	a strategy isn't supported for these files, the next one is tried, and is used from then on.
+ */
+class RangeCopier final
+{
+public:
+	RangeCopier (int sourceFD, int destFD, Strategy initialStrategy) noexcept
+		: source (sourceFD), dest (destFD), strategy (initialStrategy)
+	{
+	}
+
+	// returns the number of bytes copied, which is only less than the length if the end of the source was reached
+	std::uint64_t copy (off_t offset, std::uint64_t length)
+	{
+		const auto start = offset;
+
+		while (length > 0)
+		{
+			const auto result = copyChunk (offset, length);
+
+			if (result == 0)
+				break;
+
+			if (result < 0)
+			{
+				if (errno == EINTR)
+					continue;
+
+				if (strategy != Strategy::Buffered && isUnsupported (errno))
+				{
+					strategy = static_cast<Strategy> (static_cast<int> (strategy) + 1);
+					continue;
+				}
+
+				throw std::system_error { errno, std::generic_category() };
+			}
+
+			offset += result;
+			length -= static_cast<std::uint64_t> (result);
+		}
+
+		return static_cast<std::uint64_t> (offset - start);
+	}
+
+	[[nodiscard]] Strategy getStrategy() const noexcept { return strategy; }
+
+private:
+	// the kernel calls are limited to this many bytes at a time, so that a huge copy can be interrupted
+	static constexpr std::uint64_t maxKernelChunk = 1 << 30;
+
+	static constexpr std::size_t bufferSize = 1 << 20;
+
+	[[nodiscard]] static bool isUnsupported (int error) noexcept
+	{
+		return error == ENOSYS || error == EXDEV || error == EINVAL || error == EOPNOTSUPP || error == ENOTSUP;
+	}
+
+	[[nodiscard]] ssize_t copyChunk (off_t offset, std::uint64_t length)
+	{
+		switch (strategy)
+		{
+			case (Strategy::CopyFileRange) :
+			{
+#ifdef __NR_copy_file_range
+				// the system call is made directly, because some versions of glibc emulate it in user space
+				loff_t sourceOffset { offset }, destOffset { offset };
+
+				return ::syscall (__NR_copy_file_range, source, &sourceOffset, dest, &destOffset,
+								  std::min (length, maxKernelChunk), 0U);
+#else
+				errno = ENOSYS;
+				return -1;
+#endif
+			}
+
+			case (Strategy::SendFile) :
+			{
+				// sendfile() writes at the destination's file offset
+				if (::lseek (dest, offset, SEEK_SET) < 0)
+					return -1;
+
+				auto sourceOffset = offset;
+
+				return ::sendfile (dest, source, &sourceOffset, std::min (length, maxKernelChunk));
+			}
+
+			default : return copyBuffered (offset, length);
+		}
+	}
+
+	[[nodiscard]] ssize_t copyBuffered (off_t offset, std::uint64_t length)
+	{
+		if (buffer == nullptr)
+			buffer = std::make_unique<char[]> (bufferSize);
+
+		const auto numRead = ::pread (source, buffer.get(), static_cast<std::size_t> (std::min (length, std::uint64_t { bufferSize })), offset);
+
+		if (numRead <= 0)
+			return numRead;
+
+		for (ssize_t written = 0; written < numRead;)
+		{
+			const auto result = ::pwrite (dest, buffer.get() + written, static_cast<std::size_t> (numRead - written), offset + written);
+
+			if (result < 0)
+			{
+				if (errno == EINTR)
+					continue;
+
+				return -1;
+			}
+
+			written += result;
+		}
+
+		return numRead;
+	}
+
+	const int source, dest;
+
+	Strategy strategy;
+
+	std::unique_ptr<char[]> buffer;
+};
+
+// copies only the regions of a sparse file that contain data, leaving holes in the destination everywhere else
+void copySparse (RangeCopier& copier, int sourceFD, off_t size)
+{
+	for (off_t offset = 0; offset < size;)
+	{
+		const auto dataStart = ::lseek (sourceFD, offset, SEEK_DATA);
+
+		if (dataStart < 0)
+		{
+			// ENXIO means that there's no more data after the offset
+			if (errno == ENXIO)
+				return;
+
+			// the filesystem doesn't support finding holes, so copy everything that's left
+			copier.copy (offset, static_cast<std::uint64_t> (size - offset));
+			return;
+		}
+
+		auto dataEnd = ::lseek (sourceFD, dataStart, SEEK_HOLE);
+
+		if (dataEnd < 0)
+			dataEnd = size;
+
+		if (copier.copy (dataStart, static_cast<std::uint64_t> (dataEnd - dataStart))
+			< static_cast<std::uint64_t> (dataEnd - dataStart))
+			return;
+
+		offset = dataEnd;
+	}
+}
+
+[[nodiscard]] bool isNewer (const struct stat& first, const struct stat& second) noexcept
+{
+	if (first.st_mtim.tv_sec != second.st_mtim.tv_sec)
+		return first.st_mtim.tv_sec > second.st_mtim.tv_sec;
+
+	return first.st_mtim.tv_nsec > second.st_mtim.tv_nsec;
+}
+
+// copies the data of an open regular file, using the fastest strategy that the files support
+[[nodiscard]] Strategy copyContent (int sourceFD, int destFD, const struct stat& sourceInfo, const Path& source, const Path& dest)
+{
+	if (sourceInfo.st_size > 0 && ::ioctl (destFD, FICLONE, sourceFD) == 0)
+		return Strategy::Clone;
+
+	// some files, such as those in /proc, report a size of 0 but still have content, which only reading will reveal
+	const auto sizeIsKnown = sourceInfo.st_size > 0;
+
+	const auto isSparse = static_cast<std::uint64_t> (sourceInfo.st_blocks) * 512 < static_cast<std::uint64_t> (sourceInfo.st_size);
+
+	RangeCopier copier { sourceFD, destFD, sizeIsKnown ? Strategy::CopyFileRange : Strategy::Buffered };
+
+	try
+	{
+		if (! sizeIsKnown)
+			copier.copy (0, std::numeric_limits<std::uint64_t>::max());
+		else if (isSparse)
+			copySparse (copier, sourceFD, sourceInfo.st_size);
+		else
+			copier.copy (0, static_cast<std::uint64_t> (sourceInfo.st_size));
+	}
+	catch (const std::system_error& e)
+	{
+		throwError ("Cannot copy the file's content", source, dest, e.code().value());
+	}
+
+	// recreates the hole at the end of a sparse file, if there is one
+	if (isSparse && ::ftruncate (destFD, sourceInfo.st_size) != 0)
+		throwError ("Cannot set the size of the destination file", source, dest, errno);
+
+	return copier.getStrategy();
+}
+
+}  // namespace
+
+File::CopyStrategy copyFile (const Path& source, const Path& dest, const Settings& settings)
+{
+	using Options = std::filesystem::copy_options;
+
+	const auto options = settings.options;
+
+	const Descriptor sourceFile { ::open (source.c_str(), O_RDONLY | O_CLOEXEC) };
+
+	if (! sourceFile.isValid())
+		throwError ("Cannot open the file to copy", source, dest, errno);
+
+	struct stat sourceInfo {};
+
+	if (::fstat (sourceFile.get(), &sourceInfo) != 0)
+		throwError ("Cannot read the status of the file to copy", source, dest, errno);
+
+	if (! S_ISREG (sourceInfo.st_mode))
+		throwError ("Cannot copy a file that is not a regular file", source, dest, ENOTSUP);
+
+	auto openFlags = O_WRONLY | O_CREAT | O_CLOEXEC;
+
+	if (settings.destinationChecked)
+	{
+		// the caller has already looked at the destination without following symlinks, so don't follow one now
+		openFlags |= O_TRUNC | O_NOFOLLOW;
+	}
+	else
+	{
+		struct stat destInfo {};
+
+		const auto destExists = ::stat (dest.c_str(), &destInfo) == 0;
+
+		if (destExists)
+		{
+			if (! S_ISREG (destInfo.st_mode))
+				throwError ("Cannot overwrite an entry that is not a regular file", source, dest, EEXIST);
+
+			if (destInfo.st_dev == sourceInfo.st_dev && destInfo.st_ino == sourceInfo.st_ino)
+				throwError ("Cannot copy a file to itself", source, dest, EEXIST);
+
+			if ((options & Options::skip_existing) != Options::none)
+				return Strategy::Skipped;
+
+			if ((options & Options::update_existing) != Options::none)
+			{
+				if (! isNewer (sourceInfo, destInfo))
+					return Strategy::Skipped;
+			}
+			else if ((options & Options::overwrite_existing) == Options::none)
+			{
+				throwError ("The destination file already exists", source, dest, EEXIST);
+			}
+		}
+
+		openFlags |= destExists ? O_TRUNC : O_EXCL;
+	}
+
+	const auto permissions = sourceInfo.st_mode & 07777;
+
+	const Descriptor destFile { ::open (dest.c_str(), openFlags, permissions) };
+
+	if (! destFile.isValid())
+		throwError ("Cannot open the destination file", source, dest, errno);
+
+	// the permissions passed to open() are masked by the umask, and ignored if the file already existed
+	if (::fchmod (destFile.get(), permissions) != 0)
+		throwError ("Cannot set the permissions of the destination file", source, dest, errno);
+
+	const auto strategy = copyContent (sourceFile.get(), destFile.get(), sourceInfo, source, dest);
+
+	if (settings.copyModificationTime)
+	{
+		const struct timespec times[2] = { { 0, UTIME_OMIT }, sourceInfo.st_mtim };
+
+		if (::futimens (destFile.get(), times) != 0)
+			throwError ("Cannot set the modification time of the destination file", source, dest, errno);
+	}
+
+	return strategy;
+}
+
+}  // namespace limes::files::filecopy
@@ -13,22 +13,34 @@
  */
 
 #include <sys/inotify.h>
+#include <sys/fanotify.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/types.h>
-#include <sys/select.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
 #include <stdexcept>
-#include <cstring>
-#include <cstdio>
+#include <sstream>
+#include <climits>
 #include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
 #include <vector>
-#include <algorithm>
 #include <mutex>
-#include <chrono>
 #include <memory>
 #include <thread>
 #include "lfilesystem/lfilesystem_Export.h"
 #include "lfilesystem/lfilesystem_FileWatcher.h"
 #include "lfilesystem/lfilesystem_FilesystemEntry.h"
+#include "../lfilesystem_EventDispatcher.h"
+#include "../lfilesystem_Poller.h"
+#include "../lfilesystem_Snapshot.h"
 
 namespace limes::files
 {
@@ -36,208 +48,1042 @@ namespace limes::files
 class LFILE_NO_EXPORT FileWatcher::Impl final
 {
 public:
-	Impl (FileWatcher& parent, const FilesystemEntry& fileToWatch)
-		: watcher (parent), watchedPath (fileToWatch.getAbsolutePath()), file_descriptor (inotify_init())
+	Impl (FileWatcher& parent, const FilesystemEntry& fileToWatch, const Options& options)
+		: dispatcher (parent, options), watchedPath (fileToWatch.getAbsolutePath()), recursive (options.recursive), maxSnapshotEntries (options.maxSnapshotEntries)
 	{
-		if (file_descriptor < 0)
-			throw std::runtime_error { "FileWatcher failed to initialize" };
+		// taken before the watches are added, because reading the directories would otherwise be reported as
+		// events. Anything that changes in between is picked up if the tree is ever compared with the snapshot.
+		// A volume-wide watcher is usually watching a huge tree, and one filesystem mark is cheap to set up, so
+		// it never pays for a snapshot. Compact events exist to avoid building a path for every event, which
+		// keeping the snapshot up to date would require.
+		if (maxSnapshotEntries > 0 && options.backend != Backend::VolumeWide && ! options.compactEvents)
+			snapshot.take (watchedPath, recursive, maxSnapshotEntries);
 
-		watch_descriptor = inotify_add_watch (file_descriptor,
-											  fileToWatch.getAbsolutePath().c_str(),
-											  IN_ACCESS | IN_ATTRIB | IN_CLOSE | IN_CREATE | IN_DELETE | IN_DELETE_SELF
-												  | IN_MODIFY | IN_MOVE | IN_MOVE_SELF | IN_OPEN);
+		auto& reactor = Reactor::get();
 
-		if (watch_descriptor < 0)
+		if (! reactor.add (*this))
 			throw std::runtime_error { "FileWatcher failed to initialize" };
 
-		updaterThread.add (*this);
+		// if fanotify isn't available or permitted, this falls back to inotify
+		if (options.backend == Backend::VolumeWide && addFilesystemMark())
+			return;
 
-		// FD_ZERO (&descriptorSet);
+		if (reactor.addWatch (*this, watchedPath, eventMask) < 0)
+		{
+			reactor.remove (*this);
+			throw std::runtime_error { "FileWatcher failed to initialize" };
+		}
 
-		// timeOut.tv_sec	= 0;
-		// timeOut.tv_usec = 0;
+		// the watch for the root is already in place, so any directories created during this walk will be picked up by handleEvent()
+		if (recursive)
+			addSubtree (watchedPath, false);
 	}
 
 	~Impl()
 	{
-		if (file_descriptor >= 0)
-		{
-			if (watch_descriptor >= 0)
-			{
-				inotify_rm_watch (file_descriptor, watch_descriptor);
-				updaterThread.remove (*this);
-			}
+		// once this returns, no callbacks for this watcher are running on the reactor thread
+		Reactor::get().remove (*this);
 
-			close (file_descriptor);
+		if (fanotify_descriptor >= 0)
+		{
+			close (fanotify_descriptor);
+			close (mount_descriptor);
 		}
 	}
 
+	[[nodiscard]] bool usesFilesystemMark() const noexcept
+	{
+		return fanotify_descriptor >= 0;
+	}
+
 private:
-	void update()
+	// called by the reactor with its mutex held
+	void handleEvent (int wd, std::uint32_t mask, std::uint32_t cookie, std::string_view name)
 	{
-		// FD_SET (file_descriptor, &descriptorSet);
+		const auto* directory = getDirectory (wd);
+
+		if (directory == nullptr)
+			return;
+
+		// removing a subtree that was moved out below may remove this directory's watch, so keep a copy of its path
+		Path directoryCopy;
+
+		if (recursive && movedCookie != 0)
+		{
+			directoryCopy = *directory;
+			directory	  = &directoryCopy;
+		}
+
+		// the full path is only built if something needs it
+		Path path;
+
+		const auto getPath = [&path, directory, name]() -> const Path&
+		{
+			if (path.empty())
+				path = name.empty() ? *directory : *directory / name;
+
+			return path;
+		};
 
-		// const auto ret = select (file_descriptor + 1, &descriptorSet, nullptr, nullptr, &timeOut);
+		const auto isDirectory = (mask & IN_ISDIR) != 0;
 
-		// if (ret < 0)
-		// 	return;
+		if (snapshot.isValid())
+			updateSnapshot (mask, getPath(), isDirectory);
 
-		// if (! FD_ISSET (file_descriptor, &descriptorSet))
-		// 	return;
+		if (recursive)
+		{
+			// the kernel queues the two halves of a rename next to each other, so if this event isn't the other
+			// half of a pending directory move, that directory was moved out of the tree
+			if (movedCookie != 0 && ! (isDirectory && (mask & IN_MOVED_TO) != 0 && cookie == movedCookie))
+			{
+				removeSubtree (movedDirectory);
+				movedCookie = 0;
+			}
+
+			if (isDirectory && (mask & IN_MOVED_FROM) != 0)
+			{
+				movedCookie	   = cookie;
+				movedDirectory = getPath();
+			}
+			else if (isDirectory && (mask & IN_MOVED_TO) != 0 && movedCookie != 0)
+			{
+				// the watches follow the directory's inodes, so only the paths need to be updated
+				renameSubtree (movedDirectory, getPath());
+				movedCookie = 0;
+			}
+			else if (isDirectory && (mask & (IN_CREATE | IN_MOVED_TO)) != 0)
+			{
+				// the contents of a new directory may have been created before its watch was added, so report them too
+				if (! addSubtree (getPath(), (mask & IN_CREATE) != 0))
+					return;
+			}
+		}
 
-		std::memset (&dataBuffer[0], 0, BUF_SIZE);
+		// the deletion or move of a subdirectory is reported by the watch of its parent
+		if (wd != watch_descriptor && (mask & (IN_DELETE_SELF | IN_MOVE_SELF)) != 0)
+			return;
 
-		const auto len = read (file_descriptor, dataBuffer, BUF_SIZE);
+		// these may destroy this object, so they must be the last thing this function does
+		if (dispatcher.usesCompactEvents())
+			handleCompactEvent (*directory, name, mask, cookie);
+		else
+			handleEvent (mask, getPath());
+	}
 
-		for (ssize_t i = 0; i < len;)
+	/* Describes the event without building its path. The two halves of a rename are delivered as one event: the first
+	   half is held until the next event arrives, or until the kernel's queue is empty, in which case the entry was
+	   moved out of the tree.
+	 */
+	void handleCompactEvent (const Path& directory, std::string_view name, std::uint32_t mask, std::uint32_t cookie)
+	{
+		if (pendingMove.cookie != 0)
 		{
-			const auto* prevent = reinterpret_cast<const struct inotify_event*> (&dataBuffer[i]);
+			if ((mask & IN_MOVED_TO) != 0 && cookie == pendingMove.cookie)
+			{
+				Event event;
 
-			if (prevent == nullptr)
+				event.directory	   = directory.native();
+				event.name		   = name;
+				event.events	   = Moved;
+				event.cookie	   = cookie;
+				event.oldDirectory = pendingMove.directory.native();
+				event.oldName	   = pendingMove.name;
+				event.isDirectory  = pendingMove.isDirectory;
+
+				// the strings are kept until the next move, so they outlive the callback
+				pendingMove.cookie = 0;
+
+				dispatcher.deliver (event);
 				return;
+			}
 
-			Path path;
+			if (! flushPendingMove())
+				return;
+		}
 
-			if (const auto* name = prevent->name)
-				path = Path { name };
+		if ((mask & IN_MOVED_FROM) != 0)
+		{
+			pendingMove.cookie		= cookie;
+			pendingMove.directory	= directory;
+			pendingMove.name		= name;
+			pendingMove.isDirectory = (mask & IN_ISDIR) != 0;
 
-			handleEvent (static_cast<std::uint8_t> (prevent->mask), path);
+			Reactor::get().addPendingMove (registrationID);
 
-			i += sizeof (struct inotify_event) + prevent->len;
+			return;
 		}
+
+		Event event;
+
+		event.directory	  = directory.native();
+		event.name		  = name;
+		event.events	  = getEventTypes (mask);
+		event.cookie	  = cookie;
+		event.isDirectory = (mask & IN_ISDIR) != 0;
+
+		dispatcher.deliver (event);
+	}
+
+	// delivers the first half of a rename whose second half never arrived. Returns false if the callback destroyed this watcher
+	bool flushPendingMove()
+	{
+		if (pendingMove.cookie == 0)
+			return true;
+
+		Event event;
+
+		event.directory	  = pendingMove.directory.native();
+		event.name		  = pendingMove.name;
+		event.events	  = Moved;
+		event.cookie	  = pendingMove.cookie;
+		event.isDirectory = pendingMove.isDirectory;
+
+		pendingMove.cookie = 0;
+
+		const auto id = registrationID;
+
+		dispatcher.deliver (event);
+
+		return Reactor::get().isRegistered (id);
 	}
 
-	void handleEvent (std::uint8_t action, const Path& path) const
+	[[nodiscard]] static std::uint32_t getEventTypes (std::uint32_t mask) noexcept
 	{
-		FilesystemEntry file { path };
+		std::uint32_t types { 0 };
+
+		if ((mask & IN_ACCESS) != 0)
+			types |= Accessed;
+
+		if ((mask & IN_ATTRIB) != 0)
+			types |= MetadataChanged;
 
-		file.makeAbsoluteRelativeTo (watchedPath);
+		if ((mask & IN_CLOSE) != 0)
+			types |= HandleClosed;
 
+		if ((mask & IN_CREATE) != 0)
+			types |= Created;
+
+		if ((mask & IN_MODIFY) != 0)
+			types |= Modified;
+
+		if ((mask & IN_OPEN) != 0)
+			types |= Opened;
+
+		if ((mask & (IN_MOVE | IN_MOVE_SELF)) != 0)
+			types |= Moved;
+
+		if ((mask & (IN_DELETE | IN_DELETE_SELF)) != 0)
+			types |= Deleted;
+
+		if ((mask & IN_UNMOUNT) != 0)
+			types |= Other;
+
+		return types;
+	}
+
+	void handleEvent (std::uint32_t action, const Path& path)
+	{
 		if (IN_ACCESS & action)
 		{
-			watcher.fileAccessed (file);
+			dispatcher.dispatch (Accessed, path);
 			return;
 		}
 
 		if (IN_ATTRIB & action)
 		{
-			watcher.fileMetadataChanged (file);
+			dispatcher.dispatch (MetadataChanged, path);
 			return;
 		}
 
 		if (IN_CLOSE & action)
 		{
-			watcher.fileHandleClosed (file);
+			dispatcher.dispatch (HandleClosed, path);
 			return;
 		}
 
 		if (IN_CREATE & action)
 		{
-			watcher.fileCreated (file);
+			dispatcher.dispatch (Created, path);
 			return;
 		}
 
 		if (IN_MODIFY & action)
 		{
-			watcher.fileModified (file);
+			dispatcher.dispatch (Modified, path);
 			return;
 		}
 
 		if (IN_OPEN & action)
 		{
-			watcher.fileOpened (file);
+			dispatcher.dispatch (Opened, path);
 			return;
 		}
 
 		if (IN_MOVE_SELF & action || IN_MOVE & action)
 		{
-			watcher.fileMoved (file);
+			dispatcher.dispatch (Moved, path);
 			return;
 		}
 
 		if (IN_DELETE & action || IN_DELETE_SELF & action)
-			watcher.fileDeleted (file);
+		{
+			dispatcher.dispatch (Deleted, path);
+			return;
+		}
+
+		if (IN_UNMOUNT & action)
+			dispatcher.dispatch (Other, path);
+	}
+
+	// keeps the snapshot in line with the events that are reported, so that a rescan doesn't report them again
+	void updateSnapshot (std::uint32_t mask, const Path& path, bool isDirectory)
+	{
+		if (! snapshot.isValid())
+			return;
+
+		if ((mask & (IN_DELETE | IN_DELETE_SELF | IN_MOVED_FROM)) != 0)
+			snapshot.removeEntry (path);
+		else if ((mask & (IN_CREATE | IN_MOVED_TO | IN_ATTRIB | IN_CLOSE_WRITE)) != 0)
+			snapshot.refreshEntry (path);
+		else if ((mask & IN_MODIFY) != 0)
+			snapshot.markReported (path, isDirectory);
+	}
+
+	// called by the reactor with its mutex held, when the kernel's event queue has overflowed
+	void handleOverflow()
+	{
+		auto& reactor = Reactor::get();
+
+		const auto id = registrationID;
+
+		dispatcher.notifyEventsLost();
+
+		if (! reactor.isRegistered (id) || ! snapshot.isValid())
+			return;
+
+		Snapshot newSnapshot;
+
+		if (! newSnapshot.take (watchedPath, recursive, maxSnapshotEntries))
+		{
+			snapshot.clear();
+			return;
+		}
+
+		const auto differences = snapshot.compare (newSnapshot);
+
+		snapshot = std::move (newSnapshot);
+
+		// directories may have been created while events were being dropped
+		if (recursive && ! usesFilesystemMark())
+			for (const auto& difference : differences)
+				if (difference.isDirectory && difference.type == Created)
+					addSubdirectory (difference.path);
+
+		for (const auto& difference : differences)
+		{
+			dispatcher.dispatch (difference.type, difference.path);
+
+			if (! reactor.isRegistered (id))
+				return;
+		}
+	}
+
+	[[nodiscard]] const Path* getDirectory (int wd) const
+	{
+		if (wd == watch_descriptor)
+			return &watchedPath;
+
+		if (const auto it = subdirectories.find (wd); it != subdirectories.end())
+			return &it->second;
+
+		return nullptr;
+	}
+
+	/* Adds watches for a directory and all the directories below it. Only the new directory itself is listed;
+	   the rest of the tree is reached through the watches' own events, so no event ever causes a full rescan.
+
+	   If reportContents is true, a fileCreated() callback is made for each entry found. Returns false if a callback
+	   destroyed this watcher.
+	 */
+	bool addSubtree (const Path& directory, bool reportContents)
+	{
+		auto& reactor = Reactor::get();
+
+		const auto id = registrationID;
+
+		if (directory != watchedPath && ! addSubdirectory (directory))
+			return true;
+
+		namespace fs = std::filesystem;
+
+		std::error_code ec;
+
+		for (fs::recursive_directory_iterator it { directory, fs::directory_options::skip_permission_denied, ec };
+			 ! ec && it != fs::recursive_directory_iterator {};
+			 it.increment (ec))
+		{
+			const auto& entry = *it;
+
+			// these use the type reported by the directory listing, whereas symlink_status() always calls lstat()
+			std::error_code typeError;
+
+			if (! entry.is_symlink (typeError) && entry.is_directory (typeError) && ! addSubdirectory (entry.path()))
+				it.disable_recursion_pending();
+
+			if (reportContents)
+			{
+				if (snapshot.isValid())
+					snapshot.refreshEntry (entry.path());
+
+				dispatcher.dispatch (Created, entry.path());
+
+				if (! reactor.isRegistered (id))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool addSubdirectory (const Path& directory)
+	{
+		return Reactor::get().addWatch (*this, directory, eventMask | IN_ONLYDIR | IN_DONT_FOLLOW) >= 0;
+	}
+
+	[[nodiscard]] static bool isInSubtree (const Path& path, const Path& directory)
+	{
+		const auto& str	   = path.native();
+		const auto& prefix = directory.native();
+
+		if (! str.starts_with (prefix))
+			return false;
+
+		// the directory may be a root, such as the root of a volume
+		return str.size() == prefix.size() || prefix.ends_with ('/') || str[prefix.size()] == '/';
+	}
+
+	// removes the watches for a directory that was moved out of the tree
+	void removeSubtree (const Path& directory)
+	{
+		for (auto it = subdirectories.begin(); it != subdirectories.end();)
+		{
+			if (isInSubtree (it->second, directory))
+			{
+				Reactor::get().removeWatch (*this, it->first);
+				it = subdirectories.erase (it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	void renameSubtree (const Path& from, const Path& to)
+	{
+		const auto prefixLength = from.native().size();
+
+		for (auto& subdirectory : subdirectories)
+			if (isInSubtree (subdirectory.second, from))
+				subdirectory.second = to.native() + subdirectory.second.native().substr (prefixLength);
+	}
+
+	/* In volume-wide mode, a single fanotify mark reports the events for every inode on the filesystem, identified
+	   by the file handle of the parent directory and the entry's name. The handles are resolved to paths by opening
+	   them, and the paths of recently seen directories are cached until a directory is moved or deleted.
+	 */
+
+#ifdef FAN_REPORT_DFID_NAME
+	// the fanotify event bits have the same values as their inotify counterparts, so the events are decoded the same way
+	static_assert (FAN_MODIFY == IN_MODIFY && FAN_ATTRIB == IN_ATTRIB && FAN_CLOSE_WRITE == IN_CLOSE_WRITE
+				   && FAN_MOVED_FROM == IN_MOVED_FROM && FAN_MOVED_TO == IN_MOVED_TO && FAN_CREATE == IN_CREATE
+				   && FAN_DELETE == IN_DELETE && FAN_DELETE_SELF == IN_DELETE_SELF && FAN_MOVE_SELF == IN_MOVE_SELF
+				   && FAN_ONDIR == IN_ISDIR);
+
+	static constexpr std::uint64_t fanotifyMask = FAN_MODIFY | FAN_ATTRIB | FAN_CLOSE_WRITE | FAN_MOVED_FROM | FAN_MOVED_TO
+												| FAN_CREATE | FAN_DELETE | FAN_DELETE_SELF | FAN_MOVE_SELF | FAN_ONDIR;
+
+	bool addFilesystemMark()
+	{
+		const auto fd = fanotify_init (FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK | FAN_REPORT_DFID_NAME,
+									   O_RDONLY | O_CLOEXEC | O_LARGEFILE);
+
+		if (fd < 0)
+			return false;
+
+		// open_by_handle_at() needs a descriptor for any object on the same filesystem
+		const auto mountFd = open (watchedPath.c_str(), O_RDONLY | O_CLOEXEC);
+
+		if (mountFd < 0
+			|| fanotify_mark (fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, fanotifyMask, AT_FDCWD, watchedPath.c_str()) != 0)
+		{
+			if (mountFd >= 0)
+				close (mountFd);
+
+			close (fd);
+			return false;
+		}
+
+		// set before events can arrive
+		mount_descriptor = mountFd;
+
+		if (! Reactor::get().addDescriptor (*this, fd))
+		{
+			close (mountFd);
+			close (fd);
+
+			mount_descriptor = -1;
+
+			return false;
+		}
+
+		return true;
+	}
+
+	// called by the reactor with its mutex held; reads one buffer's worth of events
+	void readFilesystemEvents()
+	{
+		alignas (struct fanotify_event_metadata) std::array<char, 8192> eventBuffer;
+
+		auto length = read (fanotify_descriptor, eventBuffer.data(), eventBuffer.size());
+
+		auto& reactor = Reactor::get();
+
+		const auto id = registrationID;
+
+		for (auto* event = reinterpret_cast<struct fanotify_event_metadata*> (eventBuffer.data());
+			 FAN_EVENT_OK (event, length);
+			 event = FAN_EVENT_NEXT (event, length))
+		{
+			if ((event->mask & FAN_Q_OVERFLOW) != 0)
+			{
+				handleOverflow();
+
+				if (! reactor.isRegistered (id))
+					return;
+
+				continue;
+			}
+
+			const auto mask		   = static_cast<std::uint32_t> (event->mask);
+			const auto isDirectory = (mask & FAN_ONDIR) != 0;
+
+			if (isDirectory && (mask & (FAN_MOVED_FROM | FAN_MOVED_TO | FAN_DELETE | FAN_DELETE_SELF | FAN_MOVE_SELF)) != 0)
+				directoryPaths.clear();
+
+			const auto path = resolveEventPath (*event);
+
+			if (path.empty() || ! isWatched (path))
+				continue;
+
+			updateSnapshot (mask, path, isDirectory);
+
+			// fanotify merges consecutive events for the same entry, so one event may carry several of them
+			for (const auto type : { FAN_CREATE, FAN_MOVED_TO, FAN_MODIFY, FAN_ATTRIB, FAN_CLOSE_WRITE,
+									 FAN_MOVED_FROM, FAN_MOVE_SELF, FAN_DELETE, FAN_DELETE_SELF })
+			{
+				if ((mask & type) == 0)
+					continue;
+
+				handleEvent (static_cast<std::uint32_t> (type), path);
+
+				if (! reactor.isRegistered (id))
+					return;
+			}
+		}
+	}
+
+	// returns an empty path if the event's directory no longer exists
+	[[nodiscard]] Path resolveEventPath (const struct fanotify_event_metadata& event)
+	{
+		const auto* info = reinterpret_cast<const char*> (&event) + event.metadata_len;
+		const auto* end	 = reinterpret_cast<const char*> (&event) + event.event_len;
+
+		while (info + sizeof (struct fanotify_event_info_header) <= end)
+		{
+			const auto* header = reinterpret_cast<const struct fanotify_event_info_header*> (info);
+
+			if (header->len == 0)
+				break;
+
+			info += header->len;
+
+			if (header->info_type != FAN_EVENT_INFO_TYPE_DFID_NAME && header->info_type != FAN_EVENT_INFO_TYPE_DFID)
+				continue;
+
+			const auto* fid	   = reinterpret_cast<const struct fanotify_event_info_fid*> (header);
+			const auto* handle = reinterpret_cast<const struct file_handle*> (fid->handle);
+
+			auto directory = resolveHandle (*handle);
+
+			if (directory.empty() || header->info_type == FAN_EVENT_INFO_TYPE_DFID)
+				return directory;
+
+			// the name follows the handle; events for the directory itself are reported with the name "."
+			const std::string_view name { reinterpret_cast<const char*> (handle->f_handle + handle->handle_bytes) };
+
+			if (name.empty() || name == ".")
+				return directory;
+
+			return directory / name;
+		}
+
+		return {};
+	}
+
+	[[nodiscard]] Path resolveHandle (const struct file_handle& handle)
+	{
+		std::string key { reinterpret_cast<const char*> (&handle), sizeof (struct file_handle) + handle.handle_bytes };
+
+		if (const auto it = directoryPaths.find (key); it != directoryPaths.end())
+			return it->second;
+
+		// open_by_handle_at() takes a non-const handle
+		auto* const mutableHandle = reinterpret_cast<struct file_handle*> (key.data());
+
+		const auto fd = open_by_handle_at (mount_descriptor, mutableHandle, O_PATH | O_CLOEXEC);
+
+		if (fd < 0)
+			return {};
+
+		std::error_code ec;
+
+		Path path = std::filesystem::read_symlink ("/proc/self/fd/" + std::to_string (fd), ec);
+
+		close (fd);
+
+		if (ec)
+			return {};
+
+		if (directoryPaths.size() >= maxCachedDirectories)
+			directoryPaths.clear();
+
+		directoryPaths.emplace (std::move (key), path);
+
+		return path;
+	}
+#else
+	bool addFilesystemMark()
+	{
+		return false;
+	}
+
+	void readFilesystemEvents() { }
+#endif
+
+	[[nodiscard]] bool isWatched (const Path& path) const
+	{
+		if (recursive)
+			return isInSubtree (path, watchedPath);
+
+		return path == watchedPath || path.parent_path() == watchedPath;
+	}
+
+	// called by the reactor with its mutex held
+	void watchAdded (int wd, const Path& directory)
+	{
+		if (directory == watchedPath)
+			watch_descriptor = wd;
+		else if (wd != watch_descriptor)
+			subdirectories.insert_or_assign (wd, directory);
+	}
+
+	// called by the reactor when the kernel has removed a watch, for example because the watched entry was deleted
+	void watchRemoved (int wd)
+	{
+		if (wd == watch_descriptor)
+			watch_descriptor = -1;
+		else
+			subdirectories.erase (wd);
 	}
 
-	FileWatcher& watcher;
+	static constexpr std::uint32_t eventMask = IN_ACCESS | IN_ATTRIB | IN_CLOSE | IN_CREATE | IN_DELETE | IN_DELETE_SELF
+											 | IN_MODIFY | IN_MOVE | IN_MOVE_SELF | IN_OPEN;
+
+	EventDispatcher dispatcher;
 
 	Path watchedPath;
 
-	int file_descriptor, watch_descriptor;
+	const bool recursive;
 
-	static constexpr auto BUF_SIZE = (sizeof (struct inotify_event) + FILENAME_MAX) * 1024;
+	const std::size_t maxSnapshotEntries;
 
-	char dataBuffer[BUF_SIZE] = { 0 };
+	// only accessed with the reactor's mutex held
+	Snapshot snapshot;
+
+	// -1 once the kernel has removed the watch, for example because the watched file was deleted
+	int watch_descriptor { -1 };
+
+	// only used in recursive mode. Maps the watch descriptor of each subdirectory to its absolute path
+	std::unordered_map<int, Path> subdirectories;
+
+	// the first half of a directory rename that hasn't been matched with its second half yet
+	std::uint32_t movedCookie { 0 };
+	Path		  movedDirectory;
+
+	// only used with compact events. The first half of a rename that hasn't been delivered yet
+	struct PendingMove final
+	{
+		std::uint32_t cookie { 0 };
+		Path		  directory;
+		std::string	  name;
+		bool		  isDirectory { false };
+	};
 
-	// fd_set descriptorSet;
+	PendingMove pendingMove;
 
-	// struct timeval timeOut;
+	// only used in volume-wide mode. The fanotify descriptor is registered with the reactor's epoll descriptor
+	int fanotify_descriptor { -1 }, mount_descriptor { -1 };
+
+	// only used in volume-wide mode. Maps the file handles of recently seen directories to their paths
+	std::unordered_map<std::string, Path> directoryPaths;
+
+	static constexpr std::size_t maxCachedDirectories { 4096 };
+
+	// assigned by the reactor, and never reused, so that stale events can't reach a new watcher
+	std::uint64_t registrationID { 0 };
 
 	/*---------------------------------------------------------------------------------------------------------------------*/
 
-	struct UpdaterThread final
+	/* All the watchers in the process share a single inotify descriptor, and one background thread waits on it
+	   with epoll and calls the watchers' callbacks as soon as the kernel reports events. This keeps the state
+	   of each watcher small, and avoids the per-user limit on inotify instances (often only 128).
+
+	   inotify returns the same watch descriptor for each watch of the same inode, so several watchers may
+	   share one watch descriptor. The kernel watch is removed when the last of them is removed.
+
+	   The callbacks are made with the mutex held, so a watcher removed from another thread is guaranteed to
+	   receive no more callbacks once remove() returns. The mutex is recursive so that a watcher can be stopped,
+	   started, or destroyed from inside one of its own callbacks.
+	 */
+	struct Reactor final
 	{
 	public:
-		void add (Impl& watcher)
+		static Reactor& get()
+		{
+			static Reactor reactor;
+			return reactor;
+		}
+
+		~Reactor()
 		{
 			{
-				const std::lock_guard g { mutex };
+				const std::lock_guard lock { mutex };
 
-				watchers.emplace_back (&watcher);
+				stopping = true;
 			}
 
-			if (thread.get() == nullptr)
+			wake();
+
+			if (thread.joinable())
+				thread.join();
+
+			close (inotify_descriptor);
+			close (epoll_descriptor);
+			close (event_descriptor);
+		}
+
+		Reactor (const Reactor&)			= delete;
+		Reactor& operator= (const Reactor&) = delete;
+
+		[[nodiscard]] bool add (Impl& impl)
+		{
+			const std::lock_guard lock { mutex };
+
+			if (! initialized)
+				return false;
+
+			impl.registrationID = nextID++;
+
+			watchers.emplace (impl.registrationID, &impl);
+
+			if (! running)
 			{
-				thread.reset (new std::jthread {
-					[this]
-					{
-						while (! thread->get_stop_token().stop_requested())
-						{
-							{
-								const std::lock_guard g_ { mutex };
+				// the previous thread has already released the mutex for the last time, so this can't deadlock
+				if (thread.joinable())
+					thread.join();
+
+				running = true;
+
+				thread = std::thread { [this]
+									   { run(); } };
+			}
+
+			return true;
+		}
+
+		void remove (Impl& impl)
+		{
+			{
+				const std::lock_guard lock { mutex };
+
+				watchers.erase (impl.registrationID);
+
+				removeWatch (impl, impl.watch_descriptor);
+
+				for (const auto& subdirectory : impl.subdirectories)
+					removeWatch (impl, subdirectory.first);
+
+				if (impl.fanotify_descriptor >= 0)
+					epoll_ctl (epoll_descriptor, EPOLL_CTL_DEL, impl.fanotify_descriptor, nullptr);
+
+				if (! watchers.empty())
+					return;
+			}
+
+			// wake the thread immediately so that it can exit
+			wake();
+		}
+
+		// returns the watch descriptor, or -1 if the watch couldn't be added
+		[[nodiscard]] int addWatch (Impl& impl, const Path& path, std::uint32_t mask)
+		{
+			const std::lock_guard lock { mutex };
+
+			const auto wd = inotify_add_watch (inotify_descriptor, path.c_str(), mask);
+
+			if (wd < 0)
+				return -1;
+
+			// adding a watch for an inode that is already watched returns the existing watch descriptor
+			auto& ids = watchersByDescriptor[wd];
+
+			if (std::find (ids.begin(), ids.end(), impl.registrationID) == ids.end())
+				ids.push_back (impl.registrationID);
+
+			impl.watchAdded (wd, path);
+
+			return wd;
+		}
+
+		void removeWatch (Impl& impl, int wd)
+		{
+			const std::lock_guard lock { mutex };
+
+			const auto it = watchersByDescriptor.find (wd);
 
-								for (auto* w : watchers)
-									w->update();
-							}
+			if (it == watchersByDescriptor.end())
+				return;
+
+			auto& ids = it->second;
 
-							if (! thread->get_stop_token().stop_requested())
-								std::this_thread::sleep_for (std::chrono::milliseconds (250));
-						}
-					} });
+			std::erase (ids, impl.registrationID);
 
-				thread->detach();
+			if (ids.empty())
+			{
+				inotify_rm_watch (inotify_descriptor, wd);
+				watchersByDescriptor.erase (it);
 			}
 		}
 
-		void remove (Impl& watcher)
+		// called by a watcher that is holding the first half of a rename until the kernel's queue is empty
+		void addPendingMove (std::uint64_t id)
+		{
+			pendingMoves.push_back (id);
+		}
+
+		// adds a watcher's own fanotify descriptor to the set that the background thread waits on
+		[[nodiscard]] bool addDescriptor (Impl& impl, int fd)
 		{
-			const std::lock_guard g { mutex };
+			const std::lock_guard lock { mutex };
+
+			struct epoll_event event = {};
+
+			event.events   = EPOLLIN;
+			event.data.u64 = descriptorFlag | impl.registrationID;
+
+			if (epoll_ctl (epoll_descriptor, EPOLL_CTL_ADD, fd, &event) != 0)
+				return false;
+
+			impl.fanotify_descriptor = fd;
+
+			return true;
+		}
 
-			watchers.erase (std::find (std::begin (watchers), std::end (watchers), &watcher));
+		[[nodiscard]] bool isRegistered (std::uint64_t id)
+		{
+			const std::lock_guard lock { mutex };
 
-			if (watchers.empty())
-				thread.reset();
+			return watchers.contains (id);
 		}
 
 	private:
-		std::vector<Impl*> watchers;
+		Reactor()
+			: inotify_descriptor (inotify_init1 (IN_NONBLOCK | IN_CLOEXEC)),
+			  epoll_descriptor (epoll_create1 (EPOLL_CLOEXEC)),
+			  event_descriptor (eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC))
+		{
+			if (inotify_descriptor < 0 || epoll_descriptor < 0 || event_descriptor < 0)
+				return;
 
-		std::mutex mutex;
+			struct epoll_event event = {};
 
-		std::unique_ptr<std::jthread> thread;
-	};
+			event.events   = EPOLLIN;
+			event.data.u64 = wakeID;
+
+			if (epoll_ctl (epoll_descriptor, EPOLL_CTL_ADD, event_descriptor, &event) != 0)
+				return;
+
+			event.data.u64 = inotifyID;
+
+			initialized = epoll_ctl (epoll_descriptor, EPOLL_CTL_ADD, inotify_descriptor, &event) == 0;
+		}
+
+		void wake() const noexcept
+		{
+			const std::uint64_t value { 1 };
+
+			[[maybe_unused]] const auto res = write (event_descriptor, &value, sizeof (value));
+		}
+
+		void run()
+		{
+			std::array<struct epoll_event, 64> events;
+
+			while (true)
+			{
+				const auto numEvents = epoll_wait (epoll_descriptor, events.data(), static_cast<int> (events.size()), -1);
+
+				const std::lock_guard lock { mutex };
+
+				if (stopping || watchers.empty() || (numEvents < 0 && errno != EINTR))
+				{
+					running = false;
+					return;
+				}
+
+				for (auto i = 0; i < numEvents; ++i)
+				{
+					const auto data = events[static_cast<std::size_t> (i)].data.u64;
+
+					if (data == inotifyID)
+					{
+						readEvents();
+					}
+					else if ((data & descriptorFlag) != 0)
+					{
+						// the watcher may have been removed after epoll_wait() returned
+						if (const auto found = watchers.find (data & ~descriptorFlag); found != watchers.end())
+							found->second->readFilesystemEvents();
+					}
+					else
+					{
+						std::uint64_t value;
+
+						[[maybe_unused]] const auto res = read (event_descriptor, &value, sizeof (value));
+					}
+				}
+			}
+		}
+
+		// reads one buffer's worth of events; if there are more, epoll reports the descriptor as ready again
+		void readEvents()
+		{
+			const auto len = read (inotify_descriptor, buffer.data(), buffer.size());
+
+			for (ssize_t i = 0; i < len;)
+			{
+				const auto* event = reinterpret_cast<const struct inotify_event*> (&buffer[static_cast<std::size_t> (i)]);
+
+				i += static_cast<ssize_t> (sizeof (struct inotify_event) + event->len);
+
+				// the queue is shared, so every watcher may have lost events
+				if ((event->mask & IN_Q_OVERFLOW) != 0)
+				{
+					dispatchList.clear();
+
+					for (const auto& watcher : watchers)
+						dispatchList.push_back (watcher.first);
+
+					for (const auto id : dispatchList)
+						if (const auto found = watchers.find (id); found != watchers.end())
+							found->second->handleOverflow();
+
+					continue;
+				}
 
-	UpdaterThread updaterThread; // should be static, but that caused unresolved external symbol errors in MSVC...
+				const auto it = watchersByDescriptor.find (event->wd);
+
+				// events may still arrive for a watch descriptor after all of its watchers have been removed
+				if (it == watchersByDescriptor.end())
+					continue;
+
+				// the kernel has removed this watch, so it must not be removed again by the watchers
+				if ((event->mask & IN_IGNORED) != 0)
+				{
+					for (const auto id : it->second)
+						if (const auto found = watchers.find (id); found != watchers.end())
+							found->second->watchRemoved (event->wd);
+
+					watchersByDescriptor.erase (it);
+
+					continue;
+				}
+
+				const std::string_view name { event->len > 0 ? event->name : "" };
+
+				// the callbacks may add or remove watchers, so iterate over a copy of the list
+				dispatchList = it->second;
+
+				for (const auto id : dispatchList)
+					if (const auto found = watchers.find (id); found != watchers.end())
+						found->second->handleEvent (event->wd, event->mask, event->cookie, name);
+			}
+
+			// if the queue is now empty, the second halves of any pending renames aren't coming
+			if (len < static_cast<ssize_t> (buffer.size() - (sizeof (struct inotify_event) + NAME_MAX + 1)) && ! pendingMoves.empty())
+			{
+				dispatchList.swap (pendingMoves);
+				pendingMoves.clear();
+
+				for (const auto id : dispatchList)
+					if (const auto found = watchers.find (id); found != watchers.end())
+						found->second->flushPendingMove();
+			}
+		}
+
+		static constexpr std::uint64_t wakeID { 0 }, inotifyID { 1 };
+
+		// set in the epoll data of a watcher's own descriptor, whose other bits are the watcher's registration ID
+		static constexpr std::uint64_t descriptorFlag { std::uint64_t { 1 } << 63 };
+
+		int inotify_descriptor, epoll_descriptor, event_descriptor;
+
+		bool initialized { false };
+
+		std::recursive_mutex mutex;
+
+		// the IDs are never reused, so a watcher created by a callback can't receive the rest of the events for another one
+		std::unordered_map<std::uint64_t, Impl*> watchers;
+
+		std::unordered_map<int, std::vector<std::uint64_t>> watchersByDescriptor;
+
+		std::vector<std::uint64_t> dispatchList, pendingMoves;
+
+		std::uint64_t nextID { 0 };
+
+		std::thread thread;
+
+		bool running { false }, stopping { false };
+
+		// large enough for many events at once; a single event needs at most sizeof(inotify_event) + NAME_MAX + 1 bytes
+		alignas (struct inotify_event) std::array<char, (sizeof (struct inotify_event) + NAME_MAX + 1) * 64> buffer;
+	};
 };
 
 /*---------------------------------------------------------------------------------------------------------------------*/
 
 FileWatcher::FileWatcher (const FilesystemEntry& fileToWatch)
-	: watchedPath (fileToWatch)
+	: FileWatcher (fileToWatch, Options {})
+{
+}
+
+FileWatcher::FileWatcher (const FilesystemEntry& fileToWatch, const Options& optionsToUse)
+	: watchedPath (fileToWatch), options (optionsToUse)
 {
 	if (fileToWatch.exists())
 	{
-		pimpl.reset (new Impl { *this, watchedPath });
+		startBackend();
 	}
 	else
 	{
@@ -262,7 +1108,7 @@ bool FileWatcher::start()
 	if (! watchedPath.exists())
 		return false;
 
-	pimpl.reset (new Impl { *this, watchedPath });
+	startBackend();
 
 	return isRunning();
 }
@@ -279,19 +1125,48 @@ bool FileWatcher::start (const FilesystemEntry& newPathToWatch)
 
 	watchedPath = newPathToWatch;
 
-	pimpl.reset (new Impl { *this, watchedPath });
+	startBackend();
 
 	return isRunning();
 }
 
+bool FileWatcher::start (const FilesystemEntry& newPathToWatch, const Options& newOptions)
+{
+	stop();
+
+	options = newOptions;
+
+	return start (newPathToWatch);
+}
+
+void FileWatcher::startBackend()
+{
+	if (options.backend == Backend::Polling)
+		poller = std::make_unique<Poller> (*this, watchedPath, options);
+	else
+		pimpl.reset (new Impl { *this, watchedPath, options });
+}
+
+FileWatcher::Backend FileWatcher::getBackend() const noexcept
+{
+	if (poller != nullptr)
+		return Backend::Polling;
+
+	if (pimpl != nullptr)
+		return pimpl->usesFilesystemMark() ? Backend::VolumeWide : Backend::Native;
+
+	return options.backend;
+}
+
 void FileWatcher::stop()
 {
 	pimpl.reset();
+	poller.reset();
 }
 
 bool FileWatcher::isRunning()
 {
-	return pimpl.get() != nullptr;
+	return pimpl.get() != nullptr || poller.get() != nullptr;
 }
 
 bool FileWatcher::supportedBySystem() noexcept
@@ -304,4 +1179,9 @@ FilesystemEntry FileWatcher::getWatchedPath() const noexcept
 	return watchedPath;
 }
 
+FileWatcher::Options FileWatcher::getOptions() const noexcept
+{
+	return options;
+}
+
 }  // namespace files
@@ -18,6 +18,8 @@
 #include "lfilesystem/lfilesystem_Export.h"
 #include "lfilesystem/lfilesystem_FileWatcher.h"
 #include "lfilesystem/lfilesystem_FilesystemEntry.h"
+#include "../lfilesystem_EventDispatcher.h"
+#include "../lfilesystem_Poller.h"
 
 namespace limes::files
 {
@@ -25,8 +27,8 @@
 class LFILE_NO_EXPORT FileWatcher::Impl final
 {
 public:
-	Impl (FileWatcher& parent, const FilesystemEntry& fileToWatch)
-		: watcher (parent), watchedPath (fileToWatch.getAbsolutePath())
+	Impl (FileWatcher& parent, const FilesystemEntry& fileToWatch, const Options& options)
+		: dispatcher (parent, options), watchedPath (fileToWatch.getAbsolutePath()), recursive (options.recursive)
 	{
 		NSString* newPath = [NSString stringWithUTF8String:fileToWatch.getAbsolutePath().c_str()];	// cppcheck-suppress syntaxError
 
@@ -80,56 +82,65 @@ static void callback (ConstFSEventStreamRef,
 	}
 
 private:
-	void handleEvent (const Path& path, FSEventStreamEventFlags flags) const
+	void handleEvent (const Path& path, FSEventStreamEventFlags flags)
 	{
-		FilesystemEntry file { path };
+		// the events below this path were coalesced or dropped, so they can't be reported individually
+		if (flags & (kFSEventStreamEventFlagMustScanSubDirs | kFSEventStreamEventFlagKernelDropped | kFSEventStreamEventFlagUserDropped))
+		{
+			dispatcher.notifyEventsLost();
+			return;
+		}
 
-		file.makeAbsoluteRelativeTo (watchedPath);
+		// FSEvents always reports events for the whole tree
+		if (! recursive && path != watchedPath && path.parent_path() != watchedPath)
+			return;
 
 		if (flags & kFSEventStreamEventFlagItemModified)
 		{
-			watcher.fileModified (file);
+			dispatcher.dispatch (Modified, path);
 			return;
 		}
 
 		if (flags & kFSEventStreamEventFlagItemRenamed)
 		{
-			watcher.fileMoved (file);
+			dispatcher.dispatch (Moved, path);
 			return;
 		}
 
 		if (flags & kFSEventStreamEventFlagItemCreated)
 		{
-			watcher.fileCreated (file);
+			dispatcher.dispatch (Created, path);
 			return;
 		}
 
 		if (flags & kFSEventStreamEventFlagRootChanged)
 		{
-			watcher.otherEventType (file);
+			dispatcher.dispatch (Other, path);
 			return;
 		}
 
 		if (flags & kFSEventStreamEventFlagItemCloned)
 		{
-			watcher.fileAccessed (file);
+			dispatcher.dispatch (Accessed, path);
 			return;
 		}
 
 		if (flags & kFSEventStreamEventFlagItemChangeOwner || flags & kFSEventStreamEventFlagItemXattrMod)
 		{
-			watcher.fileMetadataChanged (file);
+			dispatcher.dispatch (MetadataChanged, path);
 			return;
 		}
 
 		if (flags & kFSEventStreamEventFlagItemRemoved)
-			watcher.fileDeleted (file);
+			dispatcher.dispatch (Deleted, path);
 	}
 
-	FileWatcher& watcher;
+	EventDispatcher dispatcher;
 
 	Path watchedPath;
 
+	const bool recursive;
+
 	NSArray*					paths;
 	FSEventStreamRef			stream;
 	struct FSEventStreamContext context;
@@ -138,11 +149,16 @@ void handleEvent (const Path& path, FSEventStreamEventFlags flags) const
 /*---------------------------------------------------------------------------------------------------------------------*/
 
 FileWatcher::FileWatcher (const FilesystemEntry& fileToWatch)
-	: watchedPath (fileToWatch)
+	: FileWatcher (fileToWatch, Options {})
+{
+}
+
+FileWatcher::FileWatcher (const FilesystemEntry& fileToWatch, const Options& optionsToUse)
+	: watchedPath (fileToWatch), options (optionsToUse)
 {
 	if (fileToWatch.exists())
 	{
-		pimpl.reset (new Impl { *this, watchedPath });
+		startBackend();
 	}
 	else
 	{
@@ -167,7 +183,7 @@ void handleEvent (const Path& path, FSEventStreamEventFlags flags) const
 	if (! watchedPath.exists())
 		return false;
 
-	pimpl.reset (new Impl { *this, watchedPath });
+	startBackend();
 
 	return isRunning();
 }
@@ -184,19 +200,49 @@ void handleEvent (const Path& path, FSEventStreamEventFlags flags) const
 
 	watchedPath = newPathToWatch;
 
-	pimpl.reset (new Impl { *this, watchedPath });
+	startBackend();
 
 	return isRunning();
 }
 
+bool FileWatcher::start (const FilesystemEntry& newPathToWatch, const Options& newOptions)
+{
+	stop();
+
+	options = newOptions;
+
+	return start (newPathToWatch);
+}
+
+void FileWatcher::startBackend()
+{
+	if (options.backend == Backend::Polling)
+		poller = std::make_unique<Poller> (*this, watchedPath, options);
+	else
+		pimpl.reset (new Impl { *this, watchedPath, options });
+}
+
+FileWatcher::Backend FileWatcher::getBackend() const noexcept
+{
+	if (poller != nullptr)
+		return Backend::Polling;
+
+	// there is no volume-wide backend on this system
+	if (pimpl != nullptr)
+		return Backend::Native;
+
+	return options.backend;
+}
+
 void FileWatcher::stop()
 {
 	pimpl.reset();
+	poller.reset();
 }
 
 bool FileWatcher::isRunning()
 {
-	return pimpl.get() != nullptr;
+	return pimpl.get() != nullptr || poller.get() != nullptr;
 }
 
 bool FileWatcher::supportedBySystem() noexcept
@@ -209,4 +255,9 @@ void handleEvent (const Path& path, FSEventStreamEventFlags flags) const
 	return watchedPath;
 }
 
+FileWatcher::Options FileWatcher::getOptions() const noexcept
+{
+	return options;
+}
+
 }  // namespace files
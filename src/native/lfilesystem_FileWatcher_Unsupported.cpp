@@ -12,41 +12,104 @@
  * ======================================================================================
  */
 
+#include <sstream>
+#include <stdexcept>
 #include "lfilesystem/lfilesystem_Export.h"
 #include "lfilesystem/lfilesystem_FileWatcher.h"
+#include "../lfilesystem_Poller.h"
 
 namespace limes::files
 {
 
+// this system has no native API, so every watcher uses the polling backend
 class LFILE_NO_EXPORT FileWatcher::Impl
 {
 };
 
-FileWatcher::FileWatcher (const FilesystemEntry&)
+FileWatcher::FileWatcher (const FilesystemEntry& fileToWatch)
+	: FileWatcher (fileToWatch, Options {})
 {
 }
 
+FileWatcher::FileWatcher (const FilesystemEntry& fileToWatch, const Options& optionsToUse)
+	: watchedPath (fileToWatch), options (optionsToUse)
+{
+	if (fileToWatch.exists())
+	{
+		startBackend();
+	}
+	else
+	{
+		std::stringstream stream;
+
+		stream << "FileWatcher: cannot watch non-existent file "
+			   << fileToWatch.getAbsolutePath().string();
+
+		throw std::runtime_error { stream.str() };
+	}
+}
+
 FileWatcher::FileWatcher() noexcept { }
 
 FileWatcher::~FileWatcher() { }
 
 bool FileWatcher::start()
 {
-	return false;
+	if (isRunning())
+		return true;
+
+	if (! watchedPath.exists())
+		return false;
+
+	startBackend();
+
+	return isRunning();
 }
 
-bool FileWatcher::start (const FilesystemEntry&)
+bool FileWatcher::start (const FilesystemEntry& newPathToWatch)
 {
-	return false;
+	if (newPathToWatch == watchedPath)
+		return start();
+
+	stop();
+
+	if (! newPathToWatch.exists())
+		return false;
+
+	watchedPath = newPathToWatch;
+
+	startBackend();
+
+	return isRunning();
+}
+
+bool FileWatcher::start (const FilesystemEntry& newPathToWatch, const Options& newOptions)
+{
+	stop();
+
+	options = newOptions;
+
+	return start (newPathToWatch);
+}
+
+void FileWatcher::startBackend()
+{
+	poller = std::make_unique<Poller> (*this, watchedPath, options);
+}
+
+FileWatcher::Backend FileWatcher::getBackend() const noexcept
+{
+	return Backend::Polling;
 }
 
 void FileWatcher::stop()
 {
+	poller.reset();
 }
 
 bool FileWatcher::isRunning()
 {
-	return false;
+	return poller.get() != nullptr;
 }
 
 bool FileWatcher::supportedBySystem() noexcept
@@ -59,4 +122,9 @@ FilesystemEntry FileWatcher::getWatchedPath() const noexcept
 	return watchedPath;
 }
 
+FileWatcher::Options FileWatcher::getOptions() const noexcept
+{
+	return options;
+}
+
 }  // namespace files
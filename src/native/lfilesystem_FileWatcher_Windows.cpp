@@ -25,6 +25,8 @@
 #include "lfilesystem/lfilesystem_Export.h"
 #include "lfilesystem/lfilesystem_FileWatcher.h"
 #include "lfilesystem/lfilesystem_FilesystemEntry.h"
+#include "../lfilesystem_EventDispatcher.h"
+#include "../lfilesystem_Poller.h"
 
 namespace limes::files
 {
@@ -32,8 +34,8 @@ namespace limes::files
 class LFILE_NO_EXPORT FileWatcher::Impl final
 {
 public:
-	Impl (FileWatcher& parent, const FilesystemEntry& fileToWatch)
-		: watcher (parent), watchedPath (fileToWatch.getAbsolutePath())
+	Impl (FileWatcher& parent, const FilesystemEntry& fileToWatch, const Options& options)
+		: dispatcher (parent, options), watchedPath (fileToWatch.getAbsolutePath()), recursive (options.recursive)
 	{
 		WCHAR path[_MAX_PATH] = { 0 };
 		wcsncpy (path, fileToWatch.getAbsolutePath().wstring().data(), _MAX_PATH - 1);
@@ -65,13 +67,20 @@ class LFILE_NO_EXPORT FileWatcher::Impl final
 
 		DWORD bytesOut = 0;
 
-		const auto success = ReadDirectoryChangesW (fileHandle, buffer, heapSize, true,
+		const auto success = ReadDirectoryChangesW (fileHandle, buffer, heapSize, recursive,
 													FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_ATTRIBUTES | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_LAST_ACCESS | FILE_NOTIFY_CHANGE_CREATION | FILE_NOTIFY_CHANGE_SECURITY,
 													&bytesOut, nullptr, nullptr);
 
-		if (! (success && bytesOut > 0))
+		if (! success)
 			return;
 
+		// the buffer was too small to hold all the changes, so they have been discarded
+		if (bytesOut == 0)
+		{
+			dispatcher.notifyEventsLost();
+			return;
+		}
+
 		for (auto* rawData = buffer; rawData != &buffer[heapSize - 1];)
 		{
 			const auto* fni = reinterpret_cast<FILE_NOTIFY_INFORMATION*> (rawData);
@@ -88,40 +97,40 @@ class LFILE_NO_EXPORT FileWatcher::Impl final
 		}
 	}
 
-	void handleEvent (DWORD type, const Path& path) const
+	void handleEvent (DWORD type, const Path& path)
 	{
-		FilesystemEntry file { path };
-
-		file.makeAbsoluteRelativeTo (watchedPath);
+		const auto file = watchedPath / path;
 
 		switch (type)
 		{
 			case (FILE_ACTION_ADDED) :
 			{
-				watcher.fileCreated (file);
+				dispatcher.dispatch (Created, file);
 				return;
 			}
 			case (FILE_ACTION_MODIFIED) :
 			{
-				watcher.fileModified (file);
+				dispatcher.dispatch (Modified, file);
 				return;
 			}
 			case (FILE_ACTION_RENAMED_OLD_NAME) :
 				[[fallthrough]];
 			case (FILE_ACTION_RENAMED_NEW_NAME) :
 			{
-				watcher.fileMoved (file);
+				dispatcher.dispatch (Moved, file);
 				return;
 			}
 			case (FILE_ACTION_REMOVED) :
-				watcher.fileDeleted (file);
+				dispatcher.dispatch (Deleted, file);
 		}
 	}
 
-	FileWatcher& watcher;
+	EventDispatcher dispatcher;
 
 	Path watchedPath;
 
+	const BOOL recursive;
+
 	HANDLE fileHandle;
 
 	static constexpr auto heapSize		   = 16 * 1024;
@@ -192,11 +201,16 @@ class LFILE_NO_EXPORT FileWatcher::Impl final
 /*---------------------------------------------------------------------------------------------------------------------*/
 
 FileWatcher::FileWatcher (const FilesystemEntry& fileToWatch)
-	: watchedPath (fileToWatch)
+	: FileWatcher (fileToWatch, Options {})
+{
+}
+
+FileWatcher::FileWatcher (const FilesystemEntry& fileToWatch, const Options& optionsToUse)
+	: watchedPath (fileToWatch), options (optionsToUse)
 {
 	if (fileToWatch.exists())
 	{
-		pimpl.reset (new Impl { *this, watchedPath });
+		startBackend();
 	}
 	else
 	{
@@ -221,7 +235,7 @@ bool FileWatcher::start()
 	if (! watchedPath.exists())
 		return false;
 
-	pimpl.reset (new Impl { *this, watchedPath });
+	startBackend();
 
 	return isRunning();
 }
@@ -238,19 +252,49 @@ bool FileWatcher::start (const FilesystemEntry& newPathToWatch)
 
 	watchedPath = newPathToWatch;
 
-	pimpl.reset (new Impl { *this, watchedPath });
+	startBackend();
 
 	return isRunning();
 }
 
+bool FileWatcher::start (const FilesystemEntry& newPathToWatch, const Options& newOptions)
+{
+	stop();
+
+	options = newOptions;
+
+	return start (newPathToWatch);
+}
+
+void FileWatcher::startBackend()
+{
+	if (options.backend == Backend::Polling)
+		poller = std::make_unique<Poller> (*this, watchedPath, options);
+	else
+		pimpl.reset (new Impl { *this, watchedPath, options });
+}
+
+FileWatcher::Backend FileWatcher::getBackend() const noexcept
+{
+	if (poller != nullptr)
+		return Backend::Polling;
+
+	// there is no volume-wide backend on this system
+	if (pimpl != nullptr)
+		return Backend::Native;
+
+	return options.backend;
+}
+
 void FileWatcher::stop()
 {
 	pimpl.reset();
+	poller.reset();
 }
 
 bool FileWatcher::isRunning()
 {
-	return pimpl.get() != nullptr;
+	return pimpl.get() != nullptr || poller.get() != nullptr;
 }
 
 bool FileWatcher::supportedBySystem() noexcept
@@ -263,4 +307,9 @@ FilesystemEntry FileWatcher::getWatchedPath() const noexcept
 	return watchedPath;
 }
 
+FileWatcher::Options FileWatcher::getOptions() const noexcept
+{
+	return options;
+}
+
 }  // namespace files
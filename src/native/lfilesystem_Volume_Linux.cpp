@@ -16,6 +16,9 @@
 #include <sys/statfs.h>
 #include <sys/statvfs.h>
 #include <mntent.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #if __has_include(<linux/limits.h>)
 #	include <linux/limits.h>
@@ -34,11 +37,14 @@
 #include <stdexcept>
 #include <cstdio>
 #include <vector>
-#include <cctype>
-#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
 #include "lfilesystem/lfilesystem_Directory.h"
 #include "lfilesystem/lfilesystem_File.h"
 #include "lfilesystem/lfilesystem_Volume.h"
+#include "../lfilesystem_Scanner.h"
 
 #ifndef LFILE_IMPL_USE_PATHCONF
 #	define LFILE_IMPL_USE_PATHCONF 0
@@ -63,36 +69,138 @@ namespace limes::files
 	throw std::runtime_error { stream.str() };
 }
 
-static inline Path findMountPath (const Path& inputPath)
+/* The mount table is cached for the whole process, indexed by device ID.
+
+	The kernel reports POLLPRI on an open /proc/self/mounts whenever the mount table changes (and polling
+	acknowledges the change), so the table is only read again after something has been mounted or unmounted.
+	Devices that aren't found are cached the same way.
+ */
+class MountTable final
 {
-	struct stat s;
+public:
+	[[nodiscard]] static MountTable& getInstance()
+	{
+		static MountTable table;
+		return table;
+	}
 
-	if (stat (inputPath.c_str(), &s) != 0)
-		throwError (inputPath);
+	[[nodiscard]] std::optional<Path> findMountPath (dev_t device)
+	{
+		const std::lock_guard lock { mutex };
+
+		auto justReloaded = false;
+
+		if (! loaded || hasChanged())
+		{
+			reload();
+			justReloaded = true;
+		}
+
+		if (const auto it = mounts.find (device); it != mounts.end())
+			return it->second;
+
+		// devices that have no mount point, such as btrfs subvolumes, are remembered until the table
+		// changes, so that looking them up again doesn't read the table and stat every mount point
+		if (unknownDevices.contains (device))
+			return std::nullopt;
+
+		// a mount can race with the change notification, so give it one more try
+		if (! justReloaded)
+		{
+			reload();
+
+			if (const auto it = mounts.find (device); it != mounts.end())
+				return it->second;
+		}
+
+		unknownDevices.insert (device);
 
-	if (auto* fp = setmntent ("/proc/mounts", "r"))	 // should this be etc/mtab ??
+		return std::nullopt;
+	}
+
+	MountTable (const MountTable&)			  = delete;
+	MountTable& operator= (const MountTable&) = delete;
+
+private:
+	MountTable()
+		: pollFd (::open ("/proc/self/mounts", O_RDONLY | O_CLOEXEC))
+	{
+	}
+
+	~MountTable()
 	{
+		if (pollFd >= 0)
+			::close (pollFd);
+	}
+
+	[[nodiscard]] bool hasChanged() const noexcept
+	{
+		// without change notifications, the table must be read every time
+		if (pollFd < 0)
+			return true;
+
+		struct pollfd pfd
+		{
+			pollFd, POLLPRI, 0
+		};
+
+		if (poll (&pfd, 1, 0) < 0)
+			return true;
+
+		return (pfd.revents & (POLLPRI | POLLERR)) != 0;
+	}
+
+	void reload()
+	{
+		mounts.clear();
+		unknownDevices.clear();
+
+		loaded = true;
+
+		auto* fp = setmntent ("/proc/self/mounts", "r");
+
+		if (fp == nullptr)
+			return;
+
 		struct mntent mnt;
 
 		char buf[PATH_MAX] = {};
 
-		const auto dev = s.st_dev;
-
 		while (getmntent_r (fp, &mnt, buf, PATH_MAX) != nullptr)
 		{
+			struct stat s;
+
 			if (stat (mnt.mnt_dir, &s) != 0)
 				continue;
 
-			if (s.st_dev == dev)
-			{
-				endmntent (fp);
-				return Path { mnt.mnt_dir };
-			}
+			// several mount points can share a device; the first one listed wins
+			mounts.try_emplace (s.st_dev, mnt.mnt_dir);
 		}
 
 		endmntent (fp);
 	}
 
+	std::mutex mutex;
+
+	std::unordered_map<dev_t, Path> mounts;
+
+	std::unordered_set<dev_t> unknownDevices;
+
+	int pollFd { -1 };
+
+	bool loaded { false };
+};
+
+static inline Path findMountPath (const Path& inputPath)
+{
+	struct stat s;
+
+	if (stat (inputPath.c_str(), &s) != 0)
+		throwError (inputPath);
+
+	if (auto mountPath = MountTable::getInstance().findMountPath (s.st_dev))
+		return *mountPath;
+
 	throwError (inputPath);
 }
 
@@ -201,58 +309,6 @@ bool Volume::isCaseSensitive() const
 #endif
 }
 
-static inline void trimString (std::string& string)
-{
-	if (string.empty())
-		return;
-
-	// trim start
-	string.erase (string.begin(), std::find_if (string.begin(), string.end(), [] (unsigned char ch)
-												{ return ! std::isspace (ch); }));
-
-	// trim end
-	string.erase (std::find_if (string.rbegin(), string.rend(), [] (unsigned char ch)
-								{ return ! std::isspace (ch); })
-					  .base(),
-				  string.end());
-}
-
-static inline std::vector<std::string> splitAtWhitespace (std::string_view stringToSplit)
-{
-	std::vector<std::string> tokens;
-
-	auto tokenStart = stringToSplit.begin();
-	auto pos		= tokenStart;
-
-	while (pos != stringToSplit.end())
-	{
-		if (std::isspace (*pos))
-		{
-			auto delimiterStart = pos++;
-
-			while (pos != stringToSplit.end() && std::isspace (*pos))
-				++pos;
-
-			if (pos != stringToSplit.begin())
-				tokens.push_back ({ tokenStart, delimiterStart });
-
-			tokenStart = pos;
-		}
-		else
-		{
-			++pos;
-		}
-	}
-
-	if (pos != stringToSplit.begin())
-		tokens.push_back ({ tokenStart, pos });
-
-	for (auto& token : tokens)
-		trimString (token);
-
-	return tokens;
-}
-
 std::vector<Volume> Volume::getAll() noexcept
 {
 	// reads /etc/mtab to find all listed mount points
@@ -268,7 +324,7 @@ std::vector<Volume> Volume::getAll() noexcept
 
 		for (const auto& line : mtab.loadAsLines())
 		{
-			for (const auto& entry : splitAtWhitespace (line))
+			for (const auto& entry : scanner::split (line, scanner::whitespace))
 			{
 				if (entry.starts_with ("/"))
 				{
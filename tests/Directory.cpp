@@ -16,8 +16,15 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
 #include <catch2/catch_test_macros.hpp>
 
+#if ! (defined(_WIN32) || defined(WIN32))
+#	include <sys/stat.h>
+#endif
+
 #define TAGS "[core][files][directory]"
 
 namespace files = limes::files;
@@ -176,10 +183,303 @@ TEST_CASE ("Directory", TAGS)
 
 	REQUIRE (! dir.contains ("cuwnncncffeohglgreg"));
 
+	// only immediate children are matched by name
+	REQUIRE (! dir.contains (""));
+	REQUIRE (! dir.contains ("."));
+	REQUIRE (! dir.contains (".."));
+	REQUIRE (! dir.contains ("sub1/.."));
+	REQUIRE (! dir.contains ("sub1/../file1.txt"));
+
 	REQUIRE (dir.deleteIfExists());
 
 	REQUIRE (dir.isEmpty());
 	REQUIRE (! dir.containsSubdirectories());
 }
 
+TEST_CASE ("Directory - listing order", TAGS)
+{
+	const auto dir = files::dirs::cwd().getChildDirectory ("listing_test");
+
+	dir.deleteIfExists();
+	REQUIRE (dir.createIfDoesntExist());
+
+	REQUIRE (dir.getChildDirectory ("b_dir").createIfDoesntExist());
+	REQUIRE (dir.getChildDirectory ("a_dir").createIfDoesntExist());
+	REQUIRE (dir.getChildFile ("d_file").createIfDoesntExist());
+	REQUIRE (dir.getChildFile ("c_file").createIfDoesntExist());
+	REQUIRE (dir.createChildSymLink ("e_link", dir.getChildFile ("c_file")).exists());
+
+	// files (and symlinks to files) come before directories, then entries are sorted by path
+	{
+		std::vector<std::string> names;
+
+		for (const auto& entry : dir.getAllChildren())
+			names.emplace_back (entry.getName());
+
+		REQUIRE (names == std::vector<std::string> { "c_file", "d_file", "e_link", "a_dir", "b_dir" });
+	}
+
+	{
+		std::vector<std::string> fileNames, dirNames, linkNames;
+
+		dir.iterateAllChildren ([&fileNames] (const files::File& f)
+								{ fileNames.emplace_back (f.getName()); },
+								[&dirNames] (const files::Directory& d)
+								{ dirNames.emplace_back (d.getName()); },
+								[&linkNames] (const files::SymLink& l)
+								{ linkNames.emplace_back (l.getName()); });
+
+		// the iterate functions stream the directory, so the order isn't specified
+		std::sort (fileNames.begin(), fileNames.end());
+		std::sort (dirNames.begin(), dirNames.end());
+
+		REQUIRE (fileNames == std::vector<std::string> { "c_file", "d_file" });
+		REQUIRE (dirNames == std::vector<std::string> { "a_dir", "b_dir" });
+		REQUIRE (linkNames == std::vector<std::string> { "e_link" });
+	}
+
+	{
+		// a stream can be exited early, and each call to begin() restarts the walk
+		const auto stream = dir.stream (false);
+
+		REQUIRE (std::ranges::distance (stream) == 5);
+
+		const auto it = std::ranges::find_if (stream, [] (const files::FilesystemEntry& e)
+											  { return e.getName() == "b_dir"; });
+
+		REQUIRE (it != stream.end());
+		REQUIRE (it->isDirectory());
+	}
+
+	REQUIRE (dir.getChildDirectory ("a_dir").getChildFile ("nested").createIfDoesntExist());
+	REQUIRE (dir.getChildFile (".hidden").createIfDoesntExist());
+
+	REQUIRE (std::ranges::distance (dir.stream (false)) == 6);
+	REQUIRE (std::ranges::distance (dir.stream (true)) == 7);
+	REQUIRE (std::ranges::distance (dir.stream (true, false)) == 6);
+
+	REQUIRE (dir.deleteIfExists());
+
+	REQUIRE (dir.stream().begin() == dir.stream().end());
+}
+
+TEST_CASE ("Directory - parallel walk", TAGS)
+{
+	const auto dir = files::dirs::cwd().getChildDirectory ("parallel_walk_test");
+
+	dir.deleteIfExists();
+	REQUIRE (dir.createIfDoesntExist());
+
+	// a few levels of nesting, and more entries than are walked on the calling thread, so the walk has to fan out
+	for (auto i = 0; i < 8; ++i)
+	{
+		const auto subdir = dir.getChildDirectory ("dir" + std::to_string (i));
+
+		for (auto j = 0; j < 4; ++j)
+		{
+			const auto nested = subdir.getChildDirectory ("nested" + std::to_string (j));
+
+			REQUIRE (nested.createIfDoesntExist());
+
+			for (auto k = 0; k < 40; ++k)
+				REQUIRE (nested.getChildFile ("file" + std::to_string (k)).createIfDoesntExist());
+		}
+	}
+
+	REQUIRE (dir.getChildFile (".hidden").createIfDoesntExist());
+
+	std::vector<files::Path> expected;
+
+	for (const auto& entry : dir.stream (true, false))
+		expected.push_back (entry.getAbsolutePath());
+
+	std::sort (expected.begin(), expected.end());
+
+	for (const auto numThreads : { 1UL, 4UL, 0UL })
+	{
+		std::mutex				 mutex;
+		std::vector<files::Path> found;
+
+		dir.iterateAllChildrenInParallel ([&mutex, &found] (const files::FilesystemEntry& entry)
+										  {
+			const std::lock_guard lock { mutex };
+			found.push_back (entry.getAbsolutePath()); },
+										  false, numThreads);
+
+		std::sort (found.begin(), found.end());
+
+		REQUIRE (found == expected);
+	}
+
+	REQUIRE_THROWS_AS (dir.iterateAllChildrenInParallel ([] (const files::FilesystemEntry&)
+														 { throw std::runtime_error { "stop" }; }),
+					   std::runtime_error);
+
+	REQUIRE (dir.deleteIfExists());
+}
+
+TEST_CASE ("Directory - disk usage", TAGS)
+{
+	const auto dir = files::dirs::cwd().getChildDirectory ("disk_usage_test");
+
+	dir.deleteIfExists();
+	REQUIRE (dir.createIfDoesntExist());
+
+	REQUIRE (dir.getDiskUsage().numFiles == 0);
+	REQUIRE (dir.sizeInBytes() == 0);
+
+#if ! (defined(_WIN32) || defined(WIN32))
+	{
+		// like du, the space used by the directory itself is counted
+		struct stat rootInfo;
+
+		REQUIRE (::stat (dir.getAbsolutePath().c_str(), &rootInfo) == 0);
+
+		REQUIRE (dir.getDiskUsage().allocatedBytes == static_cast<std::uintmax_t> (rootInfo.st_blocks) * 512);
+	}
+#endif
+
+	static constexpr std::uintmax_t fileSize = 1000;
+
+	const auto nested = dir.getChildDirectory ("a").getChildDirectory ("b");
+
+	REQUIRE (nested.createIfDoesntExist());
+
+	const auto file1 = dir.getChildFile ("file1");
+	const auto file2 = nested.getChildFile ("file2");
+
+	for (const auto& file : { file1, file2 })
+	{
+		REQUIRE (file.createIfDoesntExist());
+		REQUIRE (file.resize (fileSize));
+	}
+
+	// each file is only counted once, no matter how deeply it is nested
+	REQUIRE (dir.sizeInBytes() == fileSize * 2);
+
+	{
+		const auto usage = dir.getDiskUsage (true, 2);
+
+		REQUIRE (usage.apparentBytes == fileSize * 2);
+		REQUIRE (usage.numFiles == 2);
+		REQUIRE (usage.numDirectories == 2);
+	}
+
+#if ! (defined(_WIN32) || defined(WIN32))
+	// a second hard link to the same file isn't counted again
+	std::filesystem::create_hard_link (file2.getAbsolutePath(), dir.getChildFile ("hardlink").getAbsolutePath());
+
+	REQUIRE (dir.getDiskUsage().apparentBytes == fileSize * 2);
+#endif
+
+	REQUIRE (dir.deleteIfExists());
+
+	REQUIRE (dir.sizeInBytes() == 0);
+}
+
+TEST_CASE ("Directory - tree copy", TAGS)
+{
+	namespace files = limes::files;
+
+	const auto source = files::dirs::cwd().getChildDirectory ("tree_copy_source");
+	const auto dest	  = files::dirs::cwd().getChildDirectory ("tree_copy_dest");
+
+	source.deleteIfExists();
+	dest.deleteIfExists();
+
+	const auto nested = source.getChildDirectory ("a").getChildDirectory ("b");
+
+	REQUIRE (nested.createIfDoesntExist());
+	REQUIRE (source.getChildDirectory ("empty").createIfDoesntExist());
+
+	static constexpr auto numFiles = 200;
+
+	for (auto i = 0; i < numFiles; ++i)
+	{
+		const auto& parent = i % 2 == 0 ? source : nested;
+
+		REQUIRE (parent.getChildFile ("file" + std::to_string (i)).overwrite (std::string (static_cast<std::size_t> (i + 1), 'x')));
+	}
+
+#if ! (defined(_WIN32) || defined(WIN32))
+	std::filesystem::create_symlink ("a/b/file1", source.getChildFile ("link").getAbsolutePath());
+#endif
+
+	std::mutex						   mutex;
+	files::Directory::CopyProgress lastProgress;
+	bool							   foundAfterScan { false };
+
+	const auto callback = [&] (const files::Directory::CopyProgress& progress)
+	{
+		const std::lock_guard lock { mutex };
+
+		// once the scan is complete, the totals found must not change
+		if (lastProgress.scanComplete
+			&& (progress.numFilesFound != lastProgress.numFilesFound || progress.bytesFound != lastProgress.bytesFound))
+			foundAfterScan = true;
+
+		lastProgress = progress;
+	};
+
+	const auto result = source.copyTree (dest.getAbsolutePath(), files::Directory::CopyOptions::update_existing, callback, 4);
+
+	REQUIRE (result.numErrors == 0);
+	REQUIRE (result.scanComplete);
+	REQUIRE (result.numFilesSkipped == 0);
+	REQUIRE (result.numFilesCopied == result.numFilesFound);
+
+	REQUIRE (lastProgress.numFilesCopied == result.numFilesCopied);
+	REQUIRE (lastProgress.scanComplete);
+	REQUIRE (! foundAfterScan);
+	REQUIRE (result.bytesCopied == result.bytesFound);
+
+	for (auto i = 0; i < numFiles; ++i)
+	{
+		const auto relativePath = i % 2 == 0 ? "file" + std::to_string (i) : "a/b/file" + std::to_string (i);
+
+		const auto copy = dest.getChildFile (relativePath);
+
+		REQUIRE (copy.loadAsString() == std::string (static_cast<std::size_t> (i + 1), 'x'));
+		REQUIRE (copy.getLastModificationTime() == source.getChildFile (relativePath).getLastModificationTime());
+	}
+
+	REQUIRE (dest.getChildDirectory ("empty").exists());
+
+	// the modification times of the directories are applied after their contents are copied
+	REQUIRE (std::filesystem::last_write_time (dest.getChildDirectory ("a").getAbsolutePath())
+			 == std::filesystem::last_write_time (source.getChildDirectory ("a").getAbsolutePath()));
+
+#if ! (defined(_WIN32) || defined(WIN32))
+	REQUIRE (std::filesystem::read_symlink (dest.getChildFile ("link").getAbsolutePath()) == "a/b/file1");
+#endif
+
+	// nothing has changed, so nothing is copied again
+	{
+		const auto repeat = source.copyTree (dest.getAbsolutePath());
+
+		REQUIRE (repeat.numErrors == 0);
+		REQUIRE (repeat.numFilesCopied == 0);
+		REQUIRE (repeat.numFilesSkipped == result.numFilesFound);
+	}
+
+	REQUIRE (source.getChildFile ("file0").overwrite ("changed"));
+
+	{
+		const auto update = source.copyTree (dest.getAbsolutePath());
+
+		REQUIRE (update.numErrors == 0);
+		REQUIRE (update.numFilesCopied == 1);
+		REQUIRE (dest.getChildFile ("file0").loadAsString() == "changed");
+	}
+
+	// existing files are errors without one of the existing-file options
+	REQUIRE (source.copyTree (dest.getAbsolutePath(), files::Directory::CopyOptions::none).numErrors > 0);
+
+	// a tree can't be copied into itself
+	REQUIRE (source.copyTree (source.getChildDirectory ("inside").getAbsolutePath()).numErrors > 0);
+
+	REQUIRE (source.deleteIfExists());
+	REQUIRE (dest.deleteIfExists());
+}
+
 #undef TAGS
@@ -13,7 +13,10 @@
  */
 
 #include <lfilesystem/lfilesystem.h>
+#include <filesystem>
 #include <string>
+#include <vector>
+#include <iterator>
 #include <catch2/catch_test_macros.hpp>
 
 #define TAGS "[core][files][file]"
@@ -218,4 +221,234 @@ the code I'm testing.
 	}
 }
 
+TEST_CASE ("File - load as string", TAGS)
+{
+	const auto file = limes::files::dirs::cwd().getChildFile ("load_as_string_test.txt");
+
+	// larger than one read chunk
+	std::string content;
+
+	for (auto i = 0UL; i < 20000UL; ++i)
+		content += "line " + std::to_string (i) + "\n";
+
+	REQUIRE (file.overwrite (content));
+
+	REQUIRE (file.loadAsString() == content);
+
+	file.deleteIfExists();
+
+	REQUIRE (file.loadAsString().empty());
+}
+
+TEST_CASE ("File - load as lines", TAGS)
+{
+	const auto file = limes::files::dirs::cwd().getChildFile ("load_as_lines_test.txt");
+
+	// line lengths chosen so that newlines fall on either side of the scanner's 16- and 32-byte chunks
+	std::vector<std::string> expected;
+	std::string				 content;
+
+	for (auto length = 1UL; length < 70UL; ++length)
+	{
+		expected.emplace_back (length, static_cast<char> ('a' + length % 26));
+
+		content += expected.back();
+		content += length % 3 == 0 ? "\r\n" : "\n";
+	}
+
+	// a file ending with a newline produces a trailing empty line
+	expected.emplace_back();
+
+	REQUIRE (file.overwrite (content));
+
+	REQUIRE (file.loadAsLines() == expected);
+
+	file.deleteIfExists();
+
+	REQUIRE (file.loadAsLines().empty());
+}
+
+TEST_CASE ("File - line iterator", TAGS)
+{
+	const auto file = limes::files::dirs::cwd().getChildFile ("line_iterator_test.txt");
+
+	// longer than the iterator's internal buffer
+	const std::string longLine (100000, 'a');
+
+	std::string content { "first\r\n\nthird\n" };
+	content += longLine;
+	content += "\nlast";
+
+	REQUIRE (file.overwrite (content));
+
+	const std::vector<std::string> expected { "first", "", "third", longLine, "last" };
+
+	std::vector<std::string> lines;
+
+	for (const auto line : file)
+		lines.emplace_back (line);
+
+	REQUIRE (lines == expected);
+
+	// a trailing newline doesn't produce an extra empty line
+	REQUIRE (file.append ("\n"));
+
+	REQUIRE (std::ranges::distance (file.begin(), file.end()) == static_cast<std::ptrdiff_t> (expected.size()));
+
+	file.deleteIfExists();
+
+	REQUIRE (file.begin() == file.end());
+}
+
+TEST_CASE ("File - copying", TAGS)
+{
+	using Strategy = files::File::CopyStrategy;
+
+	const auto dir = files::dirs::cwd().getChildDirectory ("file_copy_test");
+
+	dir.deleteIfExists();
+
+	REQUIRE (dir.createIfDoesntExist());
+
+	const auto source = dir.getChildFile ("source.txt");
+
+	const std::string content (300000, 'x');
+
+	REQUIRE (source.overwrite (content));
+
+	const auto dest = dir.getChildFile ("dest.txt");
+
+	const auto strategy = source.copyContentsTo (dest.getAbsolutePath());
+
+	REQUIRE (strategy.has_value());
+	REQUIRE (*strategy != Strategy::Skipped);
+
+	REQUIRE (dest.loadAsString() == content);
+
+	// the destination is newer than the source
+	REQUIRE (source.copyContentsTo (dest.getAbsolutePath()) == Strategy::Skipped);
+
+	// an existing destination is an error without one of the existing-file options
+	REQUIRE (! source.copyContentsTo (dest.getAbsolutePath(), files::File::CopyOptions::none).has_value());
+
+	// copying to a directory creates a file with the same name inside it
+	const auto subdir = dir.getChildDirectory ("subdir");
+
+	REQUIRE (subdir.createIfDoesntExist());
+
+	REQUIRE (source.copyTo (subdir));
+
+	REQUIRE (subdir.getChildFile ("source.txt").loadAsString() == content);
+
+	const auto duplicate = source.duplicate();
+
+	REQUIRE (duplicate.has_value());
+	REQUIRE (duplicate->getAbsolutePath() == dir.getChildFile ("source_copy.txt").getAbsolutePath());
+	REQUIRE (duplicate->loadAsString() == content);
+
+#ifdef __linux__
+	SECTION ("Sparse files")
+	{
+		constexpr auto holeSize = 16 * 1024 * 1024;
+
+		const auto sparse = dir.getChildFile ("sparse.bin");
+
+		REQUIRE (sparse.overwrite ("start"));
+		REQUIRE (sparse.resize (holeSize, false, true));
+		REQUIRE (sparse.append ("end"));
+		REQUIRE (sparse.resize (holeSize * 2, false, true));
+
+		const auto sparseCopy = dir.getChildFile ("sparse_copy.bin");
+
+		REQUIRE (sparse.copyContentsTo (sparseCopy.getAbsolutePath()).has_value());
+
+		REQUIRE (sparseCopy.sizeInBytes() == sparse.sizeInBytes());
+		REQUIRE (sparseCopy.loadAsString() == sparse.loadAsString());
+
+		const auto info = sparseCopy.getInfo (files::FileInfo::Size | files::FileInfo::Blocks);
+
+		REQUIRE (info.has_value());
+
+		// the holes weren't filled in
+		REQUIRE (info->getAllocatedBytes() < info->sizeInBytes() / 2);
+	}
+#endif
+
+	REQUIRE (dir.deleteIfExists());
+}
+
+TEST_CASE ("File - atomic overwrite", TAGS)
+{
+	using Durability = files::File::Durability;
+
+	const auto dir = files::dirs::cwd().getChildDirectory ("file_atomic_overwrite_test");
+
+	dir.deleteIfExists();
+
+	REQUIRE (dir.createIfDoesntExist());
+
+	const auto file = dir.getChildFile ("file.txt");
+
+	REQUIRE (file.overwriteAtomically ("initial"));
+	REQUIRE (file.loadAsString() == "initial");
+
+	for (const auto durability : { Durability::None, Durability::Data, Durability::Full })
+	{
+		const auto content = "content " + std::to_string (static_cast<int> (durability));
+
+		REQUIRE (file.overwriteAtomically (content, durability));
+		REQUIRE (file.loadAsString() == content);
+	}
+
+	SECTION ("Large content")
+	{
+		const std::string content (5000000, 'y');
+
+		REQUIRE (file.overwriteAtomically (content.data(), content.size()));
+		REQUIRE (file.sizeInBytes() == content.size());
+		REQUIRE (file.loadAsString() == content);
+	}
+
+	SECTION ("Empty content")
+	{
+		REQUIRE (file.overwriteAtomically (std::string_view {}));
+		REQUIRE (file.exists());
+		REQUIRE (file.sizeInBytes() == 0);
+	}
+
+#ifndef _WIN32
+	SECTION ("Permissions are preserved")
+	{
+		constexpr auto perms = files::FSPerms::owner_read | files::FSPerms::owner_write | files::FSPerms::group_read;
+
+		REQUIRE (file.setPermissions (perms));
+
+		REQUIRE (file.overwriteAtomically ("new content"));
+
+		REQUIRE (file.getPermissions() == perms);
+		REQUIRE (file.loadAsString() == "new content");
+	}
+
+	SECTION ("Symbolic links are preserved")
+	{
+		const auto link = dir.createChildSymLink ("link.txt", file);
+
+		REQUIRE (files::File { link.getAbsolutePath() }.overwriteAtomically ("through the link"));
+
+		REQUIRE (link.isSymLink());
+		REQUIRE (file.loadAsString() == "through the link");
+	}
+#endif
+
+	// no temporary files were left behind
+	for (const auto& entry : std::filesystem::directory_iterator { dir.getAbsolutePath() })
+	{
+		const auto name = entry.path().filename().string();
+
+		REQUIRE ((name == "file.txt" || name == "link.txt"));
+	}
+
+	REQUIRE (dir.deleteIfExists());
+}
+
 #undef TAGS
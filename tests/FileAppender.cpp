@@ -0,0 +1,235 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#include <lfilesystem/lfilesystem.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#define TAGS "[core][files][appender]"
+
+namespace files = limes::files;
+using files::FileAppender;
+
+TEST_CASE ("FileAppender - null", TAGS)
+{
+	FileAppender a;
+
+	REQUIRE (! a.isOpen());
+	REQUIRE (a.getPath().empty());
+	REQUIRE (! a.append ("data"));
+	REQUIRE (! a.flush());
+	REQUIRE (a.close());
+
+	REQUIRE (! a.open (files::dirs::cwd().getChildDirectory ("cuwnncncffeohglgreg").getChildFile ("file.txt").getAbsolutePath()));
+	REQUIRE (! a.isOpen());
+}
+
+TEST_CASE ("FileAppender", TAGS)
+{
+	const auto file = files::dirs::cwd().getChildFile ("appender_test.txt");
+
+	REQUIRE (file.overwrite ("start\n"));
+
+	FileAppender::Options options;
+
+	options.bufferSize = 64;
+
+	FileAppender a { file.getAbsolutePath(), options };
+
+	REQUIRE (a.isOpen());
+	REQUIRE (a.getPath() == file.getAbsolutePath());
+
+	REQUIRE (a.append ("one\n"));
+	REQUIRE (a.append (std::string_view { "two\n" }));
+
+	// the data is buffered until it's flushed
+	REQUIRE (file.loadAsString() == "start\n");
+
+	REQUIRE (a.flush());
+	REQUIRE (file.loadAsString() == "start\none\ntwo\n");
+
+	SECTION ("Full buffers are flushed")
+	{
+		const std::string record (40, 'x');
+
+		REQUIRE (a.append (record));
+		REQUIRE (a.append (record));
+
+		REQUIRE (file.loadAsString() == "start\none\ntwo\n" + record);
+	}
+
+	SECTION ("Large data is written directly")
+	{
+		REQUIRE (a.append ("three\n"));
+
+		const std::string record (1000, 'y');
+
+		REQUIRE (a.append (record));
+
+		REQUIRE (file.loadAsString() == "start\none\ntwo\nthree\n" + record);
+	}
+
+	SECTION ("Moving and closing flushes")
+	{
+		REQUIRE (a.append ("three\n"));
+
+		auto moved = std::move (a);
+
+		REQUIRE (! a.isOpen());	 // NOLINT
+		REQUIRE (moved.isOpen());
+
+		REQUIRE (moved.close());
+		REQUIRE (! moved.isOpen());
+
+		REQUIRE (file.loadAsString() == "start\none\ntwo\nthree\n");
+	}
+
+	REQUIRE (a.close());
+	REQUIRE (file.deleteIfExists());
+}
+
+TEST_CASE ("FileAppender - flush interval", TAGS)
+{
+	const auto file = files::dirs::cwd().getChildFile ("appender_interval_test.txt");
+
+	file.deleteIfExists();
+
+	FileAppender::Options options;
+
+	options.flushInterval = std::chrono::milliseconds { 5 };
+
+	FileAppender a { file.getAbsolutePath(), options };
+
+	REQUIRE (a.isOpen());
+	REQUIRE (file.exists());
+
+	REQUIRE (a.append ("data"));
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds { 5 };
+
+	while (file.sizeInBytes() == 0 && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for (std::chrono::milliseconds { 1 });
+
+	REQUIRE (file.loadAsString() == "data");
+
+	REQUIRE (a.close());
+	REQUIRE (file.deleteIfExists());
+}
+
+TEST_CASE ("FileAppender - multiple threads", TAGS)
+{
+	constexpr auto numThreads = 8;
+	constexpr auto numRecords = 5000;
+
+	const auto file = files::dirs::cwd().getChildFile ("appender_threads_test.txt");
+
+	file.deleteIfExists();
+
+	FileAppender::Options options;
+
+	options.bufferSize = 4096;
+
+	{
+		FileAppender a { file.getAbsolutePath(), options };
+
+		REQUIRE (a.isOpen());
+
+		std::vector<std::thread> threads;
+
+		for (auto t = 0; t < numThreads; ++t)
+			threads.emplace_back ([&a, t]
+								  {
+				for (auto i = 0; i < numRecords; ++i)
+					a.append (std::to_string (t) + " " + std::to_string (i) + "\n"); });
+
+		for (auto& thread : threads)
+			thread.join();
+	}
+
+	// every record was written whole, and each thread's records are in order
+	std::vector<int> nextRecord (numThreads, 0);
+
+	for (const auto& line : file.loadAsLines())
+	{
+		if (line.empty())
+			continue;
+
+		const auto space = line.find (' ');
+
+		REQUIRE (space != std::string::npos);
+
+		const auto thread = std::stoi (line.substr (0, space));
+		const auto record = std::stoi (line.substr (space + 1));
+
+		REQUIRE (record == nextRecord[static_cast<std::size_t> (thread)]++);
+	}
+
+	for (const auto count : nextRecord)
+		REQUIRE (count == numRecords);
+
+	REQUIRE (file.deleteIfExists());
+}
+
+TEST_CASE ("FileAppender - thread exit", TAGS)
+{
+	const auto file	  = files::dirs::cwd().getChildFile ("appender_exit_test.txt");
+	const auto second = files::dirs::cwd().getChildFile ("appender_exit_test_2.txt");
+
+	file.deleteIfExists();
+	second.deleteIfExists();
+
+	FileAppender a { file.getAbsolutePath() };
+	FileAppender b { second.getAbsolutePath() };
+
+	REQUIRE (a.isOpen());
+	REQUIRE (b.isOpen());
+
+	// a thread's buffered data is written when the thread exits, without flushing
+	for (auto i = 0; i < 3; ++i)
+	{
+		std::thread thread { [&a, i]
+							 { a.append (std::to_string (i) + "\n"); } };
+
+		thread.join();
+	}
+
+	REQUIRE (file.loadAsString() == "0\n1\n2\n");
+
+	// one thread can use several appenders at once
+	std::thread thread { [&a, &b]
+						 {
+		for (auto i = 0; i < 100; ++i)
+		{
+			a.append ("a");
+			b.append ("b");
+		} } };
+
+	thread.join();
+
+	REQUIRE (file.loadAsString() == "0\n1\n2\n" + std::string (100, 'a'));
+	REQUIRE (second.loadAsString() == std::string (100, 'b'));
+
+	REQUIRE (a.close());
+	REQUIRE (b.close());
+
+	REQUIRE (file.deleteIfExists());
+	REQUIRE (second.deleteIfExists());
+}
+
+#undef TAGS
@@ -0,0 +1,94 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+#include <lfilesystem/lfilesystem.h>
+#include <filesystem>
+#include <catch2/catch_test_macros.hpp>
+
+#define TAGS "[core][files][info]"
+
+namespace files = limes::files;
+using files::FileInfo;
+
+TEST_CASE ("FileInfo - nonexistent", TAGS)
+{
+	REQUIRE (! files::FilesystemEntry {}.getInfo());
+	REQUIRE (! files::dirs::cwd().getChildFile ("cuwnncncffeohglgreg.txt").getInfo());
+	REQUIRE (! FileInfo::tryCreate (""));
+}
+
+TEST_CASE ("FileInfo", TAGS)
+{
+	const auto file = files::dirs::cwd().getChildFile ("file_info_test.txt");
+
+	static constexpr auto content = "Some text in a file";
+
+	REQUIRE (file.overwrite (content));
+
+	{
+		const auto info = file.getInfo();
+
+		REQUIRE (info.has_value());
+		REQUIRE (info->hasFields (FileInfo::Type | FileInfo::Mode | FileInfo::Size | FileInfo::ModificationTime));
+		REQUIRE (info->isFile());
+		REQUIRE (! info->isDirectory());
+		REQUIRE (info->sizeInBytes() == file.sizeInBytes());
+		REQUIRE (info->getPermissions() == file.getPermissions());
+		REQUIRE (info->getLastModificationTime() == file.getLastModificationTime());
+		REQUIRE (info->getHardLinkCount() == file.getHardLinkCount());
+
+		if (const auto creationTime = info->getCreationTime())
+			REQUIRE (*creationTime <= info->getLastModificationTime());
+	}
+
+	{
+		const auto info = file.getInfo (FileInfo::Size);
+
+		REQUIRE (info.has_value());
+		REQUIRE (info->hasFields (FileInfo::Size));
+		REQUIRE (info->sizeInBytes() == file.sizeInBytes());
+	}
+
+	{
+		const auto info = files::dirs::cwd().getInfo();
+
+		REQUIRE (info.has_value());
+		REQUIRE (info->isDirectory());
+	}
+
+	const auto link = files::dirs::cwd().createChildSymLink ("file_info_link", file);
+
+	REQUIRE (link.exists());
+
+	{
+		const auto followed = link.getInfo (FileInfo::All, true);
+		const auto notFollowed = link.getInfo (FileInfo::All, false);
+
+		REQUIRE (followed.has_value());
+		REQUIRE (notFollowed.has_value());
+
+		REQUIRE (followed->isFile());
+		REQUIRE (notFollowed->isSymLink());
+
+#if ! (defined(_WIN32) || defined(WIN32))
+		REQUIRE (followed->getInode() == file.getInfo()->getInode());
+		REQUIRE (notFollowed->getInode() != followed->getInode());
+#endif
+	}
+
+	link.deleteIfExists();
+	file.deleteIfExists();
+}
+
+#undef TAGS
@@ -15,6 +15,16 @@
 #include <lfilesystem/lfilesystem.h>
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
 #include <catch2/catch_test_macros.hpp>
 
 #ifdef __APPLE__
@@ -42,12 +52,23 @@ TEST_CASE ("FileWatcher", "[core][files][watcher]")
 
 	file.createIfDoesntExist();
 
+	// these systems have no native API, so the watcher polls instead
 	lf::FileWatcher watcher { file };
 
-	REQUIRE (! watcher.getWatchedPath().isValid());
+	REQUIRE (watcher.getWatchedPath() == file);
+
+	REQUIRE (watcher.isRunning());
+
+	REQUIRE (watcher.getBackend() == lf::FileWatcher::Backend::Polling);
+
+	watcher.stop();
 
 	REQUIRE (! watcher.isRunning());
 
+	REQUIRE (watcher.start());
+
+	REQUIRE (watcher.getBackend() == lf::FileWatcher::Backend::Polling);
+
 	file.deleteIfExists();
 
 #else
@@ -82,3 +103,685 @@ TEST_CASE ("FileWatcher", "[core][files][watcher]")
 
 #endif
 }
+
+#ifdef __linux__
+
+#	include <unistd.h>
+
+TEST_CASE ("FileWatcher - event delivery", "[core][files][watcher]")
+{
+	namespace lf = limes::files;
+
+	const auto dir = lf::dirs::cwd().getChildDirectory ("watcher_delivery_test");
+
+	dir.deleteIfExists();
+
+	REQUIRE (dir.createIfDoesntExist());
+
+	std::mutex				mutex;
+	std::condition_variable eventReceived;
+	int						numEvents { 0 };
+
+	lf::SimpleFileWatcher watcher { dir, [&] (const lf::FilesystemEntry&)
+									{
+										{
+											const std::lock_guard lock { mutex };
+											++numEvents;
+										}
+
+										eventReceived.notify_all();
+									} };
+
+	// an idle watcher must not delay the delivery of another watcher's events
+	const auto idleFile = lf::dirs::cwd().getChildFile ("watcher_idle_test.txt");
+
+	REQUIRE (idleFile.createIfDoesntExist());
+
+	lf::FileWatcher idleWatcher { idleFile };
+
+	REQUIRE (dir.getChildFile ("file.txt").overwrite ("some text"));
+
+	{
+		std::unique_lock lock { mutex };
+
+		REQUIRE (eventReceived.wait_for (lock, std::chrono::seconds (5), [&]
+										 { return numEvents > 0; }));
+	}
+
+	// after stop() returns, no more callbacks are made
+	watcher.stop();
+
+	const auto numEventsWhenStopped = numEvents;
+
+	REQUIRE (dir.getChildFile ("file.txt").overwrite ("some more text"));
+
+	std::this_thread::sleep_for (std::chrono::milliseconds (50));
+
+	REQUIRE (numEvents == numEventsWhenStopped);
+
+	idleWatcher.stop();
+
+	REQUIRE (idleFile.deleteIfExists());
+	REQUIRE (dir.deleteIfExists());
+}
+
+#endif
+
+#ifdef __linux__
+
+static std::size_t getResidentBytes()
+{
+	std::ifstream statm { "/proc/self/statm" };
+
+	std::size_t totalPages { 0 }, residentPages { 0 };
+
+	statm >> totalPages >> residentPages;
+
+	return residentPages * static_cast<std::size_t> (sysconf (_SC_PAGESIZE));
+}
+
+TEST_CASE ("FileWatcher - memory per watcher", "[core][files][watcher]")
+{
+	namespace lf = limes::files;
+
+	static constexpr auto numWatchers = 1000;
+
+	const auto dir = lf::dirs::cwd().getChildDirectory ("watcher_memory_test");
+
+	dir.deleteIfExists();
+
+	REQUIRE (dir.createIfDoesntExist());
+
+	std::vector<lf::File> files;
+
+	for (auto i = 0; i < numWatchers; ++i)
+	{
+		auto file = dir.getChildFile ("file_" + std::to_string (i) + ".txt");
+
+		REQUIRE (file.createIfDoesntExist());
+
+		files.emplace_back (std::move (file));
+	}
+
+	std::vector<std::unique_ptr<lf::FileWatcher>> watchers;
+
+	watchers.reserve (numWatchers);
+
+	// starts the background thread, so that its stack isn't counted
+	watchers.emplace_back (std::make_unique<lf::FileWatcher> (files.front()));
+
+	const auto residentBefore = getResidentBytes();
+
+	for (auto i = 1; i < numWatchers; ++i)
+		watchers.emplace_back (std::make_unique<lf::FileWatcher> (files[static_cast<std::size_t> (i)]));
+
+	const auto residentAfter = getResidentBytes();
+
+	const auto growthPerWatcher = residentAfter > residentBefore ? (residentAfter - residentBefore) / (numWatchers - 1) : 0;
+
+	// this includes the FileWatcher objects themselves, and the heap allocations for their paths
+	REQUIRE (growthPerWatcher < 4096);
+
+	REQUIRE (std::all_of (watchers.begin(), watchers.end(), [] (const auto& watcher)
+						  { return watcher->isRunning(); }));
+
+	watchers.clear();
+
+	REQUIRE (dir.deleteIfExists());
+}
+
+#endif
+
+#ifdef __linux__
+
+TEST_CASE ("FileWatcher - recursive", "[core][files][watcher]")
+{
+	namespace lf = limes::files;
+
+	const auto dir = lf::dirs::cwd().getChildDirectory ("watcher_recursive_test");
+
+	dir.deleteIfExists();
+
+	REQUIRE (dir.createIfDoesntExist());
+
+	const auto existing = dir.getChildDirectory ("existing");
+
+	REQUIRE (existing.createIfDoesntExist());
+
+	std::mutex				mutex;
+	std::condition_variable eventReceived;
+	std::set<lf::Path>		paths;
+
+	const auto waitForEvent = [&] (const lf::Path& path)
+	{
+		std::unique_lock lock { mutex };
+
+		return eventReceived.wait_for (lock, std::chrono::seconds (5), [&]
+									   { return paths.contains (path); });
+	};
+
+	lf::SimpleFileWatcher watcher { dir, lf::FileWatcher::Options { .recursive = true },
+									[&] (const lf::FilesystemEntry& entry)
+									{
+										{
+											const std::lock_guard lock { mutex };
+											paths.insert (entry.getAbsolutePath());
+										}
+
+										eventReceived.notify_all();
+									} };
+
+	REQUIRE (watcher.getOptions().recursive);
+
+	SECTION ("Directories that existed when the watcher was created")
+	{
+		const auto file = existing.getChildFile ("file.txt");
+
+		REQUIRE (file.overwrite ("some text"));
+
+		REQUIRE (waitForEvent (file.getAbsolutePath()));
+	}
+
+	SECTION ("Directories created after the watcher was created")
+	{
+		// the nested directory and file are created before the watcher has had a chance to add a watch for the new directory
+		const auto nested = dir.getChildDirectory ("new").getChildDirectory ("nested");
+
+		REQUIRE (nested.createIfDoesntExist());
+
+		const auto file = nested.getChildFile ("file.txt");
+
+		REQUIRE (file.overwrite ("some text"));
+
+		REQUIRE (waitForEvent (file.getAbsolutePath()));
+
+		// once the watch is in place, later changes are reported too
+		const auto laterFile = nested.getChildFile ("later.txt");
+
+		REQUIRE (laterFile.overwrite ("some more text"));
+
+		REQUIRE (waitForEvent (laterFile.getAbsolutePath()));
+	}
+
+	SECTION ("Directories moved within the tree")
+	{
+		auto moved = existing;
+
+		REQUIRE (moved.rename (dir.getAbsolutePath() / "moved"));
+
+		const auto file = moved.getChildFile ("file.txt");
+
+		REQUIRE (file.overwrite ("some text"));
+
+		REQUIRE (waitForEvent (file.getAbsolutePath()));
+	}
+
+	watcher.stop();
+
+	REQUIRE (dir.deleteIfExists());
+}
+
+#endif
+
+#ifdef __linux__
+
+TEST_CASE ("FileWatcher - coalescing", "[core][files][watcher]")
+{
+	namespace lf = limes::files;
+
+	struct BatchWatcher final : public lf::FileWatcher
+	{
+		explicit BatchWatcher (const lf::Directory& dir)
+		{
+			start (dir, Options { .coalescingWindow = std::chrono::milliseconds { 200 } });
+		}
+
+		~BatchWatcher() final
+		{
+			stop();
+		}
+
+		void changesDetected (const std::vector<Change>& changes) final
+		{
+			{
+				const std::lock_guard lock { mutex };
+				batches.push_back (changes);
+			}
+
+			batchReceived.notify_all();
+		}
+
+		std::mutex						 mutex;
+		std::condition_variable			 batchReceived;
+		std::vector<std::vector<Change>> batches;
+	};
+
+	const auto dir = lf::dirs::cwd().getChildDirectory ("watcher_coalescing_test");
+
+	dir.deleteIfExists();
+
+	REQUIRE (dir.createIfDoesntExist());
+
+	const auto file = dir.getChildFile ("file.txt");
+
+	BatchWatcher watcher { dir };
+
+	REQUIRE (watcher.getOptions().coalescingWindow.count() == 200);
+
+	// several opens, writes and closes of the same file
+	for (auto i = 0; i < 5; ++i)
+		REQUIRE (file.append ("some text"));
+
+	{
+		std::unique_lock lock { watcher.mutex };
+
+		REQUIRE (watcher.batchReceived.wait_for (lock, std::chrono::seconds (5), [&]
+												 { return ! watcher.batches.empty(); }));
+	}
+
+	// give a second batch a chance to arrive, if the events were not coalesced
+	std::this_thread::sleep_for (std::chrono::milliseconds (300));
+
+	watcher.stop();
+
+	REQUIRE (watcher.batches.size() == 1);
+
+	const auto& changes = watcher.batches.front();
+
+	REQUIRE (changes.size() == 1);
+
+	REQUIRE (changes.front().file == file);
+	REQUIRE ((changes.front().events & lf::FileWatcher::Modified) != 0);
+	REQUIRE ((changes.front().events & lf::FileWatcher::Opened) != 0);
+
+	REQUIRE (dir.deleteIfExists());
+}
+
+#endif
+
+#ifdef __linux__
+
+TEST_CASE ("FileWatcher - overflow", "[core][files][watcher]")
+{
+	namespace lf = limes::files;
+
+	// holds up the shared background thread inside a callback, so that the kernel's queue fills up
+	struct BlockingWatcher final : public lf::FileWatcher
+	{
+		explicit BlockingWatcher (const lf::Directory& dir)
+		{
+			start (dir);
+		}
+
+		~BlockingWatcher() final
+		{
+			stop();
+		}
+
+		void fileCreated (const lf::FilesystemEntry&) final
+		{
+			std::unique_lock lock { mutex };
+
+			blocking = true;
+			stateChanged.notify_all();
+
+			stateChanged.wait (lock, [this]
+							   { return released; });
+		}
+
+		std::mutex				mutex;
+		std::condition_variable stateChanged;
+		bool					blocking { false }, released { false };
+	};
+
+	struct OverflowWatcher final : public lf::FileWatcher
+	{
+		explicit OverflowWatcher (const lf::Directory& dir)
+		{
+			// the snapshot is what allows the dropped events to be recovered
+			start (dir, Options { .maxSnapshotEntries = 100'000 });
+		}
+
+		~OverflowWatcher() final
+		{
+			stop();
+		}
+
+		void eventsLost() final
+		{
+			const std::lock_guard lock { mutex };
+			lost = true;
+		}
+
+		void fileCreated (const lf::FilesystemEntry& entry) final
+		{
+			{
+				const std::lock_guard lock { mutex };
+				created.insert (entry.getName());
+			}
+
+			stateChanged.notify_all();
+		}
+
+		std::mutex				mutex;
+		std::condition_variable stateChanged;
+		bool					lost { false };
+		std::set<std::string>	created;
+	};
+
+	std::size_t maxQueuedEvents = 16384;
+
+	if (std::ifstream stream { "/proc/sys/fs/inotify/max_queued_events" })
+		stream >> maxQueuedEvents;
+
+	const auto blockingDir = lf::dirs::cwd().getChildDirectory ("watcher_overflow_blocking");
+	const auto dir		   = lf::dirs::cwd().getChildDirectory ("watcher_overflow_test");
+
+	blockingDir.deleteIfExists();
+	dir.deleteIfExists();
+
+	REQUIRE (blockingDir.createIfDoesntExist());
+	REQUIRE (dir.createIfDoesntExist());
+
+	BlockingWatcher blocker { blockingDir };
+	OverflowWatcher watcher { dir };
+
+	REQUIRE (blockingDir.getChildFile ("block.txt").createIfDoesntExist());
+
+	{
+		std::unique_lock lock { blocker.mutex };
+
+		REQUIRE (blocker.stateChanged.wait_for (lock, std::chrono::seconds (5), [&]
+												{ return blocker.blocking; }));
+	}
+
+	const auto numFiles = maxQueuedEvents + 100;
+
+	for (auto i = 0UL; i < numFiles; ++i)
+		REQUIRE (dir.getChildFile ("file_" + std::to_string (i) + ".txt").createIfDoesntExist());
+
+	{
+		const std::lock_guard lock { blocker.mutex };
+		blocker.released = true;
+	}
+
+	blocker.stateChanged.notify_all();
+
+	{
+		std::unique_lock lock { watcher.mutex };
+
+		// the rescan reports the files whose events were dropped
+		REQUIRE (watcher.stateChanged.wait_for (lock, std::chrono::seconds (10), [&]
+												{ return watcher.created.size() == numFiles; }));
+
+		REQUIRE (watcher.lost);
+	}
+
+	watcher.stop();
+	blocker.stop();
+
+	REQUIRE (dir.deleteIfExists());
+	REQUIRE (blockingDir.deleteIfExists());
+}
+
+#endif
+
+TEST_CASE ("FileWatcher - polling", "[core][files][watcher]")
+{
+	namespace lf = limes::files;
+
+	struct PollingWatcher final : public lf::FileWatcher
+	{
+		explicit PollingWatcher (const lf::Directory& dir)
+		{
+			start (dir, Options { .recursive	= true,
+								  .backend		= Backend::Polling,
+								  .pollInterval = std::chrono::milliseconds { 20 } });
+		}
+
+		~PollingWatcher() final
+		{
+			stop();
+		}
+
+		void fileCreated (const lf::FilesystemEntry& entry) final
+		{
+			record (Created, entry);
+		}
+
+		void fileModified (const lf::FilesystemEntry& entry) final
+		{
+			record (Modified, entry);
+		}
+
+		void fileDeleted (const lf::FilesystemEntry& entry) final
+		{
+			record (Deleted, entry);
+		}
+
+		void record (EventType type, const lf::FilesystemEntry& entry)
+		{
+			{
+				const std::lock_guard lock { mutex };
+				events.emplace_back (type, entry.getAbsolutePath());
+			}
+
+			eventReceived.notify_all();
+		}
+
+		bool waitFor (EventType type, const lf::FilesystemEntry& entry)
+		{
+			std::unique_lock lock { mutex };
+
+			return eventReceived.wait_for (lock, std::chrono::seconds (5), [&]
+										   { return std::find (events.begin(), events.end(),
+															   std::make_pair (type, entry.getAbsolutePath()))
+												 != events.end(); });
+		}
+
+		std::mutex										mutex;
+		std::condition_variable							eventReceived;
+		std::vector<std::pair<EventType, lf::Path>>		events;
+	};
+
+	const auto dir = lf::dirs::cwd().getChildDirectory ("watcher_polling_test");
+
+	dir.deleteIfExists();
+
+	const auto subdir = dir.getChildDirectory ("subdir");
+
+	REQUIRE (subdir.createIfDoesntExist());
+
+	PollingWatcher watcher { dir };
+
+	REQUIRE (watcher.isRunning());
+	REQUIRE (watcher.getOptions().backend == lf::FileWatcher::Backend::Polling);
+
+	const auto file = subdir.getChildFile ("file.txt");
+
+	REQUIRE (file.createIfDoesntExist());
+
+	REQUIRE (watcher.waitFor (lf::FileWatcher::Created, file));
+
+	REQUIRE (file.append ("some text"));
+
+	REQUIRE (watcher.waitFor (lf::FileWatcher::Modified, file));
+
+	REQUIRE (file.deleteIfExists());
+
+	REQUIRE (watcher.waitFor (lf::FileWatcher::Deleted, file));
+
+	watcher.stop();
+
+	REQUIRE (! watcher.isRunning());
+
+	REQUIRE (dir.deleteIfExists());
+}
+
+TEST_CASE ("FileWatcher - event queue", "[core][files][watcher]")
+{
+	namespace lf = limes::files;
+
+	struct QueueWatcher final : public lf::FileWatcher
+	{
+		explicit QueueWatcher (const lf::Directory& dir)
+		{
+			start (dir, Options { .queueCapacity = 4 });
+		}
+
+		~QueueWatcher() final
+		{
+			stop();
+		}
+
+		void fileCreated (const lf::FilesystemEntry&) final
+		{
+			threads.insert (std::this_thread::get_id());
+			++numCreated;
+		}
+
+		void eventsLost() final
+		{
+			threads.insert (std::this_thread::get_id());
+			lost = true;
+		}
+
+		// only accessed from the thread that delivers the queued events
+		std::set<std::thread::id> threads;
+		int						  numCreated { 0 };
+		bool					  lost { false };
+	};
+
+	const auto dir = lf::dirs::cwd().getChildDirectory ("watcher_queue_test");
+
+	dir.deleteIfExists();
+
+	REQUIRE (dir.createIfDoesntExist());
+
+	QueueWatcher watcher { dir };
+
+	REQUIRE (watcher.deliverQueuedEvents() == 0);
+
+	for (auto i = 0; i < 20; ++i)
+		REQUIRE (dir.getChildFile ("file_" + std::to_string (i) + ".txt").createIfDoesntExist());
+
+	// nothing is delivered until the queue is drained, so the events that don't fit are dropped
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds (5);
+
+	while (watcher.getNumDroppedEvents() == 0 && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for (std::chrono::milliseconds (10));
+
+	REQUIRE (watcher.getNumDroppedEvents() > 0);
+
+	REQUIRE (watcher.threads.empty());
+
+	REQUIRE (watcher.deliverQueuedEvents (2) == 2);
+
+	REQUIRE (watcher.lost);
+
+	REQUIRE (watcher.deliverQueuedEvents() >= 2);
+
+	REQUIRE (watcher.numCreated > 0);
+
+	REQUIRE (watcher.threads.size() == 1);
+	REQUIRE (watcher.threads.contains (std::this_thread::get_id()));
+
+	watcher.stop();
+
+	REQUIRE (dir.deleteIfExists());
+}
+
+TEST_CASE ("FileWatcher - compact events", "[core][files][watcher]")
+{
+	namespace lf = limes::files;
+
+	struct CompactWatcher final : public lf::FileWatcher
+	{
+		explicit CompactWatcher (const lf::Directory& dir)
+		{
+			start (dir, Options { .compactEvents = true });
+		}
+
+		~CompactWatcher() final
+		{
+			stop();
+		}
+
+		struct Record final
+		{
+			lf::Path	  path, oldPath;
+			std::uint32_t events;
+		};
+
+		void eventReceived (const Event& event) final
+		{
+			{
+				const std::lock_guard lock { mutex };
+				records.push_back ({ event.getPath(), event.getOldPath(), event.events });
+			}
+
+			recordAdded.notify_all();
+		}
+
+		// the legacy callbacks aren't used with compact events
+		void fileCreated (const lf::FilesystemEntry&) final
+		{
+			legacyCallbackMade = true;
+		}
+
+		bool waitFor (const std::function<bool (const Record&)>& predicate)
+		{
+			std::unique_lock lock { mutex };
+
+			return recordAdded.wait_for (lock, std::chrono::seconds (5), [&]
+										 { return std::any_of (records.begin(), records.end(), predicate); });
+		}
+
+		std::mutex				mutex;
+		std::condition_variable recordAdded;
+		std::vector<Record>		records;
+		bool					legacyCallbackMade { false };
+	};
+
+	const auto dir = lf::dirs::cwd().getChildDirectory ("watcher_compact_test");
+
+	dir.deleteIfExists();
+
+	REQUIRE (dir.createIfDoesntExist());
+
+	CompactWatcher watcher { dir };
+
+	const auto file = dir.getChildFile ("file.txt");
+
+	REQUIRE (file.createIfDoesntExist());
+
+	REQUIRE (watcher.waitFor ([&file] (const auto& record)
+							  { return record.path == file.getAbsolutePath() && (record.events & lf::FileWatcher::Created) != 0; }));
+
+#ifdef __linux__
+	const auto renamed = dir.getChildFile ("renamed.txt");
+
+	REQUIRE (std::filesystem::exists (file.getAbsolutePath()));
+
+	std::filesystem::rename (file.getAbsolutePath(), renamed.getAbsolutePath());
+
+	// both halves of the rename arrive as one event
+	REQUIRE (watcher.waitFor ([&] (const auto& record)
+							  { return record.path == renamed.getAbsolutePath()
+									&& record.oldPath == file.getAbsolutePath()
+									&& record.events == lf::FileWatcher::Moved; }));
+
+	watcher.stop();
+
+	const auto numMoves = std::count_if (watcher.records.begin(), watcher.records.end(), [] (const auto& record)
+										 { return (record.events & lf::FileWatcher::Moved) != 0; });
+
+	REQUIRE (numMoves == 1);
+#endif
+
+	watcher.stop();
+
+	REQUIRE (! watcher.legacyCallbackMade);
+
+	REQUIRE (dir.deleteIfExists());
+}
@@ -13,6 +13,11 @@
  */
 
 #include <lfilesystem/lfilesystem.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
 #include <catch2/catch_test_macros.hpp>
 
 #define TAGS "[core][files][FilesystemEntry]"
@@ -456,4 +461,99 @@ TEST_CASE ("FilesystemEntry - siblings", TAGS)
 	}
 }
 
+TEST_CASE ("FilesystemEntry - recursive delete", TAGS)
+{
+	const auto root = dirs::cwd().getChildDirectory ("recursive_delete_test");
+
+	root.deleteIfExists();
+
+	// one file and one directory per directory at each level, plus the root itself
+	std::uintmax_t numEntries { 1 };
+
+	const auto createTree = [&numEntries] (const auto& createChildren, const files::Directory& dir, int depth) -> void
+	{
+		for (auto i = 0; i < 4; ++i)
+		{
+			REQUIRE (dir.getChildFile ("file" + std::to_string (i)).createIfDoesntExist());
+			++numEntries;
+
+			if (depth == 0)
+				continue;
+
+			const auto subdir = dir.getChildDirectory ("dir" + std::to_string (i));
+
+			REQUIRE (subdir.createIfDoesntExist());
+			++numEntries;
+
+			createChildren (createChildren, subdir, depth - 1);
+		}
+	};
+
+	REQUIRE (root.createIfDoesntExist());
+
+	createTree (createTree, root, 3);
+
+	const auto outside = dirs::cwd().getChildFile ("recursive_delete_target.txt");
+
+	REQUIRE (outside.overwrite ("keep me"));
+
+#if ! (defined(_WIN32) || defined(WIN32))
+	// links are deleted, not followed
+	std::filesystem::create_symlink (outside.getAbsolutePath(), root.getChildFile ("link").getAbsolutePath());
+	++numEntries;
+#endif
+
+	const auto result = root.deleteRecursively (4);
+
+	REQUIRE (result.failures.empty());
+	REQUIRE (result.numRemoved == numEntries);
+	REQUIRE (! root.exists());
+
+	REQUIRE (outside.loadAsString() == "keep me");
+
+	// deleting something that doesn't exist isn't an error
+	{
+		const auto again = root.deleteRecursively();
+
+		REQUIRE (again.numRemoved == 0);
+		REQUIRE (again.failures.empty());
+	}
+
+	// a single file
+	{
+		const auto single = outside.deleteRecursively();
+
+		REQUIRE (single.numRemoved == 1);
+		REQUIRE (! outside.exists());
+	}
+
+	SECTION ("In the background")
+	{
+		REQUIRE (root.createIfDoesntExist());
+
+		createTree (createTree, root, 2);
+
+		REQUIRE (root.deleteInBackground());
+
+		// the path is free as soon as the function returns
+		REQUIRE (! root.exists());
+		REQUIRE (root.createIfDoesntExist());
+
+		const auto parent = root.getParentDirectory();
+
+		const auto hasTombstone = [&parent]
+		{
+			return std::ranges::any_of (parent.getAllChildren (false), [] (const files::FilesystemEntry& entry)
+										{ return entry.getName().starts_with (".recursive_delete_test.deleting."); });
+		};
+
+		for (auto i = 0; i < 1000 && hasTombstone(); ++i)
+			std::this_thread::sleep_for (std::chrono::milliseconds (10));
+
+		REQUIRE (! hasTombstone());
+
+		REQUIRE (root.deleteIfExists());
+	}
+}
+
 #undef TAGS
@@ -0,0 +1,88 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+#include <lfilesystem/lfilesystem.h>
+#include <utility>
+#include <catch2/catch_test_macros.hpp>
+
+#define TAGS "[core][files][mmap]"
+
+namespace files = limes::files;
+using files::MemoryMappedFile;
+
+TEST_CASE ("MemoryMappedFile - null", TAGS)
+{
+	MemoryMappedFile m;
+
+	REQUIRE (! m.isOpen());
+	REQUIRE (! m.isMemoryMapped());
+	REQUIRE (m.empty());
+	REQUIRE (m.getBytes().empty());
+	REQUIRE (m.getPath().empty());
+	REQUIRE (! m.advise (MemoryMappedFile::AccessPattern::Sequential));
+
+	REQUIRE (! m.open (files::dirs::cwd().getChildFile ("cuwnncncffeohglgreg.txt").getAbsolutePath()));
+	REQUIRE (! m.isOpen());
+}
+
+TEST_CASE ("MemoryMappedFile", TAGS)
+{
+	const auto file = files::dirs::cwd().getChildFile ("mmap_test.txt");
+
+	static constexpr auto content = "Good morning world, and all who inhabit it!";
+
+	REQUIRE (file.overwrite (content));
+
+	MemoryMappedFile m { file.getAbsolutePath(), MemoryMappedFile::AccessPattern::Sequential };
+
+	REQUIRE (m.isOpen());
+	REQUIRE (m.isMemoryMapped());
+	REQUIRE (m.getPath() == file.getAbsolutePath());
+	REQUIRE (m.size() == file.sizeInBytes());
+	REQUIRE (m.getString() == content);
+	REQUIRE (m.advise (MemoryMappedFile::AccessPattern::Random));
+
+	const auto moved = std::move (m);
+
+	REQUIRE (! m.isOpen());	 // NOLINT
+	REQUIRE (moved.isOpen());
+	REQUIRE (moved.getString() == content);
+
+	REQUIRE (file.overwrite (""));
+	REQUIRE (file.createIfDoesntExist());
+
+	{
+		const MemoryMappedFile emptyFile { file.getAbsolutePath() };
+
+		REQUIRE (emptyFile.isOpen());
+		REQUIRE (emptyFile.empty());
+	}
+
+	file.deleteIfExists();
+}
+
+#if ! (defined(_WIN32) || defined(WIN32) || defined(__APPLE__) || defined(__EMSCRIPTEN__))
+TEST_CASE ("MemoryMappedFile - unmappable files", TAGS)
+{
+	// files in /proc report a size of 0, so their content must be read
+	const MemoryMappedFile m { "/proc/self/status" };
+
+	REQUIRE (m.isOpen());
+	REQUIRE (! m.isMemoryMapped());
+	REQUIRE (! m.empty());
+	REQUIRE (m.getString().starts_with ("Name:"));
+}
+#endif
+
+#undef TAGS
@@ -0,0 +1,161 @@
+/*
+ * ======================================================================================
+ *  __    ____  __  __  ____  ___
+ * (  )  (_  _)(  \/  )( ___)/ __)
+ *  )(__  _)(_  )    (  )__) \__ \
+ * (____)(____)(_/\/\_)(____)(___/
+ *
+ *  This file is part of the Limes open source library and is licensed under the terms of the GNU Public License.
+ *
+ *  Commercial licenses are available; contact the maintainers at ben.the.vining@gmail.com to inquire for details.
+ *
+ * ======================================================================================
+ */
+
+
+#include <lfilesystem/lfilesystem.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+
+namespace lf = limes::files;
+
+// records the creation of files below a directory, ignoring the events for the rest of the volume
+struct CreationRecorder final
+{
+	void record (const lf::FilesystemEntry& entry)
+	{
+		{
+			const std::lock_guard lock { mutex };
+			created.insert (entry.getAbsolutePath());
+		}
+
+		eventReceived.notify_all();
+	}
+
+	bool waitFor (const lf::FilesystemEntry& entry)
+	{
+		std::unique_lock lock { mutex };
+
+		return eventReceived.wait_for (lock, std::chrono::seconds (5), [&]
+									   { return created.contains (entry.getAbsolutePath()); });
+	}
+
+	std::mutex				mutex;
+	std::condition_variable eventReceived;
+	std::set<lf::Path>		created;
+};
+
+struct VolumeWideWatcher final : public lf::FileWatcher
+{
+	explicit VolumeWideWatcher (const lf::Directory& dir)
+	{
+		start (dir, Options { .recursive = true, .backend = Backend::VolumeWide });
+	}
+
+	~VolumeWideWatcher() final
+	{
+		stop();
+	}
+
+	void fileCreated (const lf::FilesystemEntry& entry) final
+	{
+		recorder.record (entry);
+	}
+
+	CreationRecorder recorder;
+};
+
+struct TestMountWatcher final : public lf::MountWatcher
+{
+	explicit TestMountWatcher (const lf::Volume& volume)
+	{
+		start (volume);
+	}
+
+	~TestMountWatcher() final
+	{
+		stop();
+	}
+
+	void fileCreated (const lf::FilesystemEntry& entry) final
+	{
+		recorder.record (entry);
+	}
+
+	CreationRecorder recorder;
+};
+
+}  // namespace
+
+TEST_CASE ("MountWatcher", "[core][files][watcher]")
+{
+	const auto dir = lf::dirs::cwd().getChildDirectory ("mount_watcher_test");
+
+	dir.deleteIfExists();
+
+	const auto subdir = dir.getChildDirectory ("a").getChildDirectory ("b");
+
+	REQUIRE (subdir.createIfDoesntExist());
+
+	SECTION ("Volume-wide backend")
+	{
+		VolumeWideWatcher watcher { dir };
+
+		REQUIRE (watcher.isRunning());
+
+		// without the required privileges, this falls back to the native backend
+		if (watcher.getBackend() != lf::FileWatcher::Backend::VolumeWide)
+			REQUIRE (watcher.getBackend() == lf::FileWatcher::Backend::Native);
+
+		const auto file = subdir.getChildFile ("file.txt");
+
+		REQUIRE (file.createIfDoesntExist());
+
+		REQUIRE (watcher.recorder.waitFor (file));
+
+		// events outside the watched tree are filtered out
+		const auto outside = lf::dirs::cwd().getChildFile ("mount_watcher_outside.txt");
+
+		REQUIRE (outside.createIfDoesntExist());
+		REQUIRE (outside.deleteIfExists());
+
+		watcher.stop();
+
+		const std::lock_guard lock { watcher.recorder.mutex };
+
+		REQUIRE (! watcher.recorder.created.contains (outside.getAbsolutePath()));
+	}
+
+	// a fallback to a recursive watch of the whole volume would be too slow for a test
+	SECTION ("Whole volume")
+	{
+		const VolumeWideWatcher probe { dir };
+
+		if (probe.getBackend() == lf::FileWatcher::Backend::VolumeWide)
+		{
+			const lf::Volume volume { dir.getAbsolutePath() };
+
+			TestMountWatcher watcher { volume };
+
+			REQUIRE (watcher.isRunning());
+			REQUIRE (watcher.getBackend() == lf::FileWatcher::Backend::VolumeWide);
+
+			REQUIRE (watcher.getVolume().has_value());
+			REQUIRE (*watcher.getVolume() == volume);
+
+			const auto file = subdir.getChildFile ("volume_file.txt");
+
+			REQUIRE (file.createIfDoesntExist());
+
+			REQUIRE (watcher.recorder.waitFor (file));
+		}
+	}
+
+	REQUIRE (dir.deleteIfExists());
+}